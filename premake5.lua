@@ -32,6 +32,9 @@ project "VulkanHelloTriangle"
     {
         "src/**.hpp",
         "src/**.cpp",
+        "shaders/*.vert",
+        "shaders/*.frag",
+        "shaders/*.comp"
     }
 
     externalincludedirs
@@ -54,6 +57,19 @@ project "VulkanHelloTriangle"
         "glfw3"
     }
 
+    -- Every shader is compiled to the .spv next to it whenever its GLSL changes, so the binaries the app loads at runtime always
+    -- match the sources. shaders/compile.bat does the same by hand.
+    filter "files:shaders/*.vert or shaders/*.frag or shaders/*.comp"
+        buildmessage "Compiling %{file.relpath}"
+        buildcommands
+        {
+            '"%{VULKAN_SDK}/Bin/glslc" "%{file.abspath}" -o "%{file.abspath}.spv"'
+        }
+        buildoutputs
+        {
+            "%{file.abspath}.spv"
+        }
+
     filter "system:windows"
         systemversion "latest"
 
@@ -2,4 +2,8 @@ glslc shader.vert -o shader.vert.spv
 glslc shader.frag -o shader.frag.spv
 
 glslc fullscreen_quad.vert -o fullscreen_quad.vert.spv
-glslc fullscreen_quad.frag -o fullscreen_quad.frag.spv
\ No newline at end of file
+glslc fullscreen_quad.frag -o fullscreen_quad.frag.spv
+
+glslc postprocess.comp -o postprocess.comp.spv
+glslc cull.comp -o cull.comp.spv
+glslc depth_pyramid.comp -o depth_pyramid.comp.spv
\ No newline at end of file
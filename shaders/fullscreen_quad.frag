@@ -5,7 +5,15 @@ layout (location = 0) out vec4 outFragColor;
 
 layout(set = 0, binding = 0) uniform sampler2D tex;
 
+// The scene covers the top left uvScale of the image. Lookups stop half a texel inside it, so filtering never reaches the stale
+// texels beyond.
+layout(push_constant) uniform SourceRegion
+{
+    vec2 uvScale;
+    vec2 uvMax;
+} region;
+
 void main()
 {
-    outFragColor = vec4(texture(tex, inTexCoord).xyz, 1.0);
-}
\ No newline at end of file
+    outFragColor = vec4(texture(tex, min(inTexCoord * region.uvScale, region.uvMax)).xyz, 1.0);
+}
@@ -1,14 +1,25 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 fragTexCoord;
+layout (location = 2) in vec4 fragTint;
+layout (location = 3) flat in uint fragTextureIndex;
 
 layout (location = 0) out vec4 outColor;
 
-layout (binding = 1) uniform sampler2D texSampler;
+// Global bindless array, see BindlessDescriptors
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+// Per draw, must match DrawConstants
+layout (push_constant) uniform DrawConstants {
+    mat4 model;
+    uint textureBase;
+} draw;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
+    // Instances in one draw can pick different textures, so the index is not dynamically uniform
+    outColor = texture(textures[nonuniformEXT(draw.textureBase + fragTextureIndex)], fragTexCoord) * fragTint;
     //outColor = vec4(fragTexCoord, 0.0, 1.0);
 }
@@ -1,22 +1,47 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout (binding = 0) uniform UniformBufferObject
+layout (binding = 0) uniform FrameUniforms
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
-} ubo;
+    mat4 viewProj;
+    vec4 cameraPosition;
+    mat4 previousViewProj;
+} frame;
+
+// Per draw, must match DrawConstants
+layout (push_constant) uniform DrawConstants
+{
+    mat4 model;
+    uint textureBase;
+    vec4 positionScale;
+    vec4 positionOffset;
+} draw;
 
-layout (location = 0) in vec2 inPosition;
+layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inColor;
 layout (location = 2) in vec2 inTexCoord;
 
+// Per instance
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceTint;
+layout (location = 8) in uint inInstanceTextureIndex;
+
 layout (location = 0) out vec3 fragColor;
 layout (location = 1) out vec2 fragTexCoord;
+layout (location = 2) out vec4 fragTint;
+layout (location = 3) flat out uint fragTextureIndex;
+
+// The depth pre-pass runs this shader in another pipeline, and the colour pass tests for equal depth against what it wrote
+invariant gl_Position;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+    // Identity unless the vertex format stores positions normalised to the mesh bounds
+    vec3 position = inPosition * draw.positionScale.xyz + draw.positionOffset.xyz;
+    gl_Position = frame.viewProj * draw.model * inInstanceModel * vec4(position, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    fragTint = inInstanceTint;
+    fragTextureIndex = inInstanceTextureIndex;
 }
@@ -0,0 +1,338 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "AppConfig.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    auto parse_uint(const std::string& name, const std::string& value, uint32_t minValue, uint32_t maxValue) -> uint32_t
+    {
+        size_t end = 0;
+        unsigned long result = 0;
+        try
+        {
+            result = std::stoul(value, &end);
+        }
+        catch (const std::exception&)
+        {
+            end = 0;
+        }
+
+        if (value.empty() || end != value.size() || result < minValue || result > maxValue)
+        {
+            throw std::runtime_error("Invalid value '" + value + "' for " + name + " (expected " + std::to_string(minValue) + "-" +
+                                     std::to_string(maxValue) + ")");
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
+    auto parse_double(const std::string& name, const std::string& value, double minValue, double maxValue) -> double
+    {
+        size_t end = 0;
+        double result = 0.0;
+        try
+        {
+            result = std::stod(value, &end);
+        }
+        catch (const std::exception&)
+        {
+            end = 0;
+        }
+
+        if (value.empty() || end != value.size() || !(result >= minValue && result <= maxValue))
+        {
+            throw std::runtime_error("Invalid value '" + value + "' for " + name + " (expected " + std::to_string(minValue) + "-" +
+                                     std::to_string(maxValue) + ")");
+        }
+
+        return result;
+    }
+
+    auto parse_bool(const std::string& name, const std::string& value) -> bool
+    {
+        if (value == "on" || value == "true" || value == "1")
+        {
+            return true;
+        }
+        if (value == "off" || value == "false" || value == "0")
+        {
+            return false;
+        }
+
+        throw std::runtime_error("Invalid value '" + value + "' for " + name + " (expected on or off)");
+    }
+
+    auto parse_present_mode(const std::string& value) -> PresentModePreference
+    {
+        if (value == "auto")
+        {
+            return PresentModePreference::Auto;
+        }
+        if (value == "immediate")
+        {
+            return PresentModePreference::Immediate;
+        }
+        if (value == "mailbox")
+        {
+            return PresentModePreference::Mailbox;
+        }
+        if (value == "fifo")
+        {
+            return PresentModePreference::Fifo;
+        }
+        if (value == "fifo-relaxed")
+        {
+            return PresentModePreference::FifoRelaxed;
+        }
+
+        throw std::runtime_error("Invalid present mode '" + value + "'");
+    }
+
+    auto parse_vertex_format(const std::string& value) -> VertexFormatPreference
+    {
+        if (value == "float")
+        {
+            return VertexFormatPreference::Float;
+        }
+        if (value == "half")
+        {
+            return VertexFormatPreference::Half;
+        }
+        if (value == "compact")
+        {
+            return VertexFormatPreference::Compact;
+        }
+
+        throw std::runtime_error("Invalid vertex format '" + value + "'");
+    }
+
+    /* Applies a single option, shared by the command line and environment parsing */
+    void apply_option(AppConfig& config, const std::string& option, const std::string& value)
+    {
+        if (option == "frames-in-flight")
+        {
+            config.framesInFlight = parse_uint(option, value, 1, 8);
+        }
+        else if (option == "swapchain-images")
+        {
+            config.swapchainImageCount = parse_uint(option, value, 0, 16);
+        }
+        else if (option == "present-mode")
+        {
+            config.presentMode = parse_present_mode(value);
+        }
+        else if (option == "benchmark")
+        {
+            config.benchmarkFrames = parse_uint(option, value, 1, UINT32_MAX);
+        }
+        else if (option == "record-threads")
+        {
+            config.recordThreads = parse_uint(option, value, 0, 64);
+        }
+        else if (option == "draws")
+        {
+            config.drawCount = parse_uint(option, value, 1, 1000000);
+        }
+        else if (option == "instancing")
+        {
+            config.instancing = parse_bool(option, value);
+        }
+        else if (option == "gpu-culling")
+        {
+            config.gpuCulling = parse_bool(option, value);
+        }
+        else if (option == "meshlets")
+        {
+            config.meshlets = parse_bool(option, value);
+        }
+        else if (option == "occlusion")
+        {
+            config.occlusion = parse_bool(option, value);
+        }
+        else if (option == "depth-prepass")
+        {
+            config.depthPrepass = parse_bool(option, value);
+        }
+        else if (option == "textures")
+        {
+            config.textureCount = parse_uint(option, value, 0, 16384);
+        }
+        else if (option == "command-cache")
+        {
+            config.commandCache = parse_bool(option, value);
+        }
+        else if (option == "low-latency")
+        {
+            config.lowLatency = parse_bool(option, value);
+        }
+        else if (option == "pipelined")
+        {
+            config.pipelined = parse_bool(option, value);
+        }
+        else if (option == "async-compute")
+        {
+            config.asyncCompute = parse_bool(option, value);
+        }
+        else if (option == "post-process")
+        {
+            config.postProcess = parse_bool(option, value);
+        }
+        else if (option == "dynamic-resolution")
+        {
+            config.dynamicResolutionMs = parse_double(option, value, 0.0, 1000.0);
+        }
+        else if (option == "vertex-format")
+        {
+            config.vertexFormat = parse_vertex_format(value);
+        }
+        else if (option == "scene")
+        {
+            config.scenePath = value;
+        }
+        else if (option == "mesh-optimizer")
+        {
+            config.meshOptimizer = parse_bool(option, value);
+        }
+        else if (option == "lod")
+        {
+            config.lod = parse_bool(option, value);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option '--" + option + "'\n" + AppConfig::usage());
+        }
+    }
+}
+
+auto AppConfig::parse(int argc, char** argv) -> AppConfig
+{
+    AppConfig config{};
+
+    const std::pair<const char*, const char*> environmentOptions[] = {
+        { "HT_FRAMES_IN_FLIGHT", "frames-in-flight" },
+        { "HT_SWAPCHAIN_IMAGES", "swapchain-images" },
+        { "HT_PRESENT_MODE", "present-mode" },
+        { "HT_BENCHMARK_FRAMES", "benchmark" },
+        { "HT_RECORD_THREADS", "record-threads" },
+        { "HT_DRAWS", "draws" },
+        { "HT_INSTANCING", "instancing" },
+        { "HT_GPU_CULLING", "gpu-culling" },
+        { "HT_MESHLETS", "meshlets" },
+        { "HT_OCCLUSION", "occlusion" },
+        { "HT_DEPTH_PREPASS", "depth-prepass" },
+        { "HT_TEXTURES", "textures" },
+        { "HT_COMMAND_CACHE", "command-cache" },
+        { "HT_LOW_LATENCY", "low-latency" },
+        { "HT_PIPELINED", "pipelined" },
+        { "HT_ASYNC_COMPUTE", "async-compute" },
+        { "HT_POST_PROCESS", "post-process" },
+        { "HT_DYNAMIC_RESOLUTION", "dynamic-resolution" },
+        { "HT_VERTEX_FORMAT", "vertex-format" },
+        { "HT_SCENE", "scene" },
+        { "HT_MESH_OPTIMIZER", "mesh-optimizer" },
+        { "HT_LOD", "lod" },
+    };
+
+    for (const auto& [variable, option] : environmentOptions)
+    {
+        if (const char* value = std::getenv(variable))
+        {
+            apply_option(config, option, value);
+        }
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            throw std::runtime_error(usage());
+        }
+
+        if (arg.rfind("--", 0) != 0)
+        {
+            throw std::runtime_error("Unexpected argument '" + arg + "'\n" + usage());
+        }
+
+        std::string option = arg.substr(2);
+        std::string value;
+
+        // Accept both "--option value" and "--option=value"
+        size_t equals = option.find('=');
+        if (equals != std::string::npos)
+        {
+            value = option.substr(equals + 1);
+            option = option.substr(0, equals);
+        }
+        else if (i + 1 < argc)
+        {
+            value = argv[++i];
+        }
+        else
+        {
+            throw std::runtime_error("Missing value for '" + arg + "'");
+        }
+
+        apply_option(config, option, value);
+    }
+
+    return config;
+}
+
+auto AppConfig::usage() -> std::string
+{
+    return "Usage: VulkanHelloTriangle [options]\n"
+           "  --frames-in-flight <1-8>   (HT_FRAMES_IN_FLIGHT)\n"
+           "  --swapchain-images <0-16>  (HT_SWAPCHAIN_IMAGES, 0 = minImageCount + 1)\n"
+           "  --present-mode <mode>      (HT_PRESENT_MODE: auto, immediate, mailbox, fifo, fifo-relaxed)\n"
+           "  --benchmark <frames>       (HT_BENCHMARK_FRAMES)\n"
+           "  --record-threads <0-64>    (HT_RECORD_THREADS, 0 = one per core)\n"
+           "  --draws <1-1000000>        (HT_DRAWS)\n"
+           "  --instancing <on|off>      (HT_INSTANCING)\n"
+           "  --gpu-culling <on|off>     (HT_GPU_CULLING, needs multiDrawIndirect and drawIndirectCount)\n"
+           "  --meshlets <on|off>        (HT_MESHLETS, ignores --draws, culls on the GPU when supported)\n"
+           "  --occlusion <on|off>       (HT_OCCLUSION, only with GPU culling)\n"
+           "  --depth-prepass <on|off>   (HT_DEPTH_PREPASS)\n"
+           "  --textures <0-16384>       (HT_TEXTURES)\n"
+           "  --command-cache <on|off>   (HT_COMMAND_CACHE)\n"
+           "  --low-latency <on|off>     (HT_LOW_LATENCY, needs VK_KHR_present_id and VK_KHR_present_wait)\n"
+           "  --pipelined <on|off>       (HT_PIPELINED, ignored in low latency mode)\n"
+           "  --async-compute <on|off>   (HT_ASYNC_COMPUTE, needs a compute-only queue family)\n"
+           "  --post-process <on|off>    (HT_POST_PROCESS)\n"
+           "  --dynamic-resolution <ms>  (HT_DYNAMIC_RESOLUTION, GPU frame budget, 0 = off, needs post-processing)\n"
+           "  --vertex-format <format>   (HT_VERTEX_FORMAT: float, half, compact)\n"
+           "  --scene <file>             (HT_SCENE, glTF 2.0 .gltf or .glb, ignores --draws, --textures and --meshlets)\n"
+           "  --mesh-optimizer <on|off>  (HT_MESH_OPTIMIZER)\n"
+           "  --lod <on|off>             (HT_LOD, not applied to the meshlet sphere)";
+}
+
+auto to_string(PresentModePreference presentMode) -> std::string
+{
+    switch (presentMode)
+    {
+        case PresentModePreference::Auto: return "auto";
+        case PresentModePreference::Immediate: return "immediate";
+        case PresentModePreference::Mailbox: return "mailbox";
+        case PresentModePreference::Fifo: return "fifo";
+        case PresentModePreference::FifoRelaxed: return "fifo-relaxed";
+    }
+    return "unknown";
+}
+
+auto to_string(VertexFormatPreference vertexFormat) -> std::string
+{
+    switch (vertexFormat)
+    {
+        case VertexFormatPreference::Float: return "float";
+        case VertexFormatPreference::Half: return "half";
+        case VertexFormatPreference::Compact: return "compact";
+    }
+    return "unknown";
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class PresentModePreference
+{
+    Auto,
+    Immediate,
+    Mailbox,
+    Fifo,
+    FifoRelaxed,
+};
+
+/* Vertex buffer layouts: full floats, halves, or normalised integers with colours in 8 bits */
+enum class VertexFormatPreference
+{
+    Float,
+    Half,
+    Compact,
+};
+
+/*
+ * Launch-time settings. Every option can be given on the command line or through an HT_* environment variable, with the command
+ * line taking precedence.
+ *
+ *  --frames-in-flight <n>   HT_FRAMES_IN_FLIGHT   CPU frames that may be queued ahead of the GPU
+ *  --swapchain-images <n>   HT_SWAPCHAIN_IMAGES   Requested swapchain image count (0 = minImageCount + 1)
+ *  --present-mode <mode>    HT_PRESENT_MODE       auto | immediate | mailbox | fifo | fifo-relaxed
+ *  --benchmark <frames>     HT_BENCHMARK_FRAMES   Render a fixed number of frames, print statistics and exit
+ *  --record-threads <n>     HT_RECORD_THREADS     Threads recording secondary command buffers (0 = one per core)
+ *  --draws <n>              HT_DRAWS              Quads in the scene, one draw call each unless instanced
+ *  --instancing <on|off>    HT_INSTANCING         Draw every quad of the scene with a single instanced draw call
+ *  --gpu-culling <on|off>   HT_GPU_CULLING        Frustum cull on the GPU and draw the survivors with one indirect draw
+ *  --meshlets <on|off>      HT_MESHLETS           Replace the quads with a dense sphere split into meshlets, culled per cluster on the GPU
+ *  --occlusion <on|off>     HT_OCCLUSION          Also cull on the GPU against a depth pyramid, in two phases (needs GPU culling)
+ *  --depth-prepass <on|off> HT_DEPTH_PREPASS      Lay down scene depth first, so the colour pass only shades the visible surface
+ *  --textures <n>           HT_TEXTURES           Distinct generated textures spread over the quads (0 = the loaded texture only)
+ *  --command-cache <on|off> HT_COMMAND_CACHE      Reuse pre-recorded command buffers while nothing they reference changes
+ *  --low-latency <on|off>   HT_LOW_LATENCY        Throttle frame starts on present completion and latch input late
+ *  --pipelined <on|off>     HT_PIPELINED          Overlap simulation, recording and submission on separate threads
+ *  --async-compute <on|off> HT_ASYNC_COMPUTE      Run post-processing on a dedicated compute queue when the device has one
+ *  --post-process <on|off>  HT_POST_PROCESS       Run the post-processing chain, or render the scene straight into the swapchain
+ *  --dynamic-resolution <ms> HT_DYNAMIC_RESOLUTION GPU frame time budget the scene's render scale adapts to (0 = fixed resolution)
+ *  --vertex-format <format> HT_VERTEX_FORMAT      float (32 bytes) | half (16 bytes) | compact (16 bytes, snorm16 positions)
+ *  --scene <file>           HT_SCENE              glTF 2.0 scene (.gltf or .glb) drawn in place of the quads or the meshlet sphere
+ *  --mesh-optimizer <on|off> HT_MESH_OPTIMIZER    Deduplicate and reorder meshes for vertex cache, overdraw and fetch at load time
+ *  --lod <on|off>           HT_LOD                Simplify meshes into LOD chains and draw each object at its screen size's level
+ */
+struct AppConfig
+{
+    uint32_t framesInFlight = 2;
+    uint32_t swapchainImageCount = 0;
+    PresentModePreference presentMode = PresentModePreference::Auto;
+    uint32_t benchmarkFrames = 0;
+    uint32_t recordThreads = 0;
+    uint32_t drawCount = 1;
+    bool instancing = true;
+    bool gpuCulling = false;
+    bool meshlets = false;
+    bool occlusion = true;
+    bool depthPrepass = false;
+    uint32_t textureCount = 0;
+    bool commandCache = true;
+    bool lowLatency = false;
+    bool pipelined = false;
+    bool asyncCompute = true;
+    bool postProcess = true;
+    double dynamicResolutionMs = 0.0;
+    VertexFormatPreference vertexFormat = VertexFormatPreference::Float;
+    std::string scenePath;
+    bool meshOptimizer = false;
+    bool lod = false;
+
+    /* Throws std::runtime_error on malformed input */
+    static auto parse(int argc, char** argv) -> AppConfig;
+
+    static auto usage() -> std::string;
+};
+
+auto to_string(PresentModePreference presentMode) -> std::string;
+auto to_string(VertexFormatPreference vertexFormat) -> std::string;
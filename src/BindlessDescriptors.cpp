@@ -0,0 +1,125 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "BindlessDescriptors.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+void BindlessDescriptors::init(vk::Device device,
+                               const vk::PhysicalDeviceVulkan12Properties& properties,
+                               uint32_t maxTextures,
+                               uint32_t maxStorageBuffers)
+{
+    m_device = device;
+
+    // Combined image samplers count against both the sampled image and the sampler limits
+    m_maxTextures = std::min({ maxTextures,
+                               properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                               properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                               properties.maxDescriptorSetUpdateAfterBindSamplers,
+                               properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+    m_maxStorageBuffers = std::min({ maxStorageBuffers,
+                                     properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                     properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+    std::array<vk::DescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].setBinding(TEXTURE_BINDING);
+    bindings[0].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    bindings[0].setDescriptorCount(m_maxTextures);
+    bindings[0].setStageFlags(vk::ShaderStageFlagBits::eAll);
+
+    bindings[1].setBinding(STORAGE_BUFFER_BINDING);
+    bindings[1].setDescriptorType(vk::DescriptorType::eStorageBuffer);
+    bindings[1].setDescriptorCount(m_maxStorageBuffers);
+    bindings[1].setStageFlags(vk::ShaderStageFlagBits::eAll);
+
+    std::array<vk::DescriptorBindingFlags, 2> bindingFlags{};
+    bindingFlags.fill(vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind);
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.setBindingFlags(bindingFlags);
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.pNext = &bindingFlagsInfo;
+    layoutInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+    layoutInfo.setBindings(bindings);
+    m_layout = m_device.createDescriptorSetLayout(layoutInfo);
+
+    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eCombinedImageSampler;
+    poolSizes[0].descriptorCount = m_maxTextures;
+    poolSizes[1].type = vk::DescriptorType::eStorageBuffer;
+    poolSizes[1].descriptorCount = m_maxStorageBuffers;
+
+    vk::DescriptorPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+    poolInfo.setPoolSizes(poolSizes);
+    poolInfo.maxSets = 1;
+    m_pool = m_device.createDescriptorPool(poolInfo);
+
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.setDescriptorPool(m_pool);
+    allocInfo.setSetLayouts(m_layout);
+    m_set = m_device.allocateDescriptorSets(allocInfo)[0];
+}
+
+auto BindlessDescriptors::add_texture(vk::ImageView view, vk::Sampler sampler) -> uint32_t
+{
+    if (m_textureCount == m_maxTextures)
+    {
+        throw std::runtime_error("Bindless texture array is full!");
+    }
+
+    vk::DescriptorImageInfo imageInfo{};
+    imageInfo.setImageView(view);
+    imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    imageInfo.setSampler(sampler);
+
+    vk::WriteDescriptorSet write{};
+    write.setDstSet(m_set);
+    write.setDstBinding(TEXTURE_BINDING);
+    write.setDstArrayElement(m_textureCount);
+    write.setDescriptorCount(1);
+    write.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    write.setImageInfo(imageInfo);
+    m_device.updateDescriptorSets(write, {});
+
+    return m_textureCount++;
+}
+
+auto BindlessDescriptors::add_storage_buffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) -> uint32_t
+{
+    if (m_storageBufferCount == m_maxStorageBuffers)
+    {
+        throw std::runtime_error("Bindless storage buffer array is full!");
+    }
+
+    vk::DescriptorBufferInfo bufferInfo{};
+    bufferInfo.setBuffer(buffer);
+    bufferInfo.setOffset(offset);
+    bufferInfo.setRange(range);
+
+    vk::WriteDescriptorSet write{};
+    write.setDstSet(m_set);
+    write.setDstBinding(STORAGE_BUFFER_BINDING);
+    write.setDstArrayElement(m_storageBufferCount);
+    write.setDescriptorCount(1);
+    write.setDescriptorType(vk::DescriptorType::eStorageBuffer);
+    write.setBufferInfo(bufferInfo);
+    m_device.updateDescriptorSets(write, {});
+
+    return m_storageBufferCount++;
+}
+
+void BindlessDescriptors::destroy()
+{
+    m_device.destroy(m_pool);
+    m_device.destroy(m_layout);
+
+    m_pool = nullptr;
+    m_layout = nullptr;
+    m_set = nullptr;
+}
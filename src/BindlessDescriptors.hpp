@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+/*
+ * One global descriptor set holding every texture and storage buffer shaders may index. Both arrays are partially bound and
+ * update-after-bind: entries can be added while recorded command buffers still use the set, and slots nobody wrote are never
+ * read. Shaders get indices into the arrays through push constants or instance data instead of a descriptor set per material.
+ */
+class BindlessDescriptors
+{
+public:
+    static constexpr uint32_t TEXTURE_BINDING = 0;
+    static constexpr uint32_t STORAGE_BUFFER_BINDING = 1;
+
+    /* Capacities are clamped to the device's update-after-bind limits */
+    void init(vk::Device device, const vk::PhysicalDeviceVulkan12Properties& properties, uint32_t maxTextures, uint32_t maxStorageBuffers);
+
+    /* Returns the array index shaders sample the texture with. The view has to outlive the set. */
+    auto add_texture(vk::ImageView view, vk::Sampler sampler) -> uint32_t;
+    auto add_storage_buffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) -> uint32_t;
+
+    auto layout() const -> vk::DescriptorSetLayout
+    {
+        return m_layout;
+    }
+
+    auto set() const -> vk::DescriptorSet
+    {
+        return m_set;
+    }
+
+    auto texture_capacity() const -> uint32_t
+    {
+        return m_maxTextures;
+    }
+
+    auto texture_count() const -> uint32_t
+    {
+        return m_textureCount;
+    }
+
+    void destroy();
+
+private:
+    vk::Device m_device;
+    vk::DescriptorPool m_pool;
+    vk::DescriptorSetLayout m_layout;
+    vk::DescriptorSet m_set;
+
+    uint32_t m_maxTextures = 0;
+    uint32_t m_maxStorageBuffers = 0;
+    uint32_t m_textureCount = 0;
+    uint32_t m_storageBufferCount = 0;
+};
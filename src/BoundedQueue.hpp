@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+/*
+ * Blocking FIFO with a fixed capacity, used to hand frames between pipeline stages. A full queue stalls the producer, which is
+ * what keeps a fast stage from running arbitrarily far ahead of a slow one.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity) {}
+
+    /* Blocks while the queue is full. Returns false, dropping the item, once the queue has been closed. */
+    auto push(T item) -> bool
+    {
+        std::unique_lock lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+
+        if (m_closed)
+        {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        m_unfinished++;
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /* Blocks while the queue is empty. Returns nothing once the queue is closed and drained. */
+    auto pop() -> std::optional<T>
+    {
+        std::unique_lock lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    /* Called by the consumer once it has finished with a popped item */
+    void task_done()
+    {
+        std::lock_guard lock(m_mutex);
+        m_unfinished--;
+        if (m_unfinished == 0)
+        {
+            m_drained.notify_all();
+        }
+    }
+
+    /* Blocks until every item pushed so far has been popped and finished */
+    void wait_until_drained()
+    {
+        std::unique_lock lock(m_mutex);
+        m_drained.wait(lock, [this] { return m_unfinished == 0; });
+    }
+
+    /* Wakes every waiter. Remaining items can still be popped, further pushes fail. */
+    void close()
+    {
+        std::lock_guard lock(m_mutex);
+        m_closed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    size_t m_capacity;
+
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_drained;
+
+    std::deque<T> m_items;
+    size_t m_unfinished = 0;
+    bool m_closed = false;
+};
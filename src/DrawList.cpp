@@ -0,0 +1,221 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "DrawList.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t RADIX_BITS = 8;
+    constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+    constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+    /* Below this many items per chunk, waking another thread costs more than it saves */
+    constexpr uint32_t MIN_ITEMS_PER_CHUNK = 4096;
+
+    using Histogram = std::array<uint32_t, RADIX_BUCKETS>;
+
+    auto digit(uint64_t key, uint32_t pass) -> uint32_t
+    {
+        return static_cast<uint32_t>(key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1);
+    }
+}
+
+auto make_draw_key(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth) -> uint64_t
+{
+    if (pass >= (1u << DRAW_KEY_PASS_BITS) || pipeline >= (1u << DRAW_KEY_PIPELINE_BITS) || material >= (1u << DRAW_KEY_MATERIAL_BITS))
+    {
+        throw std::runtime_error("Draw key field out of range!");
+    }
+
+    return (static_cast<uint64_t>(pass) << (DRAW_KEY_PIPELINE_BITS + DRAW_KEY_MATERIAL_BITS + DRAW_KEY_DEPTH_BITS)) |
+           (static_cast<uint64_t>(pipeline) << (DRAW_KEY_MATERIAL_BITS + DRAW_KEY_DEPTH_BITS)) |
+           (static_cast<uint64_t>(material) << DRAW_KEY_DEPTH_BITS) | depth;
+}
+
+auto quantize_draw_depth(float distance, float nearPlane, float farPlane) -> uint32_t
+{
+    float normalized = std::clamp((distance - nearPlane) / (farPlane - nearPlane), 0.0f, 1.0f);
+    return static_cast<uint32_t>(std::llround(static_cast<double>(normalized) * UINT32_MAX));
+}
+
+void DrawList::sort(ThreadPool& pool)
+{
+    auto count = static_cast<uint32_t>(m_items.size());
+    if (count < 2)
+    {
+        return;
+    }
+
+    // Digit totals do not depend on the order, so one scan up front finds the passes that would leave the order unchanged
+    std::array<Histogram, RADIX_PASSES> totals{};
+    for (const DrawItem& item : m_items)
+    {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+        {
+            totals[pass][digit(item.key, pass)]++;
+        }
+    }
+
+    uint32_t chunkCount = std::clamp(count / MIN_ITEMS_PER_CHUNK, 1u, pool.thread_count());
+    std::vector<Histogram> histograms(chunkCount);
+    m_scratch.resize(count);
+
+    auto chunkBegin = [&](uint32_t chunk) { return static_cast<uint32_t>(static_cast<uint64_t>(count) * chunk / chunkCount); };
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        if (std::find(totals[pass].begin(), totals[pass].end(), count) != totals[pass].end())
+        {
+            continue;
+        }
+
+        pool.parallel_for(chunkCount, [&](uint32_t chunk, uint32_t) {
+            Histogram& histogram = histograms[chunk];
+            histogram.fill(0);
+            for (uint32_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+            {
+                histogram[digit(m_items[i].key, pass)]++;
+            }
+        });
+
+        // Exclusive prefix over (digit, chunk), so each chunk writes its items of a digit after those of earlier chunks and the
+        // sort stays stable
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; bucket++)
+        {
+            for (Histogram& histogram : histograms)
+            {
+                uint32_t bucketCount = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketCount;
+            }
+        }
+
+        pool.parallel_for(chunkCount, [&](uint32_t chunk, uint32_t) {
+            Histogram& next = histograms[chunk];
+            for (uint32_t i = chunkBegin(chunk); i < chunkBegin(chunk + 1); i++)
+            {
+                m_scratch[next[digit(m_items[i].key, pass)]++] = m_items[i];
+            }
+        });
+
+        m_items.swap(m_scratch);
+    }
+}
+
+auto StateChangeStats::operator+=(const StateChangeStats& other) -> StateChangeStats&
+{
+    pipelineBinds += other.pipelineBinds;
+    descriptorSetBinds += other.descriptorSetBinds;
+    vertexBufferBinds += other.vertexBufferBinds;
+    indexBufferBinds += other.indexBufferBinds;
+    pushConstantUpdates += other.pushConstantUpdates;
+    return *this;
+}
+
+auto CommandStateTracker::bind_point_index(vk::PipelineBindPoint bindPoint) -> uint32_t
+{
+    switch (bindPoint)
+    {
+        case vk::PipelineBindPoint::eGraphics: return 0;
+        case vk::PipelineBindPoint::eCompute: return 1;
+        default: throw std::runtime_error("Unsupported pipeline bind point!");
+    }
+}
+
+void CommandStateTracker::bind_pipeline(vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline)
+{
+    vk::Pipeline& bound = m_pipelines[bind_point_index(bindPoint)];
+    if (pipeline == bound)
+    {
+        return;
+    }
+
+    m_cmd.bindPipeline(bindPoint, pipeline);
+    bound = pipeline;
+    m_stats.pipelineBinds++;
+}
+
+void CommandStateTracker::bind_descriptor_set(vk::PipelineBindPoint bindPoint,
+                                              vk::PipelineLayout layout,
+                                              uint32_t set,
+                                              vk::DescriptorSet descriptorSet)
+{
+    if (set >= MAX_DESCRIPTOR_SETS)
+    {
+        throw std::runtime_error("Descriptor set index out of range!");
+    }
+
+    // A set bound through an incompatible layout may be disturbed, so only an identical layout counts as a match
+    uint32_t point = bind_point_index(bindPoint);
+    if (m_descriptorSets[point][set] == descriptorSet && m_setLayouts[point][set] == layout)
+    {
+        return;
+    }
+
+    m_cmd.bindDescriptorSets(bindPoint, layout, set, descriptorSet, {});
+    m_descriptorSets[point][set] = descriptorSet;
+    m_setLayouts[point][set] = layout;
+    m_stats.descriptorSetBinds++;
+}
+
+void CommandStateTracker::bind_vertex_buffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset)
+{
+    if (binding >= MAX_VERTEX_BINDINGS)
+    {
+        throw std::runtime_error("Vertex buffer binding out of range!");
+    }
+
+    if (m_vertexBuffers[binding] == buffer && m_vertexOffsets[binding] == offset)
+    {
+        return;
+    }
+
+    m_cmd.bindVertexBuffers(binding, buffer, offset);
+    m_vertexBuffers[binding] = buffer;
+    m_vertexOffsets[binding] = offset;
+    m_stats.vertexBufferBinds++;
+}
+
+void CommandStateTracker::bind_index_buffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType)
+{
+    if (m_indexBuffer == buffer && m_indexOffset == offset && m_indexType == indexType)
+    {
+        return;
+    }
+
+    m_cmd.bindIndexBuffer(buffer, offset, indexType);
+    m_indexBuffer = buffer;
+    m_indexOffset = offset;
+    m_indexType = indexType;
+    m_stats.indexBufferBinds++;
+}
+
+void CommandStateTracker::push_constants(
+    vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+    if (offset + size > MAX_PUSH_CONSTANT_BYTES)
+    {
+        throw std::runtime_error("Push constant range out of range!");
+    }
+
+    if (m_pushLayout == layout && m_pushStages == stages && m_pushOffset == offset && m_pushSize == size &&
+        std::memcmp(m_pushData.data() + offset, data, size) == 0)
+    {
+        return;
+    }
+
+    m_cmd.pushConstants(layout, stages, offset, size, data);
+    m_pushLayout = layout;
+    m_pushStages = stages;
+    m_pushOffset = offset;
+    m_pushSize = size;
+    std::memcpy(m_pushData.data() + offset, data, size);
+    m_stats.pushConstantUpdates++;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+ * 64 bit draw sort key, most significant field first:
+ *   pass (4 bits) | pipeline (8 bits) | material (20 bits) | depth (32 bits)
+ * Sorting by key groups draws by the state that is most expensive to change and orders them front to back within a material.
+ */
+constexpr uint32_t DRAW_KEY_PASS_BITS = 4;
+constexpr uint32_t DRAW_KEY_PIPELINE_BITS = 8;
+constexpr uint32_t DRAW_KEY_MATERIAL_BITS = 20;
+constexpr uint32_t DRAW_KEY_DEPTH_BITS = 32;
+
+auto make_draw_key(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth) -> uint64_t;
+
+/* Maps a view distance in [nearPlane, farPlane] onto the depth field, clamping outside the range */
+auto quantize_draw_depth(float distance, float nearPlane, float farPlane) -> uint32_t;
+
+struct DrawItem
+{
+    uint64_t key;
+    /* Index of the draw in the caller's scene data */
+    uint32_t draw;
+};
+
+/*
+ * Per frame list of draws, sorted by key before the commands are emitted. The sort is a stable LSD radix sort over 8 bit digits:
+ * every pass builds per-chunk histograms and scatters its chunk in parallel, and digits that are the same for every key are skipped.
+ */
+class DrawList
+{
+public:
+    void clear()
+    {
+        m_items.clear();
+    }
+
+    void add(uint64_t key, uint32_t draw)
+    {
+        m_items.push_back({ key, draw });
+    }
+
+    void sort(ThreadPool& pool);
+
+    auto items() const -> const std::vector<DrawItem>&
+    {
+        return m_items;
+    }
+
+    auto size() const -> uint32_t
+    {
+        return static_cast<uint32_t>(m_items.size());
+    }
+
+private:
+    std::vector<DrawItem> m_items;
+    std::vector<DrawItem> m_scratch;
+};
+
+struct StateChangeStats
+{
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint32_t pushConstantUpdates = 0;
+
+    auto total() const -> uint32_t
+    {
+        return pipelineBinds + descriptorSetBinds + vertexBufferBinds + indexBufferBinds + pushConstantUpdates;
+    }
+
+    auto operator+=(const StateChangeStats& other) -> StateChangeStats&;
+};
+
+/*
+ * Wraps the bind commands of one command buffer and drops the ones that would not change anything. Command buffers start without
+ * bound state, so a tracker must not outlive the buffer it was created for.
+ */
+class CommandStateTracker
+{
+public:
+    /* Graphics and compute, which keep separate pipeline and descriptor set bindings */
+    static constexpr uint32_t MAX_BIND_POINTS = 2;
+    static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+    static constexpr uint32_t MAX_PUSH_CONSTANT_BYTES = 128;
+
+    explicit CommandStateTracker(vk::CommandBuffer cmd) : m_cmd(cmd) {}
+
+    void bind_pipeline(vk::PipelineBindPoint bindPoint, vk::Pipeline pipeline);
+    void bind_descriptor_set(vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t set, vk::DescriptorSet descriptorSet);
+    void bind_vertex_buffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset = 0);
+    void bind_index_buffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType);
+
+    /* Compared against the bytes last pushed for the same layout and range */
+    void push_constants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+
+    auto stats() const -> const StateChangeStats&
+    {
+        return m_stats;
+    }
+
+private:
+    vk::CommandBuffer m_cmd;
+    StateChangeStats m_stats;
+
+    static auto bind_point_index(vk::PipelineBindPoint bindPoint) -> uint32_t;
+
+    std::array<vk::Pipeline, MAX_BIND_POINTS> m_pipelines{};
+    std::array<std::array<vk::PipelineLayout, MAX_DESCRIPTOR_SETS>, MAX_BIND_POINTS> m_setLayouts{};
+    std::array<std::array<vk::DescriptorSet, MAX_DESCRIPTOR_SETS>, MAX_BIND_POINTS> m_descriptorSets{};
+    std::array<vk::Buffer, MAX_VERTEX_BINDINGS> m_vertexBuffers{};
+    std::array<vk::DeviceSize, MAX_VERTEX_BINDINGS> m_vertexOffsets{};
+    vk::Buffer m_indexBuffer;
+    vk::DeviceSize m_indexOffset = 0;
+    vk::IndexType m_indexType = vk::IndexType::eUint32;
+
+    vk::PipelineLayout m_pushLayout;
+    vk::ShaderStageFlags m_pushStages;
+    uint32_t m_pushOffset = 0;
+    uint32_t m_pushSize = 0;
+    std::array<uint8_t, MAX_PUSH_CONSTANT_BYTES> m_pushData{};
+};
@@ -0,0 +1,81 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+void FrameStats::set_info(const std::string& key, const std::string& value)
+{
+    std::lock_guard lock(m_mutex);
+
+    for (auto& [existingKey, existingValue] : m_info)
+    {
+        if (existingKey == key)
+        {
+            existingValue = value;
+            return;
+        }
+    }
+
+    m_info.emplace_back(key, value);
+}
+
+void FrameStats::add_sample(const std::string& metric, double value)
+{
+    std::lock_guard lock(m_mutex);
+    m_samples[metric].push_back(value);
+}
+
+auto FrameStats::average(const std::string& metric) const -> double
+{
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_samples.find(metric);
+    if (it == m_samples.end() || it->second.empty())
+    {
+        return 0.0;
+    }
+
+    return std::accumulate(it->second.begin(), it->second.end(), 0.0) / static_cast<double>(it->second.size());
+}
+
+void FrameStats::print_report(std::ostream& out) const
+{
+    std::lock_guard lock(m_mutex);
+
+    out << "Benchmark results\n";
+
+    for (const auto& [key, value] : m_info)
+    {
+        out << "  " << std::left << std::setw(28) << key << value << '\n';
+    }
+
+    out << "  " << std::left << std::setw(28) << "metric" << std::right << std::setw(8) << "samples" << std::setw(12) << "avg"
+        << std::setw(12) << "min" << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "max" << '\n';
+
+    for (const auto& [metric, samples] : m_samples)
+    {
+        if (samples.empty())
+        {
+            continue;
+        }
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&sorted](double p) {
+            size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[index];
+        };
+
+        out << "  " << std::left << std::setw(28) << metric << std::right << std::setw(8) << sorted.size() << std::fixed
+            << std::setprecision(3) << std::setw(12) << average(metric) << std::setw(12) << sorted.front() << std::setw(12)
+            << percentile(0.5) << std::setw(12) << percentile(0.99) << std::setw(12) << sorted.back() << '\n';
+    }
+
+    out << std::flush;
+}
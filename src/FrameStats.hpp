@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Collects per-frame samples for named metrics plus a set of descriptive key/value pairs (the configuration the numbers were
+ * measured with), and prints a summary for benchmark runs. Safe to use from several threads.
+ */
+class FrameStats
+{
+public:
+    void set_info(const std::string& key, const std::string& value);
+
+    void add_sample(const std::string& metric, double value);
+
+    /* Average of the samples recorded for a metric, or 0 if there are none */
+    auto average(const std::string& metric) const -> double;
+
+    void print_report(std::ostream& out) const;
+
+private:
+    mutable std::mutex m_mutex;
+
+    std::vector<std::pair<std::string, std::string>> m_info;
+
+    // std::map keeps the report ordering stable between runs
+    std::map<std::string, std::vector<double>> m_samples;
+};
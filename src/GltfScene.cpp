@@ -0,0 +1,942 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "GltfScene.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr uint32_t GLB_MAGIC = 0x46546c67;  // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4e4f534a;
+    constexpr uint32_t GLB_CHUNK_BIN = 0x004e4942;
+
+    constexpr uint32_t COMPONENT_BYTE = 5120;
+    constexpr uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+    constexpr uint32_t COMPONENT_SHORT = 5122;
+    constexpr uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+    constexpr uint32_t COMPONENT_UNSIGNED_INT = 5125;
+    constexpr uint32_t COMPONENT_FLOAT = 5126;
+
+    constexpr uint32_t MODE_TRIANGLES = 4;
+
+    template <typename T>
+    auto read_unaligned(const uint8_t* source) -> T
+    {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        return value;
+    }
+
+    auto component_size(uint32_t componentType) -> uint32_t
+    {
+        switch (componentType)
+        {
+            case COMPONENT_BYTE:
+            case COMPONENT_UNSIGNED_BYTE: return 1;
+            case COMPONENT_SHORT:
+            case COMPONENT_UNSIGNED_SHORT: return 2;
+            case COMPONENT_UNSIGNED_INT:
+            case COMPONENT_FLOAT: return 4;
+            default: throw std::runtime_error("Unknown glTF accessor component type " + std::to_string(componentType) + "!");
+        }
+    }
+
+    auto component_count(const std::string& type) -> uint32_t
+    {
+        if (type == "SCALAR")
+        {
+            return 1;
+        }
+        if (type == "VEC2")
+        {
+            return 2;
+        }
+        if (type == "VEC3")
+        {
+            return 3;
+        }
+        if (type == "VEC4" || type == "MAT2")
+        {
+            return 4;
+        }
+        if (type == "MAT3")
+        {
+            return 9;
+        }
+        if (type == "MAT4")
+        {
+            return 16;
+        }
+        throw std::runtime_error("Unknown glTF accessor type '" + type + "'!");
+    }
+
+    /* Just the JSON glTF needs. Numbers are kept as doubles, which holds every integer glTF uses exactly. */
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        /* Null if this is not an object or the key is missing */
+        auto find(const std::string& key) const -> const JsonValue*
+        {
+            for (const auto& [name, value] : object)
+            {
+                if (name == key)
+                {
+                    return &value;
+                }
+            }
+            return nullptr;
+        }
+
+        auto number_or(const std::string& key, double fallback) const -> double
+        {
+            const JsonValue* value = find(key);
+            return value != nullptr && value->type == Type::Number ? value->number : fallback;
+        }
+
+        auto string_or(const std::string& key, const std::string& fallback) const -> std::string
+        {
+            const JsonValue* value = find(key);
+            return value != nullptr && value->type == Type::String ? value->string : fallback;
+        }
+
+        /* The array under key, empty if there is none */
+        auto array_at(const std::string& key) const -> const std::vector<JsonValue>&
+        {
+            static const std::vector<JsonValue> empty;
+            const JsonValue* value = find(key);
+            return value != nullptr && value->type == Type::Array ? value->array : empty;
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* begin, const char* end) : m_pos(begin), m_end(end)
+        {
+        }
+
+        auto parse() -> JsonValue
+        {
+            JsonValue value = parse_value();
+            skip_whitespace();
+            if (m_pos != m_end && *m_pos != '\0')
+            {
+                fail("trailing characters");
+            }
+            return value;
+        }
+
+    private:
+        /* Arrays and objects are parsed recursively, so a hostile file could otherwise nest deep enough to overflow the stack */
+        static constexpr uint32_t MAX_DEPTH = 128;
+
+        const char* m_pos;
+        const char* m_end;
+        uint32_t m_depth = 0;
+
+        [[noreturn]] void fail(const std::string& what) const
+        {
+            throw std::runtime_error("Malformed glTF JSON: " + what + "!");
+        }
+
+        void skip_whitespace()
+        {
+            while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r'))
+            {
+                m_pos++;
+            }
+        }
+
+        auto peek() -> char
+        {
+            skip_whitespace();
+            if (m_pos == m_end)
+            {
+                fail("unexpected end of input");
+            }
+            return *m_pos;
+        }
+
+        void expect(char c)
+        {
+            if (peek() != c)
+            {
+                fail(std::string("expected '") + c + "'");
+            }
+            m_pos++;
+        }
+
+        void expect_literal(const char* literal)
+        {
+            size_t length = std::strlen(literal);
+            if (static_cast<size_t>(m_end - m_pos) < length || std::memcmp(m_pos, literal, length) != 0)
+            {
+                fail("unknown literal");
+            }
+            m_pos += length;
+        }
+
+        auto parse_value() -> JsonValue
+        {
+            JsonValue value;
+            char c = peek();
+            if ((c == '{' || c == '[') && m_depth == MAX_DEPTH)
+            {
+                fail("nesting too deep");
+            }
+            if (c == '{')
+            {
+                value.type = JsonValue::Type::Object;
+                m_pos++;
+                if (peek() == '}')
+                {
+                    m_pos++;
+                    return value;
+                }
+                while (true)
+                {
+                    std::string key = parse_string();
+                    expect(':');
+                    m_depth++;
+                    value.object.emplace_back(std::move(key), parse_value());
+                    m_depth--;
+                    if (peek() == '}')
+                    {
+                        m_pos++;
+                        return value;
+                    }
+                    expect(',');
+                }
+            }
+            if (c == '[')
+            {
+                value.type = JsonValue::Type::Array;
+                m_pos++;
+                if (peek() == ']')
+                {
+                    m_pos++;
+                    return value;
+                }
+                while (true)
+                {
+                    m_depth++;
+                    value.array.push_back(parse_value());
+                    m_depth--;
+                    if (peek() == ']')
+                    {
+                        m_pos++;
+                        return value;
+                    }
+                    expect(',');
+                }
+            }
+            if (c == '"')
+            {
+                value.type = JsonValue::Type::String;
+                value.string = parse_string();
+                return value;
+            }
+            if (c == 't' || c == 'f')
+            {
+                value.type = JsonValue::Type::Bool;
+                value.boolean = c == 't';
+                expect_literal(value.boolean ? "true" : "false");
+                return value;
+            }
+            if (c == 'n')
+            {
+                expect_literal("null");
+                return value;
+            }
+
+            value.type = JsonValue::Type::Number;
+            value.number = parse_number();
+            return value;
+        }
+
+        auto parse_number() -> double
+        {
+            // The input is not null terminated, so strtod gets a copy of just the number
+            const char* start = m_pos;
+            while (m_pos != m_end && (std::isdigit(static_cast<unsigned char>(*m_pos)) || std::strchr("+-.eE", *m_pos) != nullptr))
+            {
+                m_pos++;
+            }
+            std::string text(start, m_pos);
+
+            char* parsedEnd = nullptr;
+            double number = std::strtod(text.c_str(), &parsedEnd);
+            if (text.empty() || parsedEnd != text.c_str() + text.size())
+            {
+                fail("bad number");
+            }
+            return number;
+        }
+
+        auto parse_hex4() -> uint32_t
+        {
+            if (m_end - m_pos < 4)
+            {
+                fail("truncated escape");
+            }
+
+            uint32_t code = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = *m_pos++;
+                code <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    code |= static_cast<uint32_t>(c - '0');
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    code |= static_cast<uint32_t>(c - 'a' + 10);
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    code |= static_cast<uint32_t>(c - 'A' + 10);
+                }
+                else
+                {
+                    fail("bad escape");
+                }
+            }
+            return code;
+        }
+
+        static void append_utf8(std::string& out, uint32_t code)
+        {
+            if (code < 0x80)
+            {
+                out += static_cast<char>(code);
+            }
+            else if (code < 0x800)
+            {
+                out += static_cast<char>(0xc0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            else if (code < 0x10000)
+            {
+                out += static_cast<char>(0xe0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            else
+            {
+                out += static_cast<char>(0xf0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                out += static_cast<char>(0x80 | (code & 0x3f));
+            }
+        }
+
+        auto parse_string() -> std::string
+        {
+            expect('"');
+
+            std::string out;
+            while (true)
+            {
+                if (m_pos == m_end)
+                {
+                    fail("unterminated string");
+                }
+
+                char c = *m_pos++;
+                if (c == '"')
+                {
+                    return out;
+                }
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+
+                if (m_pos == m_end)
+                {
+                    fail("unterminated string");
+                }
+                switch (char escape = *m_pos++)
+                {
+                    case '"':
+                    case '\\':
+                    case '/': out += escape; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t code = parse_hex4();
+                        // Characters outside the basic plane come as a surrogate pair
+                        if (code >= 0xd800 && code < 0xdc00 && m_end - m_pos >= 2 && m_pos[0] == '\\' && m_pos[1] == 'u')
+                        {
+                            m_pos += 2;
+                            uint32_t low = parse_hex4();
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                        }
+                        append_utf8(out, code);
+                        break;
+                    }
+                    default: fail("bad escape");
+                }
+            }
+        }
+    };
+
+    /* URIs are relative references, so spaces and the like arrive percent encoded */
+    auto decode_uri(const std::string& uri) -> std::string
+    {
+        std::string out;
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size())
+            {
+                out += static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                out += uri[i];
+            }
+        }
+        return out;
+    }
+
+    auto index_of(const JsonValue& value, size_t count, const char* what) -> uint32_t
+    {
+        if (value.type != JsonValue::Type::Number || value.number < 0.0 || value.number >= static_cast<double>(count))
+        {
+            throw std::runtime_error(std::string("glTF ") + what + " index out of range!");
+        }
+        return static_cast<uint32_t>(value.number);
+    }
+
+    struct BufferView
+    {
+        const uint8_t* data;
+        size_t size;
+        uint32_t stride;
+    };
+}
+
+auto GltfAccessor::read_float(uint32_t i, uint32_t c) const -> float
+{
+    if (data == nullptr)
+    {
+        return 0.0f;
+    }
+
+    const uint8_t* element = data + static_cast<size_t>(i) * stride;
+    switch (componentType)
+    {
+        case COMPONENT_FLOAT: return read_unaligned<float>(element + c * 4);
+        case COMPONENT_BYTE:
+        {
+            float value = read_unaligned<int8_t>(element + c);
+            return normalized ? std::max(value / 127.0f, -1.0f) : value;
+        }
+        case COMPONENT_UNSIGNED_BYTE:
+        {
+            float value = read_unaligned<uint8_t>(element + c);
+            return normalized ? value / 255.0f : value;
+        }
+        case COMPONENT_SHORT:
+        {
+            float value = read_unaligned<int16_t>(element + c * 2);
+            return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            float value = read_unaligned<uint16_t>(element + c * 2);
+            return normalized ? value / 65535.0f : value;
+        }
+        case COMPONENT_UNSIGNED_INT: return static_cast<float>(read_unaligned<uint32_t>(element + c * 4));
+        default: return 0.0f;
+    }
+}
+
+auto GltfAccessor::read_index(uint32_t i) const -> uint32_t
+{
+    if (data == nullptr)
+    {
+        return 0;
+    }
+
+    const uint8_t* element = data + static_cast<size_t>(i) * stride;
+    switch (componentType)
+    {
+        case COMPONENT_UNSIGNED_BYTE: return read_unaligned<uint8_t>(element);
+        case COMPONENT_UNSIGNED_SHORT: return read_unaligned<uint16_t>(element);
+        default: return read_unaligned<uint32_t>(element);
+    }
+}
+
+auto GltfPrimitive::read_vertex(uint32_t i) const -> Vertex
+{
+    Vertex vertex{ glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(0.0f) };
+    vertex.pos = glm::vec3(positions.read_float(i, 0), positions.read_float(i, 1), positions.read_float(i, 2));
+    if (colors.is_valid())
+    {
+        vertex.color = glm::vec3(colors.read_float(i, 0), colors.read_float(i, 1), colors.read_float(i, 2));
+    }
+    if (texCoords.is_valid())
+    {
+        vertex.texCoord = glm::vec2(texCoords.read_float(i, 0), texCoords.read_float(i, 1));
+    }
+    return vertex;
+}
+
+auto GltfScene::load(const std::string& filename) -> GltfScene
+{
+    GltfScene scene;
+
+    MappedFile file(filename);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open glTF scene '" + filename + "'!");
+    }
+
+    const auto* jsonBegin = reinterpret_cast<const char*>(file.data());
+    const char* jsonEnd = jsonBegin + file.size();
+    const uint8_t* binChunk = nullptr;
+    size_t binChunkSize = 0;
+
+    // A .glb is a 12 byte header followed by a JSON chunk and an optional binary one, each with an 8 byte header of its own
+    if (file.size() >= 12 && read_unaligned<uint32_t>(file.data()) == GLB_MAGIC)
+    {
+        uint32_t version = read_unaligned<uint32_t>(file.data() + 4);
+        size_t length = std::min<size_t>(read_unaligned<uint32_t>(file.data() + 8), file.size());
+        if (version != 2)
+        {
+            throw std::runtime_error("Unsupported .glb version " + std::to_string(version) + " in '" + filename + "'!");
+        }
+
+        size_t offset = 12;
+        bool hasJson = false;
+        while (offset + 8 <= length)
+        {
+            size_t chunkSize = read_unaligned<uint32_t>(file.data() + offset);
+            uint32_t chunkType = read_unaligned<uint32_t>(file.data() + offset + 4);
+            const uint8_t* chunk = file.data() + offset + 8;
+            if (chunkSize > length - offset - 8)
+            {
+                throw std::runtime_error("Truncated .glb chunk in '" + filename + "'!");
+            }
+
+            if (chunkType == GLB_CHUNK_JSON && !hasJson)
+            {
+                jsonBegin = reinterpret_cast<const char*>(chunk);
+                jsonEnd = jsonBegin + chunkSize;
+                hasJson = true;
+            }
+            else if (chunkType == GLB_CHUNK_BIN && binChunk == nullptr)
+            {
+                binChunk = chunk;
+                binChunkSize = chunkSize;
+            }
+
+            // Chunks are padded to 4 bytes
+            offset += 8 + ((chunkSize + 3) & ~size_t(3));
+        }
+
+        if (!hasJson)
+        {
+            throw std::runtime_error("No JSON chunk in '" + filename + "'!");
+        }
+    }
+
+    JsonValue root = JsonParser(jsonBegin, jsonEnd).parse();
+    scene.m_files.push_back(std::move(file));
+
+    const JsonValue* asset = root.find("asset");
+    if (asset == nullptr || asset->string_or("version", "").rfind('2', 0) != 0)
+    {
+        throw std::runtime_error("'" + filename + "' is not a glTF 2.0 asset!");
+    }
+
+    size_t separator = filename.find_last_of("/\\");
+    std::string directory = separator == std::string::npos ? "" : filename.substr(0, separator + 1);
+
+    // Buffers. A mapping's address survives moving the MappedFile, so the pointers taken here stay valid.
+    std::vector<std::pair<const uint8_t*, size_t>> buffers;
+    for (const JsonValue& buffer : root.array_at("buffers"))
+    {
+        auto byteLength = static_cast<size_t>(buffer.number_or("byteLength", 0.0));
+        std::string uri = buffer.string_or("uri", "");
+
+        if (uri.empty())
+        {
+            if (binChunk == nullptr || buffers.size() != 0 || binChunkSize < byteLength)
+            {
+                throw std::runtime_error("glTF buffer without a URI does not match the .glb binary chunk!");
+            }
+            buffers.emplace_back(binChunk, byteLength);
+            continue;
+        }
+
+        if (uri.rfind("data:", 0) == 0)
+        {
+            throw std::runtime_error("glTF buffers embedded as data URIs are not supported, convert '" + filename + "' to .glb!");
+        }
+
+        MappedFile bufferFile(directory + decode_uri(uri));
+        if (!bufferFile.is_open() || bufferFile.size() < byteLength)
+        {
+            throw std::runtime_error("Failed to map glTF buffer '" + uri + "'!");
+        }
+        buffers.emplace_back(bufferFile.data(), byteLength);
+        scene.m_files.push_back(std::move(bufferFile));
+    }
+
+    std::vector<BufferView> bufferViews;
+    for (const JsonValue& view : root.array_at("bufferViews"))
+    {
+        const JsonValue* bufferIndex = view.find("buffer");
+        if (bufferIndex == nullptr)
+        {
+            throw std::runtime_error("glTF buffer view without a buffer!");
+        }
+        const auto& buffer = buffers[index_of(*bufferIndex, buffers.size(), "buffer")];
+
+        auto offset = static_cast<size_t>(view.number_or("byteOffset", 0.0));
+        auto size = static_cast<size_t>(view.number_or("byteLength", 0.0));
+        if (offset > buffer.second || size > buffer.second - offset)
+        {
+            throw std::runtime_error("glTF buffer view out of its buffer's range!");
+        }
+
+        bufferViews.push_back({ buffer.first + offset, size, static_cast<uint32_t>(view.number_or("byteStride", 0.0)) });
+    }
+
+    const std::vector<JsonValue>& accessors = root.array_at("accessors");
+    auto readAccessor = [&](const JsonValue& index) {
+        const JsonValue& json = accessors[index_of(index, accessors.size(), "accessor")];
+        if (json.find("sparse") != nullptr)
+        {
+            throw std::runtime_error("Sparse glTF accessors are not supported!");
+        }
+
+        GltfAccessor accessor;
+        accessor.count = static_cast<uint32_t>(json.number_or("count", 0.0));
+        accessor.componentType = static_cast<uint32_t>(json.number_or("componentType", 0.0));
+        accessor.components = component_count(json.string_or("type", ""));
+        accessor.normalized = json.find("normalized") != nullptr && json.find("normalized")->boolean;
+
+        uint32_t elementSize = component_size(accessor.componentType) * accessor.components;
+        accessor.stride = elementSize;
+
+        const JsonValue* viewIndex = json.find("bufferView");
+        if (viewIndex == nullptr || accessor.count == 0)
+        {
+            return accessor;
+        }
+
+        const BufferView& view = bufferViews[index_of(*viewIndex, bufferViews.size(), "buffer view")];
+        auto offset = static_cast<size_t>(json.number_or("byteOffset", 0.0));
+        accessor.stride = view.stride != 0 ? view.stride : elementSize;
+
+        // Every component of the last element has to lie inside the view, and elements may not overlap
+        size_t extent = static_cast<size_t>(accessor.count - 1) * accessor.stride + elementSize;
+        if (accessor.stride < elementSize || offset > view.size || extent > view.size - offset)
+        {
+            throw std::runtime_error("glTF accessor out of its buffer view's range!");
+        }
+
+        accessor.data = view.data + offset;
+        return accessor;
+    };
+
+    auto isVertexFloat = [](const GltfAccessor& accessor) {
+        return accessor.componentType == COMPONENT_FLOAT ||
+               (accessor.normalized &&
+                (accessor.componentType == COMPONENT_UNSIGNED_BYTE || accessor.componentType == COMPONENT_UNSIGNED_SHORT));
+    };
+
+    // Meshes. Positions must be float, which the spec guarantees without extensions.
+    for (const JsonValue& meshJson : root.array_at("meshes"))
+    {
+        GltfMesh& mesh = scene.meshes.emplace_back();
+        for (const JsonValue& primitiveJson : meshJson.array_at("primitives"))
+        {
+            const JsonValue* attributes = primitiveJson.find("attributes");
+            const JsonValue* position = attributes != nullptr ? attributes->find("POSITION") : nullptr;
+            if (primitiveJson.number_or("mode", MODE_TRIANGLES) != MODE_TRIANGLES || position == nullptr)
+            {
+                continue;
+            }
+
+            GltfPrimitive primitive;
+            primitive.positions = readAccessor(*position);
+            if (primitive.positions.componentType != COMPONENT_FLOAT || primitive.positions.components != 3)
+            {
+                throw std::runtime_error("glTF positions must be float VEC3!");
+            }
+
+            // read_vertex reads every component of these for each position, so their layout has to be what the spec allows
+            if (const JsonValue* color = attributes->find("COLOR_0"))
+            {
+                primitive.colors = readAccessor(*color);
+                if ((primitive.colors.components != 3 && primitive.colors.components != 4) || !isVertexFloat(primitive.colors) ||
+                    primitive.colors.count < primitive.positions.count)
+                {
+                    throw std::runtime_error("glTF colors must be VEC3 or VEC4 float or normalized unsigned integers per vertex!");
+                }
+            }
+            if (const JsonValue* texCoord = attributes->find("TEXCOORD_0"))
+            {
+                primitive.texCoords = readAccessor(*texCoord);
+                if (primitive.texCoords.components != 2 || !isVertexFloat(primitive.texCoords) ||
+                    primitive.texCoords.count < primitive.positions.count)
+                {
+                    throw std::runtime_error("glTF texture coordinates must be VEC2 float or normalized unsigned integers per vertex!");
+                }
+            }
+            if (const JsonValue* indices = primitiveJson.find("indices"))
+            {
+                primitive.indices = readAccessor(*indices);
+                if (primitive.indices.components != 1 || primitive.indices.componentType == COMPONENT_BYTE ||
+                    primitive.indices.componentType == COMPONENT_SHORT || primitive.indices.componentType == COMPONENT_FLOAT)
+                {
+                    throw std::runtime_error("glTF indices must be unsigned integer scalars!");
+                }
+            }
+            primitive.material = static_cast<int32_t>(primitiveJson.number_or("material", -1.0));
+
+            // min and max are required on positions, but a scan keeps files that leave them out loadable
+            const JsonValue& positionJson = accessors[index_of(*position, accessors.size(), "accessor")];
+            const std::vector<JsonValue>& minJson = positionJson.array_at("min");
+            const std::vector<JsonValue>& maxJson = positionJson.array_at("max");
+            if (minJson.size() == 3 && maxJson.size() == 3)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    primitive.boundsMin[c] = static_cast<float>(minJson[c].number);
+                    primitive.boundsMax[c] = static_cast<float>(maxJson[c].number);
+                }
+            }
+            else if (primitive.positions.count > 0)
+            {
+                primitive.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+                primitive.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                for (uint32_t i = 0; i < primitive.positions.count; i++)
+                {
+                    glm::vec3 pos = primitive.read_vertex(i).pos;
+                    primitive.boundsMin = glm::min(primitive.boundsMin, pos);
+                    primitive.boundsMax = glm::max(primitive.boundsMax, pos);
+                }
+            }
+
+            mesh.primitives.push_back(primitive);
+        }
+    }
+
+    // Materials, textures and images
+    for (const JsonValue& materialJson : root.array_at("materials"))
+    {
+        GltfMaterial& material = scene.materials.emplace_back();
+        const JsonValue* pbr = materialJson.find("pbrMetallicRoughness");
+        if (pbr == nullptr)
+        {
+            continue;
+        }
+
+        const std::vector<JsonValue>& factor = pbr->array_at("baseColorFactor");
+        if (factor.size() == 4)
+        {
+            material.baseColorFactor = glm::vec4(factor[0].number, factor[1].number, factor[2].number, factor[3].number);
+        }
+        if (const JsonValue* texture = pbr->find("baseColorTexture"))
+        {
+            material.baseColorTexture = static_cast<int32_t>(texture->number_or("index", -1.0));
+        }
+    }
+
+    const std::vector<JsonValue>& images = root.array_at("images");
+    for (const JsonValue& textureJson : root.array_at("textures"))
+    {
+        GltfTexture& texture = scene.textures.emplace_back();
+        const JsonValue* source = textureJson.find("source");
+        if (source == nullptr)
+        {
+            continue;
+        }
+
+        std::string uri = images[index_of(*source, images.size(), "image")].string_or("uri", "");
+        if (!uri.empty() && uri.rfind("data:", 0) != 0)
+        {
+            texture.imagePath = directory + decode_uri(uri);
+        }
+    }
+
+    // Nodes of the default scene, or every root node when the file has no scenes
+    const std::vector<JsonValue>& nodes = root.array_at("nodes");
+    std::vector<uint8_t> visited(nodes.size(), 0);
+
+    std::function<void(uint32_t, const glm::mat4&)> visitNode = [&](uint32_t nodeIndex, const glm::mat4& parent) {
+        if (visited[nodeIndex])
+        {
+            throw std::runtime_error("glTF node hierarchy is not a forest!");
+        }
+        visited[nodeIndex] = 1;
+
+        const JsonValue& node = nodes[nodeIndex];
+        glm::mat4 local(1.0f);
+        const std::vector<JsonValue>& matrix = node.array_at("matrix");
+        if (matrix.size() == 16)
+        {
+            float values[16];
+            for (int i = 0; i < 16; i++)
+            {
+                values[i] = static_cast<float>(matrix[i].number);
+            }
+            local = glm::make_mat4(values);
+        }
+        else
+        {
+            const std::vector<JsonValue>& t = node.array_at("translation");
+            const std::vector<JsonValue>& r = node.array_at("rotation");
+            const std::vector<JsonValue>& s = node.array_at("scale");
+
+            glm::vec3 translation = t.size() == 3 ? glm::vec3(t[0].number, t[1].number, t[2].number) : glm::vec3(0.0f);
+            // Stored x, y, z, w while glm takes w first
+            glm::quat rotation = r.size() == 4 ? glm::quat(static_cast<float>(r[3].number),
+                                                           static_cast<float>(r[0].number),
+                                                           static_cast<float>(r[1].number),
+                                                           static_cast<float>(r[2].number))
+                                               : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            glm::vec3 scale = s.size() == 3 ? glm::vec3(s[0].number, s[1].number, s[2].number) : glm::vec3(1.0f);
+
+            local = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+        }
+
+        glm::mat4 world = parent * local;
+        if (const JsonValue* mesh = node.find("mesh"))
+        {
+            scene.instances.push_back({ index_of(*mesh, scene.meshes.size(), "mesh"), world });
+        }
+
+        for (const JsonValue& child : node.array_at("children"))
+        {
+            visitNode(index_of(child, nodes.size(), "node"), world);
+        }
+    };
+
+    const std::vector<JsonValue>& scenes = root.array_at("scenes");
+    if (!scenes.empty())
+    {
+        const JsonValue* defaultScene = root.find("scene");
+        const JsonValue& sceneJson = defaultScene != nullptr ? scenes[index_of(*defaultScene, scenes.size(), "scene")] : scenes[0];
+        for (const JsonValue& node : sceneJson.array_at("nodes"))
+        {
+            visitNode(index_of(node, nodes.size(), "node"), glm::mat4(1.0f));
+        }
+    }
+    else
+    {
+        std::vector<uint8_t> isChild(nodes.size(), 0);
+        for (const JsonValue& node : nodes)
+        {
+            for (const JsonValue& child : node.array_at("children"))
+            {
+                isChild[index_of(child, nodes.size(), "node")] = 1;
+            }
+        }
+        for (uint32_t n = 0; n < nodes.size(); n++)
+        {
+            if (!isChild[n])
+            {
+                visitNode(n, glm::mat4(1.0f));
+            }
+        }
+    }
+
+    // Materials and textures may be referenced out of range by a careless exporter, which draws as untextured white
+    for (GltfMesh& mesh : scene.meshes)
+    {
+        for (GltfPrimitive& primitive : mesh.primitives)
+        {
+            if (primitive.material >= static_cast<int32_t>(scene.materials.size()))
+            {
+                primitive.material = -1;
+            }
+        }
+    }
+    for (GltfMaterial& material : scene.materials)
+    {
+        if (material.baseColorTexture >= static_cast<int32_t>(scene.textures.size()))
+        {
+            material.baseColorTexture = -1;
+        }
+    }
+
+    return scene;
+}
+
+auto GltfScene::vertex_count() const -> size_t
+{
+    size_t count = 0;
+    for (const GltfMesh& mesh : meshes)
+    {
+        for (const GltfPrimitive& primitive : mesh.primitives)
+        {
+            count += primitive.positions.count;
+        }
+    }
+    return count;
+}
+
+auto GltfScene::index_count() const -> size_t
+{
+    size_t count = 0;
+    for (const GltfMesh& mesh : meshes)
+    {
+        for (const GltfPrimitive& primitive : mesh.primitives)
+        {
+            count += primitive.index_count();
+        }
+    }
+    return count;
+}
+
+auto GltfScene::mapped_bytes() const -> size_t
+{
+    size_t bytes = 0;
+    for (const MappedFile& file : m_files)
+    {
+        bytes += file.size();
+    }
+    return bytes;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "VertexFormat.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Typed view of accessor data, pointing straight into a mapped buffer. Elements are stride bytes apart. */
+struct GltfAccessor
+{
+    /* Null for an accessor without a buffer view, whose elements all read as zero */
+    const uint8_t* data = nullptr;
+    uint32_t count = 0;
+    uint32_t componentType = 0;
+    uint32_t components = 0;
+    uint32_t stride = 0;
+    bool normalized = false;
+
+    auto is_valid() const -> bool
+    {
+        return count > 0;
+    }
+
+    /* Component c of element i, converted to float and normalised if the accessor asks for it */
+    auto read_float(uint32_t i, uint32_t c) const -> float;
+
+    auto read_index(uint32_t i) const -> uint32_t;
+};
+
+/* A triangle list. Attributes other than positions are optional and read as white and zero when missing. */
+struct GltfPrimitive
+{
+    GltfAccessor positions;
+    GltfAccessor colors;
+    GltfAccessor texCoords;
+    /* Invalid for non-indexed primitives, whose vertices are taken in order */
+    GltfAccessor indices;
+    int32_t material = -1;
+
+    /* Local space bounds from the position accessor's required min and max */
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    auto index_count() const -> uint32_t
+    {
+        return indices.is_valid() ? indices.count : positions.count;
+    }
+
+    auto read_vertex(uint32_t i) const -> Vertex;
+};
+
+struct GltfMesh
+{
+    std::vector<GltfPrimitive> primitives;
+};
+
+/* Metallic-roughness materials contribute their base colour only */
+struct GltfMaterial
+{
+    glm::vec4 baseColorFactor = glm::vec4(1.0f);
+    int32_t baseColorTexture = -1;
+};
+
+struct GltfTexture
+{
+    /* Image file resolved against the scene's directory. Empty for images embedded in a buffer view or a data URI. */
+    std::string imagePath;
+};
+
+/* A mesh placed by a node, with the node's transform concatenated with all of its parents' */
+struct GltfMeshInstance
+{
+    uint32_t mesh = 0;
+    glm::mat4 transform = glm::mat4(1.0f);
+};
+
+/*
+ * glTF 2.0 scene read from a .gltf with external buffers or a binary .glb. Buffers are memory mapped and accessors point into
+ * the mappings, so geometry is never copied until the caller reads it into its own destination. Throws std::runtime_error on
+ * anything malformed or unsupported (data URI buffers, sparse accessors).
+ */
+class GltfScene
+{
+public:
+    static auto load(const std::string& filename) -> GltfScene;
+
+    std::vector<GltfMesh> meshes;
+    std::vector<GltfMaterial> materials;
+    std::vector<GltfTexture> textures;
+    /* Nodes of the default scene that carry a mesh, in traversal order */
+    std::vector<GltfMeshInstance> instances;
+
+    /* Totals over every primitive of every mesh, each stored once however many instances draw it */
+    auto vertex_count() const -> size_t;
+    auto index_count() const -> size_t;
+
+    /* Bytes of the files mapped for the scene, the .gltf or .glb included */
+    auto mapped_bytes() const -> size_t;
+
+private:
+    std::vector<MappedFile> m_files;
+};
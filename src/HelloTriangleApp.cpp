@@ -7,22 +7,68 @@
 #define VMA_IMPLEMENTATION
 #include <vma/vk_mem_alloc.h>
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <set>
 #include <chrono>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 #define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "BoundedQueue.hpp"
+#include "GltfScene.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Meshlets.hpp"
+#include "TextureCache.hpp"
+#include "VertexFormat.hpp"
 
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 800;
 
+const std::string TEXTURE_PATH = "textures/texture.jpg";
+const std::string TEXTURE_CACHE_DIR = "cache/textures";
+
+/* Requested sizes of the global descriptor arrays, clamped to what the device allows */
+const uint32_t MAX_BINDLESS_TEXTURES = 32768;
+const uint32_t MAX_BINDLESS_STORAGE_BUFFERS = 4096;
+
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 10.0f;
+
+/* Draw sort key fields. Every scene draw currently goes through the offscreen pipeline. */
+const uint32_t DRAW_PASS_SCENE = 0;
+const uint32_t DRAW_PIPELINE_OFFSCREEN = 0;
+
+/* Scene passes that record a fragment invocation query */
+const std::array<std::string, 4> STATISTICS_PASS_NAMES = { "depth_prepass", "depth_prepass_late", "offscreen", "offscreen_late" };
+
+/* Tessellation of the --meshlets sphere, about 65k triangles */
+const uint32_t SPHERE_RINGS = 128;
+const uint32_t SPHERE_SEGMENTS = 256;
+
+/* --lod chains stop where a level would deviate from its mesh by more than this fraction of the mesh's size. Each object draws the
+ * coarsest level whose deviation projects to at most LOD_PIXEL_ERROR swapchain pixels. */
+const float LOD_MAX_ERROR = 0.05f;
+const float LOD_PIXEL_ERROR = 1.0f;
+
+/* Slack left between the predicted end of a frame's work and the refresh it targets in low latency mode */
+const double LATENCY_MARGIN_MS = 1.0;
+const uint64_t PRESENT_WAIT_TIMEOUT_NS = 100000000;
+const uint64_t ACQUIRE_TIMEOUT_NS = 1000000;
+
 const std::vector VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validation" };
 
 const std::vector DEVICE_EXTENSIONS = {
@@ -34,6 +80,7 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> computeFamily;
 
     auto is_complete() const -> bool
     {
@@ -50,62 +97,280 @@ struct SwapChainSupportDetails
 
 const std::array<float, 4> CLEAR_COLOR = { 0.0f, 0.0f, 0.0f, 1.0f };
 
-struct Vertex
+/* Per-quad data, stepped once per instance on the second vertex binding */
+struct InstanceData
 {
-    glm::vec2 pos;
-    glm::vec3 color;
-    glm::vec2 texCoord;
+    glm::mat4 model;
+    /* RGBA8, multiplied with the texture */
+    uint32_t color;
+    uint32_t textureIndex;
 
     static auto get_binding_description() -> vk::VertexInputBindingDescription
     {
         vk::VertexInputBindingDescription bindingDesc{};
-        bindingDesc.binding = 0;
-        bindingDesc.stride = sizeof(Vertex);
+        bindingDesc.binding = 1;
+        bindingDesc.stride = sizeof(InstanceData);
 
-        bindingDesc.inputRate = vk::VertexInputRate::eVertex;
+        bindingDesc.inputRate = vk::VertexInputRate::eInstance;
 
         return bindingDesc;
     }
 
-    static auto get_attrib_descriptions() -> std::array<vk::VertexInputAttributeDescription, 3>
+    static auto get_attrib_descriptions() -> std::array<vk::VertexInputAttributeDescription, 6>
     {
-        std::array<vk::VertexInputAttributeDescription, 3> attribDescriptions{};
+        std::array<vk::VertexInputAttributeDescription, 6> attribDescriptions{};
 
-        attribDescriptions[0].binding = 0;
-        attribDescriptions[0].location = 0;
-        attribDescriptions[0].format = vk::Format::eR32G32Sfloat;
-        attribDescriptions[0].offset = offsetof(Vertex, pos);
+        // A mat4 input takes four consecutive locations, one per column
+        for (uint32_t column = 0; column < 4; column++)
+        {
+            attribDescriptions[column].binding = 1;
+            attribDescriptions[column].location = 3 + column;
+            attribDescriptions[column].format = vk::Format::eR32G32B32A32Sfloat;
+            attribDescriptions[column].offset = static_cast<uint32_t>(offsetof(InstanceData, model) + column * sizeof(glm::vec4));
+        }
 
-        attribDescriptions[1].binding = 0;
-        attribDescriptions[1].location = 1;
-        attribDescriptions[1].format = vk::Format::eR32G32B32Sfloat;
-        attribDescriptions[1].offset = offsetof(Vertex, color);
+        attribDescriptions[4].binding = 1;
+        attribDescriptions[4].location = 7;
+        attribDescriptions[4].format = vk::Format::eR8G8B8A8Unorm;
+        attribDescriptions[4].offset = offsetof(InstanceData, color);
 
-        attribDescriptions[2].binding = 0;
-        attribDescriptions[2].location = 2;
-        attribDescriptions[2].format = vk::Format::eR32G32Sfloat;
-        attribDescriptions[2].offset = offsetof(Vertex, texCoord);
+        attribDescriptions[5].binding = 1;
+        attribDescriptions[5].location = 8;
+        attribDescriptions[5].format = vk::Format::eR32Uint;
+        attribDescriptions[5].offset = offsetof(InstanceData, textureIndex);
 
         return attribDescriptions;
     }
 };
 
-const std::vector<Vertex> VERTICES = { { { -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
-                                       { { 0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f } },
-                                       { { 0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } },
-                                       { { -0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f } } };
+const std::vector<Vertex> VERTICES = { { { -0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+                                       { { 0.5f, -0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f } },
+                                       { { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } },
+                                       { { -0.5f, 0.5f, 0.0f }, { 1.0f, 1.0f, 1.0f }, { 0.0f, 1.0f } } };
 
-const std::vector<uint16_t> INDICES = {
+const std::vector<uint32_t> INDICES = {
     0, 1, 2, 2, 3, 0,
 };
 
-struct UniformBufferObject
+/* Written once per frame. Anything that changes per draw goes in DrawConstants instead. */
+struct FrameUniforms
 {
-    alignas(16) glm::mat4 model;
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
+    alignas(16) glm::mat4 viewProj;
+    alignas(16) glm::vec4 cameraPosition;
+    /* The previous frame's viewProj, which the depth pyramid was rendered with */
+    alignas(16) glm::mat4 previousViewProj;
+};
+
+/* Pushed with each draw, so per draw changes need no buffer writes or descriptor binds. 112 bytes of the guaranteed 128. */
+struct DrawConstants
+{
+    glm::mat4 model;
+    uint32_t textureBase;
+    /* Decodes the mesh's vertex positions, see QuantizedVertices */
+    alignas(16) glm::vec4 positionScale;
+    alignas(16) glm::vec4 positionOffset;
+};
+
+/* Pushed by the final pass, matching fullscreen_quad.frag */
+struct FinalConstants
+{
+    glm::vec2 uvScale;
+    glm::vec2 uvMax;
 };
 
+/* What the CPU needs to build a draw's sort key and pick its level of detail, and the full detail index range it draws */
+struct SceneDraw
+{
+    glm::vec3 center;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    /* Bounding sphere radius, and the largest scale of the instance transform that LOD errors are multiplied by */
+    float radius;
+    float lodScale;
+    /* Range of m_meshLods, empty for a mesh without levels */
+    uint32_t firstLod;
+    uint32_t lodCount;
+};
+
+/* Input of the GPU cull pass, matching cull.comp. A visible object becomes one indirect draw of its index range. */
+struct CullObject
+{
+    /* Centre and radius, in the space of the instance transforms */
+    glm::vec4 sphere;
+    /* Normal cone axis and cutoff, culled when dot(normalize(apex - eye), axis) >= cutoff. A cutoff above 1 disables it. */
+    glm::vec4 cone;
+    glm::vec4 coneApex;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    uint32_t instance;
+    /* Range of the LOD table and the instance scale, as in SceneDraw. The index range above is used when it is empty. */
+    uint32_t firstLod = 0;
+    uint32_t lodCount = 0;
+    float lodScale = 1.0f;
+    uint32_t padding[2] = {};
+};
+
+/* Written by the cull pass, matching cull.comp. Objects neither drawn nor deferred failed the cone or frustum test. */
+struct CullCounts
+{
+    uint32_t drawCount;
+    uint32_t lateDrawCount;
+    uint32_t deferredCount;
+    /* Deferred objects the late phase still found occluded */
+    uint32_t occludedCount;
+    /* Triangles of the draws of both phases, at the levels of detail picked */
+    uint32_t triangleCount;
+    /* Clusters the early phase rejected because all their triangles face away */
+    uint32_t coneCulledCount;
+};
+
+struct CullParams
+{
+    uint32_t objectCount;
+    /* 0 for the early phase, 1 for the late one */
+    uint32_t phase;
+    uint32_t occlusion;
+    /* LOD_PIXEL_ERROR, and the swapchain height it is measured against */
+    float lodPixelError;
+    float viewportHeight;
+};
+
+/* Lays the quads out on a square grid over the area the single quad used to cover. Texture indices are relative to the scene's
+ * first bindless texture and cycle through textureCount of them. */
+static auto make_instances(uint32_t count, uint32_t textureCount) -> std::vector<InstanceData>
+{
+    // Packed little endian, so red is the low byte
+    const std::array<uint32_t, 4> tints = { 0xffffffff, 0xffc0c0ff, 0xffc0ffc0, 0xffffc0c0 };
+
+    auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    float cell = 1.0f / static_cast<float>(side);
+    float scale = side == 1 ? 1.0f : cell * 0.9f;
+
+    std::vector<InstanceData> instances(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 center(-0.5f + cell * (static_cast<float>(i % side) + 0.5f), -0.5f + cell * (static_cast<float>(i / side) + 0.5f), 0.0f);
+
+        instances[i].model = glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(scale, scale, 1.0f));
+        instances[i].color = tints[i % tints.size()];
+        instances[i].textureIndex = textureCount == 0 ? 0 : i % textureCount;
+    }
+
+    return instances;
+}
+
+/* UV sphere with the scene quad's diameter, dense enough that per-meshlet culling has something to cull */
+static void make_sphere(uint32_t rings, uint32_t segments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    const float pi = glm::pi<float>();
+
+    vertices.clear();
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        float theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float phi = 2.0f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+            glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+            glm::vec2 uv(static_cast<float>(segment) / static_cast<float>(segments), static_cast<float>(ring) / static_cast<float>(rings));
+            vertices.push_back(Vertex{ direction * 0.5f, glm::vec3(1.0f), uv });
+        }
+    }
+
+    // Wound so triangle normals point outwards. The rows at the poles collapse to a point and only need one triangle per quad.
+    indices.clear();
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t top = ring * (segments + 1) + segment;
+            uint32_t bottom = top + segments + 1;
+
+            if (ring != 0)
+            {
+                indices.insert(indices.end(), { top, top + 1, bottom });
+            }
+            if (ring != rings - 1)
+            {
+                indices.insert(indices.end(), { top + 1, bottom + 1, bottom });
+            }
+        }
+    }
+}
+
+static auto vertex_layout(VertexFormatPreference format) -> VertexLayout
+{
+    switch (format)
+    {
+        case VertexFormatPreference::Float: return VertexLayout{};
+        case VertexFormatPreference::Half: return { PositionFormat::Half4, ColorFormat::Unorm8x4, TexCoordFormat::Half2 };
+        case VertexFormatPreference::Compact: return { PositionFormat::Snorm16x4, ColorFormat::Unorm8x4, TexCoordFormat::Unorm16x2 };
+    }
+    return VertexLayout{};
+}
+
+/* A --lod chain of the mesh, with the coarser levels appended to indices. Collapses leave the remaining triangles in their old
+ * order, so with the mesh optimizer on each level is reordered for the vertex cache like the source. */
+static auto make_lod_chain(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool optimize) -> std::vector<MeshLod>
+{
+    std::vector<MeshLod> lods = build_mesh_lods(vertices, indices, LOD_MAX_ERROR);
+    if (optimize)
+    {
+        for (size_t level = 1; level < lods.size(); level++)
+        {
+            auto first = indices.begin() + lods[level].firstIndex;
+            std::vector<uint32_t> levelIndices(first, first + lods[level].indexCount);
+            optimize_vertex_cache(levelIndices, static_cast<uint32_t>(vertices.size()));
+            std::copy(levelIndices.begin(), levelIndices.end(), first);
+        }
+    }
+    return lods;
+}
+
+/* The frame uniforms' projection for a swapchain of the given extent */
+static auto make_projection(vk::Extent2D extent) -> glm::mat4
+{
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), extent.width / (float)extent.height, NEAR_PLANE, FAR_PLANE);
+
+    // GLM was designed for OpenGL, where the Y coordinate of the clip coordinates is inverted
+    proj[1][1] *= -1.0f;
+
+    return proj;
+}
+
+/*
+ * The coarsest level of the draw whose error, scaled by the instance and projected at the nearest point of its bounding sphere,
+ * covers at most LOD_PIXEL_ERROR pixels. proj[1][1] is the focal length in half viewport heights. Matches lod_draw in cull.comp.
+ */
+static auto select_lod(const SceneDraw& sceneDraw,
+                       const std::vector<MeshLod>& lods,
+                       const glm::mat4& proj,
+                       float viewportHeight,
+                       const glm::vec3& cameraPosition) -> MeshLod
+{
+    MeshLod selected{ sceneDraw.firstIndex, sceneDraw.indexCount, 0.0f };
+    if (sceneDraw.lodCount <= 1)
+    {
+        return selected;
+    }
+
+    float distance = std::max(glm::length(sceneDraw.center - cameraPosition) - sceneDraw.radius, 0.0f);
+    float pixelsPerUnit = std::abs(proj[1][1]) * 0.5f * viewportHeight;
+    for (uint32_t level = sceneDraw.lodCount - 1; level > 0; level--)
+    {
+        const MeshLod& lod = lods[sceneDraw.firstLod + level];
+        if (lod.error * sceneDraw.lodScale * pixelsPerUnit <= LOD_PIXEL_ERROR * distance)
+        {
+            return lod;
+        }
+    }
+
+    return selected;
+}
+
 static auto read_shader_binary(const std::string& filename) -> std::vector<uint32_t>
 {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -132,6 +397,8 @@ void HelloTriangleApp::framebufferResizeCallback(GLFWwindow* window, int width,
     app->m_frameBufferResized = true;
 }
 
+HelloTriangleApp::HelloTriangleApp(const AppConfig& config) : m_config(config) {}
+
 void HelloTriangleApp::run()
 {
     init_window();
@@ -145,7 +412,7 @@ void HelloTriangleApp::init_window()
     glfwInit();
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     m_window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan - Hello Triangle", nullptr, nullptr);
 
@@ -220,8 +487,18 @@ void HelloTriangleApp::create_device()
 {
     QueueFamilyIndices indices = find_queue_families(m_physicalDevice);
 
+    // Presenting one frame late only makes sense with a frame slot to spare, and it works against the other two frame pacing modes
+    // Post-processing is the only work on the compute queue
+    m_asyncCompute = m_config.asyncCompute && m_config.postProcess && indices.computeFamily.has_value() && m_config.framesInFlight >= 2 &&
+                     !m_config.pipelined && !m_config.lowLatency;
+    m_stats.set_info("Async compute", m_asyncCompute ? "on" : "off");
+
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
     std::set uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+    if (m_asyncCompute)
+    {
+        uniqueQueueFamilies.insert(indices.computeFamily.value());
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -236,16 +513,76 @@ void HelloTriangleApp::create_device()
     vk::PhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.setSamplerAnisotropy(VK_TRUE);
 
-    vk::PhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
-    dynamicRenderingFeatures.dynamicRendering = true;
+    vk::PhysicalDeviceVulkan13Features vulkan13Features{};
+    vulkan13Features.dynamicRendering = VK_TRUE;
+    vulkan13Features.synchronization2 = VK_TRUE;
+
+    vk::PhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.pNext = &vulkan13Features;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+
+    // Bindless textures: a runtime sized, partially bound array written after it is bound and indexed per fragment
+    vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+    vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+    vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+
+    // Meshlets are only worth having with per-cluster culling. The draw count is checked against the device limit once the scene
+    // is built.
+    if (m_config.gpuCulling || m_config.meshlets)
+    {
+        m_gpuCulling = supports_gpu_culling(m_physicalDevice);
+        if (!m_gpuCulling)
+        {
+            std::cerr << "GPU culling needs multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount, falling back to CPU "
+                      << "submitted draws" << std::endl;
+        }
+    }
+    deviceFeatures.setMultiDrawIndirect(m_gpuCulling ? VK_TRUE : VK_FALSE);
+    deviceFeatures.setDrawIndirectFirstInstance(m_gpuCulling ? VK_TRUE : VK_FALSE);
+    vulkan12Features.drawIndirectCount = m_gpuCulling ? VK_TRUE : VK_FALSE;
+
+    // Optional. The scene pass records into secondaries, so its query has to be inherited.
+    vk::PhysicalDeviceFeatures supportedFeatures = m_physicalDevice.getFeatures();
+    m_pipelineStatistics = supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+    deviceFeatures.setPipelineStatisticsQuery(m_pipelineStatistics ? VK_TRUE : VK_FALSE);
+    deviceFeatures.setInheritedQueries(m_pipelineStatistics ? VK_TRUE : VK_FALSE);
+    m_stats.set_info("Pipeline statistics", m_pipelineStatistics ? "on" : "unsupported");
+
+    std::vector<const char*> extensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    presentWaitFeatures.presentWait = VK_TRUE;
+
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    presentIdFeatures.pNext = &presentWaitFeatures;
+    presentIdFeatures.presentId = VK_TRUE;
+
+    if (m_config.lowLatency)
+    {
+        m_presentWaitEnabled = supports_present_wait(m_physicalDevice);
+        if (m_presentWaitEnabled)
+        {
+            extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+            vulkan13Features.pNext = &presentIdFeatures;
+        }
+        else
+        {
+            std::cerr << "Low latency mode needs VK_KHR_present_id and VK_KHR_present_wait, falling back to late latching only"
+                      << std::endl;
+        }
+    }
+    m_stats.set_info("Low latency", !m_config.lowLatency ? "off" : m_presentWaitEnabled ? "on" : "late latch only");
 
     vk::DeviceCreateInfo createInfo{};
-    createInfo.pNext = &dynamicRenderingFeatures;
+    createInfo.pNext = &vulkan12Features;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
 #ifdef _DEBUG
     createInfo.enabledLayerCount = static_cast<uint32_t>(VALIDATION_LAYERS.size());
@@ -254,8 +591,21 @@ void HelloTriangleApp::create_device()
 
     m_device = m_physicalDevice.createDevice(createInfo);
 
+    // Extension entry points are not exported by the loader, so they are fetched from the device
+    if (m_presentWaitEnabled)
+    {
+        m_vkWaitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(m_device.getProcAddr("vkWaitForPresentKHR"));
+    }
+
+    m_graphicsQueueFamily = indices.graphicsFamily.value();
     m_graphicsQueue = m_device.getQueue(indices.graphicsFamily.value(), 0);
     m_presentQueue = m_device.getQueue(indices.presentFamily.value(), 0);
+
+    if (m_asyncCompute)
+    {
+        m_computeQueueFamily = indices.computeFamily.value();
+        m_computeQueue = m_device.getQueue(m_computeQueueFamily, 0);
+    }
 }
 
 void HelloTriangleApp::create_allocator()
@@ -268,7 +618,7 @@ void HelloTriangleApp::create_allocator()
     vmaCreateAllocator(&allocatorInfo, &m_allocator);
 }
 
-void HelloTriangleApp::create_swapchain()
+void HelloTriangleApp::create_swapchain(vk::SwapchainKHR oldSwapchain)
 {
     SwapChainSupportDetails swapChainSupport = query_swap_chain_support(m_physicalDevice);
 
@@ -276,12 +626,7 @@ void HelloTriangleApp::create_swapchain()
     vk::PresentModeKHR presentMode = choose_swap_present_mode(swapChainSupport.presentModes);
     vk::Extent2D extent = choose_swap_extent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
-
-    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
-    {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
-    }
+    uint32_t imageCount = choose_swap_image_count(swapChainSupport.capabilities);
 
     vk::SwapchainCreateInfoKHR createInfo{};
     createInfo.surface = m_surface;
@@ -311,6 +656,7 @@ void HelloTriangleApp::create_swapchain()
     createInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
+    createInfo.oldSwapchain = oldSwapchain;
 
     m_swapChain = m_device.createSwapchainKHR(createInfo);
 
@@ -318,6 +664,22 @@ void HelloTriangleApp::create_swapchain()
 
     m_swapChainImageFormat = surfaceFormat.format;
     m_swapChainExtent = extent;
+    m_presentMode = presentMode;
+
+    // Present ids are per swapchain, and the refresh rate may have changed with it
+    m_lastPresentId = 0;
+    m_lastPresentDoneTime = {};
+    m_refreshIntervalMs = 0.0;
+
+    if (!oldSwapchain)
+    {
+        std::cout << "Swapchain: " << m_swapChainImages.size() << " images (requested " << imageCount << "), present mode "
+                  << vk::to_string(presentMode) << ", " << m_config.framesInFlight << " frames in flight" << std::endl;
+    }
+
+    m_stats.set_info("Frames in flight", std::to_string(m_config.framesInFlight));
+    m_stats.set_info("Swapchain images", std::to_string(m_swapChainImages.size()));
+    m_stats.set_info("Present mode", vk::to_string(presentMode));
 
     m_swapChainImageViews.resize(m_swapChainImages.size());
 
@@ -331,38 +693,309 @@ void HelloTriangleApp::prepare_frames()
 {
     vk::SemaphoreCreateInfo semaphoreInfo{};
 
-    vk::FenceCreateInfo fenceInfo{};
-    fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
+    // A single timeline tracks every frame; its value is the number of frames the GPU has finished
+    vk::SemaphoreTypeCreateInfo timelineInfo{};
+    timelineInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+    timelineInfo.initialValue = 0;
+
+    vk::SemaphoreCreateInfo timelineSemaphoreInfo{};
+    timelineSemaphoreInfo.pNext = &timelineInfo;
+    m_frameTimeline = m_device.createSemaphore(timelineSemaphoreInfo);
+    m_batchTimeline = m_device.createSemaphore(timelineSemaphoreInfo);
+
+    vk::QueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.queryType = vk::QueryType::eTimestamp;
+    queryPoolInfo.queryCount = MAX_TIMESTAMPS;
+
+    vk::QueryPoolCreateInfo statisticsPoolInfo{};
+    statisticsPoolInfo.queryType = vk::QueryType::ePipelineStatistics;
+    statisticsPoolInfo.queryCount = MAX_TIMESTAMPS;
+    statisticsPoolInfo.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+    m_timestampPeriod = m_physicalDevice.getProperties().limits.timestampPeriod;
+
+    uint32_t recordThreadCount = m_config.recordThreads;
+    if (recordThreadCount == 0)
+    {
+        recordThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 16u);
+    }
+    m_recordThreads = std::make_unique<ThreadPool>(recordThreadCount);
+
+    m_stats.set_info("Record threads", std::to_string(recordThreadCount));
+    m_stats.set_info("Draws", std::to_string(m_config.drawCount));
+    m_stats.set_info("Instancing", m_config.instancing ? "on" : "off");
+    m_stats.set_info("Command cache", m_config.commandCache ? "on" : "off");
 
+    m_frames.resize(m_config.framesInFlight);
     for (auto& frame : m_frames)
     {
         vk::CommandPoolCreateInfo poolInfo{};
         poolInfo.queueFamilyIndex = m_graphicsQueueFamily;
         frame.cmdPool = m_device.createCommandPool(poolInfo);
 
+        // Without the cache, secondaries are recorded every frame and reset with their pool, so the pools are marked transient
+        vk::CommandPoolCreateInfo threadPoolInfo{};
+        threadPoolInfo.flags = m_config.commandCache ? vk::CommandPoolCreateFlags{} : vk::CommandPoolCreateFlagBits::eTransient;
+        threadPoolInfo.queueFamilyIndex = m_graphicsQueueFamily;
+
+        frame.threadCommands.resize(recordThreadCount);
+        for (auto& threadCommands : frame.threadCommands)
+        {
+            threadCommands.cmdPool = m_device.createCommandPool(threadPoolInfo);
+        }
+
         vk::CommandBufferAllocateInfo allocInfo{};
         allocInfo.setCommandPool(frame.cmdPool);
         allocInfo.setCommandBufferCount(1);
         allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
         frame.cmd = m_device.allocateCommandBuffers(allocInfo)[0];
 
+        // Cached primaries are re-recorded one at a time, so they need individual resets
+        vk::CommandPoolCreateInfo cachedPoolInfo{};
+        cachedPoolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+        cachedPoolInfo.queueFamilyIndex = m_graphicsQueueFamily;
+        frame.cachedCmdPool = m_device.createCommandPool(cachedPoolInfo);
+
+        if (m_asyncCompute)
+        {
+            vk::CommandPoolCreateInfo computePoolInfo{};
+            computePoolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+            computePoolInfo.queueFamilyIndex = m_computeQueueFamily;
+            frame.computeCmdPool = m_device.createCommandPool(computePoolInfo);
+
+            vk::CommandPoolCreateInfo presentPoolInfo{};
+            presentPoolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+            presentPoolInfo.queueFamilyIndex = m_graphicsQueueFamily;
+            frame.presentCmdPool = m_device.createCommandPool(presentPoolInfo);
+
+            vk::CommandBufferAllocateInfo presentAllocInfo{};
+            presentAllocInfo.setCommandPool(frame.presentCmdPool);
+            presentAllocInfo.setCommandBufferCount(1);
+            presentAllocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+            frame.presentCmd = m_device.allocateCommandBuffers(presentAllocInfo)[0];
+        }
+
         frame.imageReadySemaphore = m_device.createSemaphore(semaphoreInfo);
         frame.renderDoneSemaphore = m_device.createSemaphore(semaphoreInfo);
 
-        frame.cmdExecFence = m_device.createFence(fenceInfo);
+        frame.timestampPool = m_device.createQueryPool(queryPoolInfo);
+        if (m_pipelineStatistics)
+        {
+            frame.statisticsPool = m_device.createQueryPool(statisticsPoolInfo);
+        }
+    }
+}
+
+void HelloTriangleApp::build_render_graph()
+{
+    // The old graphs' images may still be in use by frames in flight
+    for (auto& oldGraph : m_renderGraphs)
+    {
+        defer_destroy([oldGraph] { oldGraph->destroy(); });
+    }
+    m_renderGraphs.clear();
+
+    size_t graphCount = m_asyncCompute ? m_frames.size() : 1;
+    for (size_t i = 0; i < graphCount; i++)
+    {
+        auto graphPtr = std::make_shared<RenderGraph>(m_device, m_allocator);
+        RenderGraph& graph = *graphPtr;
+
+        // Without a separate family the post pass simply runs on the graphics queue, in the same batch as everything else
+        graph.set_queue_families(m_graphicsQueueFamily, m_asyncCompute ? m_computeQueueFamily : m_graphicsQueueFamily);
+
+        // The acquire semaphore wait is at colour attachment output, so the first barrier chains onto it
+        m_rgSwapchain = graph.import_image(
+            "swapchain",
+            { m_swapChainImageFormat, m_swapChainExtent },
+            { vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eNone },
+            { vk::ImageLayout::ePresentSrcKHR, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone });
+        graph.mark_output(m_rgSwapchain);
+
+        // On the direct path the scene passes target the swapchain image itself. Their vertex work still runs ahead of the
+        // acquire, since only colour attachment output waits for it.
+        m_rgSceneColor = m_directToSwapchain ? m_rgSwapchain
+                                             : graph.create_image("scene_color", { m_offscreenPass.colorFormat, m_swapChainExtent });
+        m_rgSceneDepth = graph.create_image("scene_depth", { m_offscreenPass.depthFormat, m_swapChainExtent });
+
+        if (m_gpuCulling)
+        {
+            // Writes buffers only, which the graph does not track, so it is kept alive explicitly
+            graph.add_compute_pass(
+                "cull",
+                [](RGPassBuilder& builder) { builder.set_side_effects(); },
+                [this](const RGPassContext& context) { record_cull_pass(context.cmd, CULL_PHASE_EARLY); });
+        }
+
+        auto addColorPass = [&](uint32_t cullPhases) {
+            graph.add_graphics_pass(
+                "offscreen",
+                [this](RGPassBuilder& builder) {
+                    builder.write_color(
+                        m_rgSceneColor, vk::AttachmentLoadOp::eClear, vk::ClearColorValue(0.232f, 0.304f, 0.540f, 1.0f));
+                    if (m_config.depthPrepass)
+                    {
+                        builder.read(m_rgSceneDepth, RGAccess::DepthRead);
+                    }
+                    else
+                    {
+                        builder.write_depth(m_rgSceneDepth);
+                    }
+                    builder.set_secondary_command_buffers();
+                    builder.set_pipeline_statistics();
+                    builder.set_render_extent([this] { return m_offscreenPass.renderExtent; });
+                },
+                [this, cullPhases](const RGPassContext& context) { record_offscreen_pass(context, cullPhases); });
+        };
+
+        // Whichever pass lays down depth first is split in two by occlusion culling, around the pyramid build and the late cull
+        if (m_config.depthPrepass)
+        {
+            graph.add_graphics_pass(
+                "depth_prepass",
+                [this](RGPassBuilder& builder) {
+                    builder.write_depth(m_rgSceneDepth);
+                    builder.set_pipeline_statistics();
+                    builder.set_render_extent([this] { return m_offscreenPass.renderExtent; });
+                },
+                [this](const RGPassContext& context) { record_depth_prepass(context.cmd); });
+        }
+        else
+        {
+            addColorPass(CULL_PHASE_EARLY);
+        }
+
+        if (m_occlusionCulling)
+        {
+            // The pyramid is not a graph resource, its accesses are ordered by the passes themselves like the cull buffers
+            graph.add_compute_pass(
+                "depth_pyramid",
+                [this](RGPassBuilder& builder) {
+                    builder.read(m_rgSceneDepth, RGAccess::SampledCompute);
+                    builder.set_side_effects();
+                },
+                [this](const RGPassContext& context) { record_depth_pyramid_pass(context.cmd); });
+
+            graph.add_compute_pass(
+                "cull_late",
+                [](RGPassBuilder& builder) { builder.set_side_effects(); },
+                [this](const RGPassContext& context) { record_cull_pass(context.cmd, CULL_PHASE_LATE); });
+
+            graph.add_graphics_pass(
+                m_config.depthPrepass ? "depth_prepass_late" : "offscreen_late",
+                [this](RGPassBuilder& builder) {
+                    if (!m_config.depthPrepass)
+                    {
+                        builder.write_color(m_rgSceneColor, vk::AttachmentLoadOp::eLoad);
+                    }
+                    builder.write_depth(m_rgSceneDepth, vk::AttachmentLoadOp::eLoad);
+                    builder.set_pipeline_statistics();
+                    builder.set_render_extent([this] { return m_offscreenPass.renderExtent; });
+                },
+                [this](const RGPassContext& context) {
+                    vk::Pipeline pipeline = m_config.depthPrepass ? m_offscreenPass.depthPrepassPipeline : m_offscreenPass.pipeline;
+                    record_offscreen_draws(context.cmd, pipeline, 0, m_instanceCount, CULL_PHASE_LATE);
+                });
+        }
+
+        if (m_config.depthPrepass)
+        {
+            addColorPass(m_occlusionCulling ? CULL_PHASE_EARLY | CULL_PHASE_LATE : CULL_PHASE_EARLY);
+        }
+
+        if (!m_directToSwapchain)
+        {
+            m_rgPostColor = graph.create_image("post_color", { vk::Format::eR16G16B16A16Sfloat, m_swapChainExtent });
+
+            graph.add_compute_pass(
+                "post",
+                [this](RGPassBuilder& builder) {
+                    builder.read(m_rgSceneColor, RGAccess::SampledCompute);
+                    builder.write(m_rgPostColor, RGAccess::StorageWriteCompute);
+                },
+                [this](const RGPassContext& context) { record_post_pass(context.cmd); },
+                RGQueue::AsyncCompute);
+
+            graph.add_graphics_pass(
+                "final",
+                [this](RGPassBuilder& builder) {
+                    builder.read(m_rgPostColor, RGAccess::SampledFragment);
+                    builder.write_color(m_rgSwapchain, vk::AttachmentLoadOp::eDontCare);
+                },
+                [this](const RGPassContext& context) { record_final_pass(context.cmd); });
+        }
+
+        graph.compile();
+
+        // The frame is presented from the graph's last batch, everything before it is submitted ahead
+        if (graph.batch_queue(graph.batch_count() - 1) != RGQueue::Graphics)
+        {
+            throw std::runtime_error("Render graph must end on the graphics queue!");
+        }
+
+        m_renderGraphs.push_back(std::move(graphPtr));
     }
+
+    const RenderGraph& graph = *m_renderGraphs.front();
+    m_offscreenPass.extent = graph.extent(m_rgSceneColor);
+    update_render_extent();
+
+    std::vector<std::string> passNames = graph.executed_pass_names();
+    if (passNames.size() * 2 > MAX_TIMESTAMPS)
+    {
+        throw std::runtime_error("Render graph has more passes than timestamp queries!");
+    }
+
+    m_stats.set_info("Render graph passes", std::to_string(passNames.size()));
+    m_stats.set_info("Render graph batches", std::to_string(graph.batch_count()));
+    m_stats.set_info("Render graph barriers", std::to_string(graph.barrier_count()));
+    m_stats.set_info("Render graph aliased images", std::to_string(graph.aliased_image_count()));
+
+    // Full screen traffic of composing the scene: the post pass reads the RGBA8 scene and writes RGBA16F, the final pass reads
+    // that back and writes the 32 bit swapchain. The direct path has none of it.
+    uint64_t pixelCount = static_cast<uint64_t>(m_swapChainExtent.width) * m_swapChainExtent.height;
+    uint64_t compositeBytes = m_directToSwapchain ? 0 : pixelCount * (4 + 8 + 8 + 4);
+    m_stats.set_info("Composite traffic", std::to_string(compositeBytes / 1024) + " KiB per frame");
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::update_render_extent()
+{
+    float scale = m_resolution.scale();
+    m_offscreenPass.renderExtent.width = std::max(1u, static_cast<uint32_t>(std::lround(m_offscreenPass.extent.width * scale)));
+    m_offscreenPass.renderExtent.height = std::max(1u, static_cast<uint32_t>(std::lround(m_offscreenPass.extent.height * scale)));
+
+    // Viewports, render areas and push constants of recorded commands all depend on it
+    invalidate_recorded_commands();
+}
+
+auto HelloTriangleApp::frame_graph(uint32_t frameIndex) const -> RenderGraph&
+{
+    return *m_renderGraphs[frameIndex % m_renderGraphs.size()];
 }
 
 void HelloTriangleApp::create_offscreen_pass_resources()
 {
-    create_image(WIDTH,
-                 HEIGHT,
-                 vk::Format::eR8G8B8A8Srgb,
-                 vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
-                 m_offscreenPass.image,
-                 m_offscreenPass.allocation);
+    m_offscreenPass.depthFormat = find_depth_format();
+    m_stats.set_info("Depth format", vk::to_string(m_offscreenPass.depthFormat));
+    m_stats.set_info("Depth pre-pass", m_config.depthPrepass ? "on" : "off");
 
-    m_offscreenPass.view = create_image_view(m_offscreenPass.image, vk::Format::eR8G8B8A8Srgb);
+    m_directToSwapchain = !m_config.postProcess;
+    m_offscreenPass.colorFormat = m_directToSwapchain ? m_swapChainImageFormat : vk::Format::eR8G8B8A8Srgb;
+    m_stats.set_info("Scene target", m_directToSwapchain ? "swapchain" : "offscreen");
+
+    // Rendering straight into the swapchain leaves no pass to upscale in
+    m_resolution = ResolutionController(m_directToSwapchain ? 0.0 : m_config.dynamicResolutionMs);
+    if (m_config.dynamicResolutionMs > 0.0 && m_directToSwapchain)
+    {
+        m_stats.set_info("Dynamic resolution", "off, needs post-processing");
+    }
+    else
+    {
+        std::string budget = std::to_string(m_config.dynamicResolutionMs) + " ms budget";
+        m_stats.set_info("Dynamic resolution", m_resolution.enabled() ? budget : "off");
+    }
 
     vk::DescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.setBinding(0);
@@ -370,141 +1003,490 @@ void HelloTriangleApp::create_offscreen_pass_resources()
     uboLayoutBinding.setDescriptorCount(1);
     uboLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eVertex);
 
-    vk::DescriptorSetLayoutBinding samplerLayoutBinding{};
-    samplerLayoutBinding.setBinding(1);
-    samplerLayoutBinding.setDescriptorCount(1);
-    samplerLayoutBinding.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    samplerLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eFragment);
-
-    std::vector<vk::DescriptorSetLayoutBinding> bindings = {
-        uboLayoutBinding,
-        samplerLayoutBinding,
-    };
+    // Textures come from the bindless set bound as set 1
     vk::DescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.setBindings(bindings);
+    layoutInfo.setBindings(uboLayoutBinding);
     m_offscreenPass.descriptorSetLayout = m_device.createDescriptorSetLayout(layoutInfo);
 
+    // One set per frame in flight, each pointing at that frame's uniform buffer
+    std::vector<vk::DescriptorSetLayout> setLayouts(m_frames.size(), m_offscreenPass.descriptorSetLayout);
+
     vk::DescriptorSetAllocateInfo allocInfo{};
     allocInfo.setDescriptorPool(m_descriptorPool);
-    allocInfo.setSetLayouts(m_offscreenPass.descriptorSetLayout);
-    allocInfo.setDescriptorSetCount(1);
-    m_offscreenPass.descriptorSet = m_device.allocateDescriptorSets(allocInfo)[0];
-
-    vk::DescriptorBufferInfo bufferInfo{};
-    bufferInfo.setBuffer(m_uniformBuffers[0]);
-    bufferInfo.setRange(sizeof(UniformBufferObject));
-
-    vk::WriteDescriptorSet writeUbo{};
-    writeUbo.setDstSet(m_offscreenPass.descriptorSet);
-    writeUbo.setDstBinding(0);
-    writeUbo.setDescriptorCount(1);
-    writeUbo.setDescriptorType(vk::DescriptorType::eUniformBuffer);
-    writeUbo.setBufferInfo(bufferInfo);
-
-    vk::DescriptorImageInfo imageInfo{};
-    imageInfo.setImageView(m_texture.view);
-    imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-    imageInfo.setSampler(m_sampler);
-
-    vk::WriteDescriptorSet writeTexture{};
-    writeTexture.setDstSet(m_offscreenPass.descriptorSet);
-    writeTexture.setDstBinding(1);
-    writeTexture.setDescriptorCount(1);
-    writeTexture.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    writeTexture.setImageInfo(imageInfo);
-    m_device.updateDescriptorSets({ writeUbo, writeTexture }, {});
+    allocInfo.setSetLayouts(setLayouts);
+    m_offscreenPass.descriptorSets = m_device.allocateDescriptorSets(allocInfo);
+
+    for (size_t i = 0; i < m_offscreenPass.descriptorSets.size(); i++)
+    {
+        vk::DescriptorBufferInfo bufferInfo{};
+        bufferInfo.setBuffer(m_uniformBuffers[i]);
+        bufferInfo.setRange(sizeof(FrameUniforms));
+
+        vk::WriteDescriptorSet writeUbo{};
+        writeUbo.setDstSet(m_offscreenPass.descriptorSets[i]);
+        writeUbo.setDstBinding(0);
+        writeUbo.setDescriptorCount(1);
+        writeUbo.setDescriptorType(vk::DescriptorType::eUniformBuffer);
+        writeUbo.setBufferInfo(bufferInfo);
+        m_device.updateDescriptorSets(writeUbo, {});
+    }
 }
 
-void HelloTriangleApp::create_final_pass_resources()
+void HelloTriangleApp::create_cull_pass_resources()
 {
-    vk::DescriptorSetLayoutBinding binding{};
-    binding.setBinding(0);
-    binding.setDescriptorCount(1);
-    binding.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    binding.setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    std::array<vk::DescriptorSetLayoutBinding, 7> bindings{};
+    bindings[0].setBinding(0);
+    bindings[0].setDescriptorCount(1);
+    bindings[0].setDescriptorType(vk::DescriptorType::eUniformBuffer);
+    bindings[0].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    // Cull objects, draw commands, counts, late draw commands, the objects deferred to the late phase and the LOD table
+    for (uint32_t binding = 1; binding < bindings.size(); binding++)
+    {
+        bindings[binding].setBinding(binding);
+        bindings[binding].setDescriptorCount(1);
+        bindings[binding].setDescriptorType(vk::DescriptorType::eStorageBuffer);
+        bindings[binding].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    }
 
     vk::DescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.setBindings(binding);
-    m_finalPass.descriptorSetLayout = m_device.createDescriptorSetLayout(layoutInfo);
+    layoutInfo.setBindings(bindings);
+    m_cullPass.descriptorSetLayout = m_device.createDescriptorSetLayout(layoutInfo);
+
+    std::vector<vk::DescriptorSetLayout> setLayouts(m_frames.size(), m_cullPass.descriptorSetLayout);
 
     vk::DescriptorSetAllocateInfo allocInfo{};
     allocInfo.setDescriptorPool(m_descriptorPool);
-    allocInfo.setSetLayouts(m_finalPass.descriptorSetLayout);
-    allocInfo.setDescriptorSetCount(1);
-    m_finalPass.descriptorSet = m_device.allocateDescriptorSets(allocInfo)[0];
+    allocInfo.setSetLayouts(setLayouts);
+    m_cullPass.descriptorSets = m_device.allocateDescriptorSets(allocInfo);
 
-    vk::DescriptorImageInfo imageInfo{};
-    imageInfo.setImageView(m_offscreenPass.view);
-    imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-    imageInfo.setSampler(m_sampler);
+    vk::DeviceSize drawBufferSize = sizeof(vk::DrawIndexedIndirectCommand) * m_cullObjectCount;
 
-    vk::WriteDescriptorSet write{};
-    write.setDstSet(m_finalPass.descriptorSet);
-    write.setDstBinding(0);
-    write.setDescriptorCount(1);
-    write.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    write.setImageInfo(imageInfo);
-    m_device.updateDescriptorSets(write, {});
+    m_cullPass.drawBuffers.resize(m_frames.size());
+    m_cullPass.drawBuffersMemory.resize(m_frames.size());
+    m_cullPass.countBuffers.resize(m_frames.size());
+    m_cullPass.countBuffersMemory.resize(m_frames.size());
+    m_cullPass.lateDrawBuffers.resize(m_frames.size());
+    m_cullPass.lateDrawBuffersMemory.resize(m_frames.size());
+    m_cullPass.deferredBuffers.resize(m_frames.size());
+    m_cullPass.deferredBuffersMemory.resize(m_frames.size());
+
+    for (size_t i = 0; i < m_frames.size(); i++)
+    {
+        create_buffer(drawBufferSize,
+                      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+                      m_cullPass.drawBuffers[i],
+                      m_cullPass.drawBuffersMemory[i]);
+
+        create_buffer(sizeof(CullCounts),
+                      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+                          vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+                      m_cullPass.countBuffers[i],
+                      m_cullPass.countBuffersMemory[i]);
+
+        create_buffer(drawBufferSize,
+                      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+                      m_cullPass.lateDrawBuffers[i],
+                      m_cullPass.lateDrawBuffersMemory[i]);
+
+        create_buffer(sizeof(uint32_t) * m_cullObjectCount,
+                      vk::BufferUsageFlagBits::eStorageBuffer,
+                      vk::MemoryPropertyFlagBits::eDeviceLocal,
+                      m_cullPass.deferredBuffers[i],
+                      m_cullPass.deferredBuffersMemory[i]);
+
+        // Counts are copied here at the end of the cull, for the stats once the frame's fence has signalled
+        create_buffer(sizeof(CullCounts),
+                      vk::BufferUsageFlagBits::eTransferDst,
+                      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                      m_frames[i].cullCountsReadback,
+                      m_frames[i].cullCountsReadbackMemory);
+
+        std::array<vk::DescriptorBufferInfo, 7> bufferInfos{};
+        bufferInfos[0].setBuffer(m_uniformBuffers[i]).setRange(sizeof(FrameUniforms));
+        bufferInfos[1].setBuffer(m_cullObjectBuffer).setRange(VK_WHOLE_SIZE);
+        bufferInfos[2].setBuffer(m_cullPass.drawBuffers[i]).setRange(VK_WHOLE_SIZE);
+        bufferInfos[3].setBuffer(m_cullPass.countBuffers[i]).setRange(VK_WHOLE_SIZE);
+        bufferInfos[4].setBuffer(m_cullPass.lateDrawBuffers[i]).setRange(VK_WHOLE_SIZE);
+        bufferInfos[5].setBuffer(m_cullPass.deferredBuffers[i]).setRange(VK_WHOLE_SIZE);
+        bufferInfos[6].setBuffer(m_lodBuffer).setRange(VK_WHOLE_SIZE);
+
+        std::array<vk::WriteDescriptorSet, 7> writes{};
+        for (uint32_t binding = 0; binding < writes.size(); binding++)
+        {
+            writes[binding].setDstSet(m_cullPass.descriptorSets[i]);
+            writes[binding].setDstBinding(binding);
+            writes[binding].setDescriptorCount(1);
+            writes[binding].setDescriptorType(bindings[binding].descriptorType);
+            writes[binding].setBufferInfo(bufferInfos[binding]);
+        }
+        m_device.updateDescriptorSets(writes, {});
+    }
 }
 
-void HelloTriangleApp::create_offscreen_pipeline()
+void HelloTriangleApp::create_depth_pyramid_pass_resources()
 {
-    /* Programmable Pipeline Stages */
+    std::array<vk::DescriptorSetLayoutBinding, 2> buildBindings{};
+    buildBindings[0].setBinding(0);
+    buildBindings[0].setDescriptorCount(1);
+    buildBindings[0].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    buildBindings[0].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    buildBindings[1].setBinding(1);
+    buildBindings[1].setDescriptorCount(1);
+    buildBindings[1].setDescriptorType(vk::DescriptorType::eStorageImage);
+    buildBindings[1].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo buildLayoutInfo{};
+    buildLayoutInfo.setBindings(buildBindings);
+    m_depthPyramid.buildSetLayout = m_device.createDescriptorSetLayout(buildLayoutInfo);
+
+    vk::DescriptorSetLayoutBinding sampleBinding{};
+    sampleBinding.setBinding(0);
+    sampleBinding.setDescriptorCount(1);
+    sampleBinding.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    sampleBinding.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo sampleLayoutInfo{};
+    sampleLayoutInfo.setBindings(sampleBinding);
+    m_depthPyramid.sampleSetLayout = m_device.createDescriptorSetLayout(sampleLayoutInfo);
+}
 
-    auto vertShaderCode = read_shader_binary("shaders/shader.vert.spv");
-    auto fragShaderCode = read_shader_binary("shaders/shader.frag.spv");
+void HelloTriangleApp::create_depth_pyramid()
+{
+    if (m_depthPyramid.image)
+    {
+        DepthPyramid oldPyramid = m_depthPyramid;
+        defer_destroy([this, oldPyramid] { destroy_depth_pyramid(oldPyramid); });
+    }
 
-    vk::ShaderModule vertShaderModule = create_shader_module(vertShaderCode);
-    vk::ShaderModule fragShaderModule = create_shader_module(fragShaderCode);
+    // Every graph's scene depth has the same extent. The first level matches it, so the build starts with a 1:1 copy.
+    vk::Extent2D extent = m_renderGraphs.front()->extent(m_rgSceneDepth);
+    m_depthPyramid.extent = extent;
+    m_depthPyramid.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+
+    create_image(extent.width,
+                 extent.height,
+                 vk::Format::eR32Sfloat,
+                 vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                 m_depthPyramid.image,
+                 m_depthPyramid.allocation,
+                 m_depthPyramid.mipLevels);
+    m_depthPyramid.view = create_image_view(m_depthPyramid.image, vk::Format::eR32Sfloat, m_depthPyramid.mipLevels);
+
+    m_depthPyramid.mipViews.resize(m_depthPyramid.mipLevels);
+    for (uint32_t level = 0; level < m_depthPyramid.mipLevels; level++)
+    {
+        vk::ImageViewCreateInfo viewInfo{};
+        viewInfo.image = m_depthPyramid.image;
+        viewInfo.viewType = vk::ImageViewType::e2D;
+        viewInfo.format = vk::Format::eR32Sfloat;
+        viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+        viewInfo.subresourceRange.baseMipLevel = level;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        m_depthPyramid.mipViews[level] = m_device.createImageView(viewInfo);
+    }
 
-    vk::PipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.stage = vk::ShaderStageFlagBits::eVertex;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
+    // The pyramid stays in the general layout. Until the first build it holds the far plane, which occludes nothing.
+    vk::CommandBuffer cmd = begin_single_time_commands();
 
-    vk::PipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.stage = vk::ShaderStageFlagBits::eFragment;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, m_depthPyramid.mipLevels, 0, 1);
 
-    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
+    vk::ImageMemoryBarrier2 generalBarrier{};
+    generalBarrier.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+    generalBarrier.dstStageMask = vk::PipelineStageFlagBits2::eClear;
+    generalBarrier.dstAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    generalBarrier.oldLayout = vk::ImageLayout::eUndefined;
+    generalBarrier.newLayout = vk::ImageLayout::eGeneral;
+    generalBarrier.image = m_depthPyramid.image;
+    generalBarrier.subresourceRange = range;
 
-    /* Fixed Function Pipeline Stages */
+    vk::DependencyInfo generalDependency{};
+    generalDependency.setImageMemoryBarriers(generalBarrier);
+    cmd.pipelineBarrier2(generalDependency);
 
-    // Vertex Input
-    vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
+    cmd.clearColorImage(m_depthPyramid.image, vk::ImageLayout::eGeneral, vk::ClearColorValue(1.0f, 1.0f, 1.0f, 1.0f), range);
 
-    auto bindingDescription = Vertex::get_binding_description();
-    auto attribDescriptions = Vertex::get_attrib_descriptions();
+    vk::ImageMemoryBarrier2 clearBarrier = generalBarrier;
+    clearBarrier.srcStageMask = vk::PipelineStageFlagBits2::eClear;
+    clearBarrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    clearBarrier.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+    clearBarrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageWrite;
+    clearBarrier.oldLayout = vk::ImageLayout::eGeneral;
 
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribDescriptions.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attribDescriptions.data();
+    vk::DependencyInfo clearDependency{};
+    clearDependency.setImageMemoryBarriers(clearBarrier);
+    cmd.pipelineBarrier2(clearDependency);
 
-    // Input Assembly
-    vk::PipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    end_single_time_commands(cmd);
 
-    // Viewport and Scissors
-    vk::Viewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(m_swapChainExtent.width);
-    viewport.height = static_cast<float>(m_swapChainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+    // Sets are allocated from a pool of the pyramid's own, so they are released with it
+    auto graphCount = static_cast<uint32_t>(m_renderGraphs.size());
+    uint32_t buildSetCount = m_occlusionCulling ? graphCount * m_depthPyramid.mipLevels : 0;
 
-    vk::Rect2D scissor{};
-    scissor.offset = vk::Offset2D(0, 0);
-    scissor.extent = m_swapChainExtent;
+    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eCombinedImageSampler;
+    poolSizes[0].descriptorCount = buildSetCount + 1;
+    poolSizes[1].type = vk::DescriptorType::eStorageImage;
+    poolSizes[1].descriptorCount = std::max(buildSetCount, 1u);
 
-    vk::PipelineViewportStateCreateInfo viewportState{};
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+    vk::DescriptorPoolCreateInfo poolInfo{};
+    poolInfo.setPoolSizes(poolSizes);
+    poolInfo.setMaxSets(buildSetCount + 1);
+    m_depthPyramid.descriptorPool = m_device.createDescriptorPool(poolInfo);
+
+    vk::DescriptorSetAllocateInfo sampleAllocInfo{};
+    sampleAllocInfo.setDescriptorPool(m_depthPyramid.descriptorPool);
+    sampleAllocInfo.setSetLayouts(m_depthPyramid.sampleSetLayout);
+    m_depthPyramid.sampleSet = m_device.allocateDescriptorSets(sampleAllocInfo).front();
+
+    vk::Sampler sampler = m_samplerCache.get(m_samplerCache.make_info(vk::Filter::eNearest, vk::SamplerAddressMode::eClampToEdge));
+
+    vk::DescriptorImageInfo sampleInfo{};
+    sampleInfo.setImageView(m_depthPyramid.view);
+    sampleInfo.setImageLayout(vk::ImageLayout::eGeneral);
+    sampleInfo.setSampler(sampler);
+
+    vk::WriteDescriptorSet writeSample{};
+    writeSample.setDstSet(m_depthPyramid.sampleSet);
+    writeSample.setDstBinding(0);
+    writeSample.setDescriptorCount(1);
+    writeSample.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    writeSample.setImageInfo(sampleInfo);
+    m_device.updateDescriptorSets(writeSample, {});
+
+    // Without occlusion culling the cull pipeline still has the set bound, but the pyramid is never built
+    m_depthPyramid.buildSets.clear();
+    if (buildSetCount > 0)
+    {
+        std::vector<vk::DescriptorSetLayout> buildLayouts(buildSetCount, m_depthPyramid.buildSetLayout);
+        vk::DescriptorSetAllocateInfo buildAllocInfo{};
+        buildAllocInfo.setDescriptorPool(m_depthPyramid.descriptorPool);
+        buildAllocInfo.setSetLayouts(buildLayouts);
+        m_depthPyramid.buildSets = m_device.allocateDescriptorSets(buildAllocInfo);
+    }
+
+    for (size_t set = 0; set < m_depthPyramid.buildSets.size(); set++)
+    {
+        uint32_t graph = static_cast<uint32_t>(set) / m_depthPyramid.mipLevels;
+        uint32_t level = static_cast<uint32_t>(set) % m_depthPyramid.mipLevels;
+
+        // Levels other than the first use individual mip views, since a storage image view can only cover one level
+        vk::DescriptorImageInfo sourceInfo{};
+        sourceInfo.setSampler(sampler);
+        if (level == 0)
+        {
+            sourceInfo.setImageView(m_renderGraphs[graph]->view(m_rgSceneDepth));
+            sourceInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
+        else
+        {
+            sourceInfo.setImageView(m_depthPyramid.mipViews[level - 1]);
+            sourceInfo.setImageLayout(vk::ImageLayout::eGeneral);
+        }
+
+        vk::DescriptorImageInfo targetInfo{};
+        targetInfo.setImageView(m_depthPyramid.mipViews[level]);
+        targetInfo.setImageLayout(vk::ImageLayout::eGeneral);
+
+        vk::WriteDescriptorSet writeSource{};
+        writeSource.setDstSet(m_depthPyramid.buildSets[set]);
+        writeSource.setDstBinding(0);
+        writeSource.setDescriptorCount(1);
+        writeSource.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+        writeSource.setImageInfo(sourceInfo);
+
+        vk::WriteDescriptorSet writeTarget{};
+        writeTarget.setDstSet(m_depthPyramid.buildSets[set]);
+        writeTarget.setDstBinding(1);
+        writeTarget.setDescriptorCount(1);
+        writeTarget.setDescriptorType(vk::DescriptorType::eStorageImage);
+        writeTarget.setImageInfo(targetInfo);
+
+        m_device.updateDescriptorSets({ writeSource, writeTarget }, {});
+    }
+
+    m_stats.set_info("Depth pyramid",
+                     std::to_string(extent.width) + "x" + std::to_string(extent.height) + ", " + std::to_string(m_depthPyramid.mipLevels) +
+                         " levels");
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::destroy_depth_pyramid(const DepthPyramid& pyramid)
+{
+    m_device.destroy(pyramid.descriptorPool);
+    for (vk::ImageView view : pyramid.mipViews)
+    {
+        m_device.destroy(view);
+    }
+    m_device.destroy(pyramid.view);
+    vmaDestroyImage(m_allocator, pyramid.image, pyramid.allocation);
+}
+
+void HelloTriangleApp::create_post_pass_resources()
+{
+    vk::DescriptorSetLayoutBinding sourceBinding{};
+    sourceBinding.setBinding(0);
+    sourceBinding.setDescriptorCount(1);
+    sourceBinding.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    sourceBinding.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutBinding targetBinding{};
+    targetBinding.setBinding(1);
+    targetBinding.setDescriptorCount(1);
+    targetBinding.setDescriptorType(vk::DescriptorType::eStorageImage);
+    targetBinding.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    std::vector<vk::DescriptorSetLayoutBinding> bindings = {
+        sourceBinding,
+        targetBinding,
+    };
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.setBindings(bindings);
+    m_postPass.descriptorSetLayout = m_device.createDescriptorSetLayout(layoutInfo);
+}
+
+void HelloTriangleApp::create_final_pass_resources()
+{
+    vk::DescriptorSetLayoutBinding binding{};
+    binding.setBinding(0);
+    binding.setDescriptorCount(1);
+    binding.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    binding.setStageFlags(vk::ShaderStageFlagBits::eFragment);
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.setBindings(binding);
+    m_finalPass.descriptorSetLayout = m_device.createDescriptorSetLayout(layoutInfo);
+}
+
+void HelloTriangleApp::write_graph_descriptors()
+{
+    // Always allocate fresh sets - the previous ones may still be referenced by frames in flight
+    std::vector<vk::DescriptorSetLayout> postLayouts(m_renderGraphs.size(), m_postPass.descriptorSetLayout);
+    vk::DescriptorSetAllocateInfo postAllocInfo{};
+    postAllocInfo.setDescriptorPool(m_descriptorPool);
+    postAllocInfo.setSetLayouts(postLayouts);
+    m_postPass.descriptorSets = m_device.allocateDescriptorSets(postAllocInfo);
+
+    std::vector<vk::DescriptorSetLayout> finalLayouts(m_renderGraphs.size(), m_finalPass.descriptorSetLayout);
+    vk::DescriptorSetAllocateInfo finalAllocInfo{};
+    finalAllocInfo.setDescriptorPool(m_descriptorPool);
+    finalAllocInfo.setSetLayouts(finalLayouts);
+    m_finalPass.descriptorSets = m_device.allocateDescriptorSets(finalAllocInfo);
+
+    // The post pass reads texels 1:1 with texelFetch, the sampler is only there because the descriptor type needs one
+    vk::Sampler postSampler = m_samplerCache.get(m_samplerCache.make_info(vk::Filter::eNearest, vk::SamplerAddressMode::eClampToEdge));
+
+    // The fullscreen blit never minifies, so anisotropy and mips are wasted here. A 1:1 copy does not need filtering either,
+    // unless dynamic resolution renders less than the whole image.
+    bool sameSize = m_swapChainExtent == m_offscreenPass.extent && !m_resolution.enabled();
+    vk::SamplerCreateInfo samplerInfo =
+        m_samplerCache.make_info(sameSize ? vk::Filter::eNearest : vk::Filter::eLinear, vk::SamplerAddressMode::eClampToEdge);
+    vk::Sampler finalSampler = m_samplerCache.get(samplerInfo);
+
+    for (size_t i = 0; i < m_renderGraphs.size(); i++)
+    {
+        const RenderGraph& graph = *m_renderGraphs[i];
+
+        vk::DescriptorImageInfo sourceInfo{};
+        sourceInfo.setImageView(graph.view(m_rgSceneColor));
+        sourceInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        sourceInfo.setSampler(postSampler);
+
+        vk::DescriptorImageInfo targetInfo{};
+        targetInfo.setImageView(graph.view(m_rgPostColor));
+        targetInfo.setImageLayout(vk::ImageLayout::eGeneral);
+
+        vk::DescriptorImageInfo finalInfo{};
+        finalInfo.setImageView(graph.view(m_rgPostColor));
+        finalInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        finalInfo.setSampler(finalSampler);
+
+        vk::WriteDescriptorSet writeSource{};
+        writeSource.setDstSet(m_postPass.descriptorSets[i]);
+        writeSource.setDstBinding(0);
+        writeSource.setDescriptorCount(1);
+        writeSource.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+        writeSource.setImageInfo(sourceInfo);
+
+        vk::WriteDescriptorSet writeTarget{};
+        writeTarget.setDstSet(m_postPass.descriptorSets[i]);
+        writeTarget.setDstBinding(1);
+        writeTarget.setDescriptorCount(1);
+        writeTarget.setDescriptorType(vk::DescriptorType::eStorageImage);
+        writeTarget.setImageInfo(targetInfo);
+
+        vk::WriteDescriptorSet writeFinal{};
+        writeFinal.setDstSet(m_finalPass.descriptorSets[i]);
+        writeFinal.setDstBinding(0);
+        writeFinal.setDescriptorCount(1);
+        writeFinal.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+        writeFinal.setImageInfo(finalInfo);
+
+        m_device.updateDescriptorSets({ writeSource, writeTarget, writeFinal }, {});
+    }
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::create_offscreen_pipeline()
+{
+    /* Programmable Pipeline Stages */
+
+    auto vertShaderCode = read_shader_binary("shaders/shader.vert.spv");
+    auto fragShaderCode = read_shader_binary("shaders/shader.frag.spv");
+
+    vk::ShaderModule vertShaderModule = create_shader_module(vertShaderCode);
+    vk::ShaderModule fragShaderModule = create_shader_module(fragShaderCode);
+
+    vk::PipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.stage = vk::ShaderStageFlagBits::eVertex;
+    vertShaderStageInfo.module = vertShaderModule;
+    vertShaderStageInfo.pName = "main";
+
+    vk::PipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.stage = vk::ShaderStageFlagBits::eFragment;
+    fragShaderStageInfo.module = fragShaderModule;
+    fragShaderStageInfo.pName = "main";
+
+    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = { vertShaderStageInfo, fragShaderStageInfo };
+
+    /* Fixed Function Pipeline Stages */
+
+    // Vertex Input
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
+
+    // The vertex layout is picked with the scene buffers, the pipeline only consumes it
+    std::array<vk::VertexInputBindingDescription, 2> bindingDescriptions = { m_vertexBinding, InstanceData::get_binding_description() };
+
+    std::vector<vk::VertexInputAttributeDescription> attribDescriptions;
+    for (const auto& attrib : m_vertexAttributes)
+    {
+        attribDescriptions.push_back(attrib);
+    }
+    for (const auto& attrib : InstanceData::get_attrib_descriptions())
+    {
+        attribDescriptions.push_back(attrib);
+    }
+
+    vertexInputInfo.setVertexBindingDescriptions(bindingDescriptions);
+    vertexInputInfo.setVertexAttributeDescriptions(attribDescriptions);
+
+    // Input Assembly
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and Scissors (dynamic, so resizing does not need a pipeline rebuild)
+    vk::PipelineViewportStateCreateInfo viewportState{};
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
 
     // Rasterizer
     vk::PipelineRasterizationStateCreateInfo rasterizer{};
@@ -522,6 +1504,13 @@ void HelloTriangleApp::create_offscreen_pipeline()
     multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
 
     // Depth and Stencil Testing
+    // After a pre-pass the depth buffer already holds the nearest surface, so the colour pass only shades fragments that match it
+    vk::PipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = m_config.depthPrepass ? VK_FALSE : VK_TRUE;
+    depthStencil.depthCompareOp = m_config.depthPrepass ? vk::CompareOp::eEqual : vk::CompareOp::eLess;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
 
     // Color Blending
     vk::PipelineColorBlendAttachmentState colorBlendAttachment{};
@@ -535,18 +1524,30 @@ void HelloTriangleApp::create_offscreen_pipeline()
     colorBlending.pAttachments = &colorBlendAttachment;
 
     // Dynamic State
+    std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+
+    vk::PipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.setDynamicStates(dynamicStates);
 
     // Pipeline Layout
+    std::array<vk::DescriptorSetLayout, 2> setLayouts = { m_offscreenPass.descriptorSetLayout, m_bindless.layout() };
+
+    vk::PushConstantRange pushConstantRange{};
+    pushConstantRange.setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+    pushConstantRange.setSize(sizeof(DrawConstants));
+
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.setSetLayouts(m_offscreenPass.descriptorSetLayout);
+    pipelineLayoutInfo.setSetLayouts(setLayouts);
+    pipelineLayoutInfo.setPushConstantRanges(pushConstantRange);
 
     m_offscreenPass.pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
 
     /* Create Pipeline */
 
-    auto colorFormats = { vk::Format::eR8G8B8A8Srgb };
+    auto colorFormats = { m_offscreenPass.colorFormat };
     vk::PipelineRenderingCreateInfo pipelineRenderingInfo{};
     pipelineRenderingInfo.setColorAttachmentFormats(colorFormats);
+    pipelineRenderingInfo.depthAttachmentFormat = m_offscreenPass.depthFormat;
 
     vk::GraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.stageCount = 2;
@@ -558,16 +1559,137 @@ void HelloTriangleApp::create_offscreen_pipeline()
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr;
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr;
+    pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = m_offscreenPass.pipelineLayout;
     pipelineInfo.subpass = 0;
 
     m_offscreenPass.pipeline = m_device.createGraphicsPipeline({}, pipelineInfo).value;
 
+    if (m_config.depthPrepass)
+    {
+        // No fragment shader and no colour output, only the rasteriser and the depth test run. The vertex stage is shared with the
+        // colour pipeline and declares gl_Position invariant, so both passes produce bit identical depth for the equal test.
+        vk::PipelineDepthStencilStateCreateInfo prepassDepthStencil = depthStencil;
+        prepassDepthStencil.depthWriteEnable = VK_TRUE;
+        prepassDepthStencil.depthCompareOp = vk::CompareOp::eLess;
+
+        vk::PipelineColorBlendStateCreateInfo prepassColorBlending{};
+        prepassColorBlending.logicOpEnable = VK_FALSE;
+        prepassColorBlending.attachmentCount = 0;
+
+        vk::PipelineRenderingCreateInfo prepassRenderingInfo{};
+        prepassRenderingInfo.depthAttachmentFormat = m_offscreenPass.depthFormat;
+
+        vk::GraphicsPipelineCreateInfo prepassInfo = pipelineInfo;
+        prepassInfo.pNext = &prepassRenderingInfo;
+        prepassInfo.stageCount = 1;
+        prepassInfo.pDepthStencilState = &prepassDepthStencil;
+        prepassInfo.pColorBlendState = &prepassColorBlending;
+
+        m_offscreenPass.depthPrepassPipeline = m_device.createGraphicsPipeline({}, prepassInfo).value;
+    }
+
     m_device.destroy(vertShaderModule);
     m_device.destroy(fragShaderModule);
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::create_cull_pipeline()
+{
+    auto compShaderCode = read_shader_binary("shaders/cull.comp.spv");
+
+    vk::ShaderModule compShaderModule = create_shader_module(compShaderCode);
+
+    vk::PipelineShaderStageCreateInfo compShaderStageInfo{};
+    compShaderStageInfo.stage = vk::ShaderStageFlagBits::eCompute;
+    compShaderStageInfo.module = compShaderModule;
+    compShaderStageInfo.pName = "main";
+
+    vk::PushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    pushConstantRange.size = sizeof(CullParams);
+
+    // The depth pyramid is sampled through set 1, which is replaced along with the pyramid
+    std::array<vk::DescriptorSetLayout, 2> setLayouts = { m_cullPass.descriptorSetLayout, m_depthPyramid.sampleSetLayout };
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.setSetLayouts(setLayouts);
+    pipelineLayoutInfo.setPushConstantRanges(pushConstantRange);
+
+    m_cullPass.pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = m_cullPass.pipelineLayout;
+
+    m_cullPass.pipeline = m_device.createComputePipeline({}, pipelineInfo).value;
+
+    m_device.destroy(compShaderModule);
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::create_depth_pyramid_pipeline()
+{
+    auto compShaderCode = read_shader_binary("shaders/depth_pyramid.comp.spv");
+
+    vk::ShaderModule compShaderModule = create_shader_module(compShaderCode);
+
+    vk::PipelineShaderStageCreateInfo compShaderStageInfo{};
+    compShaderStageInfo.stage = vk::ShaderStageFlagBits::eCompute;
+    compShaderStageInfo.module = compShaderModule;
+    compShaderStageInfo.pName = "main";
+
+    // Size of the source region to reduce
+    vk::PushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    pushConstantRange.size = sizeof(int32_t) * 2;
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.setSetLayouts(m_depthPyramid.buildSetLayout);
+    pipelineLayoutInfo.setPushConstantRanges(pushConstantRange);
+
+    m_depthPyramid.pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = m_depthPyramid.pipelineLayout;
+
+    m_depthPyramid.pipeline = m_device.createComputePipeline({}, pipelineInfo).value;
+
+    m_device.destroy(compShaderModule);
+
+    invalidate_recorded_commands();
+}
+
+void HelloTriangleApp::create_post_pipeline()
+{
+    auto compShaderCode = read_shader_binary("shaders/postprocess.comp.spv");
+
+    vk::ShaderModule compShaderModule = create_shader_module(compShaderCode);
+
+    vk::PipelineShaderStageCreateInfo compShaderStageInfo{};
+    compShaderStageInfo.stage = vk::ShaderStageFlagBits::eCompute;
+    compShaderStageInfo.module = compShaderModule;
+    compShaderStageInfo.pName = "main";
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.setSetLayouts(m_postPass.descriptorSetLayout);
+
+    m_postPass.pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.stage = compShaderStageInfo;
+    pipelineInfo.layout = m_postPass.pipelineLayout;
+
+    m_postPass.pipeline = m_device.createComputePipeline({}, pipelineInfo).value;
+
+    m_device.destroy(compShaderModule);
+
+    invalidate_recorded_commands();
 }
 
 void HelloTriangleApp::create_final_pipeline()
@@ -602,24 +1724,10 @@ void HelloTriangleApp::create_final_pipeline()
     inputAssembly.topology = vk::PrimitiveTopology::eTriangleList;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    // Viewport and Scissors
-    vk::Viewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(m_swapChainExtent.width);
-    viewport.height = static_cast<float>(m_swapChainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    vk::Rect2D scissor{};
-    scissor.offset = vk::Offset2D(0, 0);
-    scissor.extent = m_swapChainExtent;
-
+    // Viewport and Scissors (dynamic, so resizing does not need a pipeline rebuild)
     vk::PipelineViewportStateCreateInfo viewportState{};
     viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
     viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
 
     // Rasterizer
     vk::PipelineRasterizationStateCreateInfo rasterizer{};
@@ -650,10 +1758,19 @@ void HelloTriangleApp::create_final_pipeline()
     colorBlending.pAttachments = &colorBlendAttachment;
 
     // Dynamic State
+    std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+
+    vk::PipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.setDynamicStates(dynamicStates);
 
     // Pipeline Layout
+    vk::PushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eFragment;
+    pushConstantRange.size = sizeof(FinalConstants);
+
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.setSetLayouts(m_finalPass.descriptorSetLayout);
+    pipelineLayoutInfo.setPushConstantRanges(pushConstantRange);
 
     m_finalPass.pipelineLayout = m_device.createPipelineLayout(pipelineLayoutInfo);
 
@@ -675,7 +1792,7 @@ void HelloTriangleApp::create_final_pipeline()
     pipelineInfo.pMultisampleState = &multisampling;
     pipelineInfo.pDepthStencilState = nullptr;
     pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr;
+    pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = m_finalPass.pipelineLayout;
     pipelineInfo.subpass = 0;
 
@@ -683,20 +1800,33 @@ void HelloTriangleApp::create_final_pipeline()
 
     m_device.destroy(vertShaderModule);
     m_device.destroy(fragShaderModule);
+
+    invalidate_recorded_commands();
 }
 
 void HelloTriangleApp::create_texture_image()
 {
-    int texWidth{};
-    int texHeight{};
-    int texChannels{};
-    stbi_uc* pixels = stbi_load("textures/texture.jpg", &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    vk::DeviceSize imageSize = texWidth * texHeight * 4;
+    auto startTime = std::chrono::high_resolution_clock::now();
 
-    if (!pixels)
-    {
-        throw std::runtime_error("Failed to load texture image!");
-    }
+    TextureCache textureCache(TEXTURE_CACHE_DIR);
+
+    TextureProcessParams params{};
+    params.srgb = true;
+    params.generateMips = true;
+    TextureData texture = textureCache.load(TEXTURE_PATH, params);
+
+    create_texture(texture, vk::Format::eR8G8B8A8Srgb, m_texture);
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    float loadTimeMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+
+    std::cout << "Texture '" << TEXTURE_PATH << "' loaded in " << loadTimeMs << " ms ("
+              << (texture.fromCache ? "warm start, decode skipped" : "cold start, decoded and cached") << ")" << std::endl;
+}
+
+void HelloTriangleApp::create_texture(const TextureData& data, vk::Format format, Texture& texture)
+{
+    vk::DeviceSize imageSize = data.size;
 
     vk::Buffer stagingBuffer;
     vk::DeviceMemory stagingBufferMemory;
@@ -707,46 +1837,27 @@ void HelloTriangleApp::create_texture_image()
                   stagingBuffer,
                   stagingBufferMemory);
 
-    void* data = m_device.mapMemory(stagingBufferMemory, 0, imageSize);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    void* mapped = m_device.mapMemory(stagingBufferMemory, 0, imageSize);
+    memcpy(mapped, data.pixels, static_cast<size_t>(imageSize));
     m_device.unmapMemory(stagingBufferMemory);
 
-    stbi_image_free(pixels);
-
-    vk::ImageCreateInfo imageInfo{};
-    imageInfo.imageType = vk::ImageType::e2D;
-    imageInfo.extent.width = static_cast<uint32_t>(texWidth);
-    imageInfo.extent.height = static_cast<uint32_t>(texHeight);
-    imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-
-    imageInfo.format = vk::Format::eR8G8B8A8Srgb;
-
-    imageInfo.tiling = vk::ImageTiling::eOptimal;
-
-    imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+    texture.mipLevels = data.mipLevels;
 
     // vk::ImageUsageFlagBits::eSampled allows shaders to access the image
-    imageInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
-
-    imageInfo.sharingMode = vk::SharingMode::eExclusive;
-
-    imageInfo.samples = vk::SampleCountFlagBits::e1;
-
-    create_image(texWidth,
-                 texHeight,
-                 vk::Format::eR8G8B8A8Srgb,
+    create_image(data.width,
+                 data.height,
+                 format,
                  vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-                 m_texture.image,
-                 m_texture.allocation);
+                 texture.image,
+                 texture.allocation,
+                 texture.mipLevels);
 
-    transition_image_layout(m_texture.image, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+    transition_image_layout(texture.image, format, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, texture.mipLevels);
 
-    copy_buffer_to_image(stagingBuffer, m_texture.image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    copy_buffer_to_image(stagingBuffer, texture.image, data.width, data.height, data.mipOffsets);
 
     transition_image_layout(
-        m_texture.image, vk::Format::eR8G8B8A8Srgb, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+        texture.image, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, texture.mipLevels);
 
     m_device.destroy(stagingBuffer);
     m_device.free(stagingBufferMemory);
@@ -754,346 +1865,2219 @@ void HelloTriangleApp::create_texture_image()
 
 void HelloTriangleApp::create_texture_image_view()
 {
-    m_texture.view = create_image_view(m_texture.image, vk::Format::eR8G8B8A8Srgb);
+    m_texture.view = create_image_view(m_texture.image, vk::Format::eR8G8B8A8Srgb, m_texture.mipLevels);
 }
 
-void HelloTriangleApp::create_sampler()
+void HelloTriangleApp::create_procedural_textures()
 {
-    vk::SamplerCreateInfo createInfo{};
-    createInfo.setMagFilter(vk::Filter::eLinear);
-    createInfo.setMinFilter(vk::Filter::eLinear);
-    createInfo.setAddressModeU(vk::SamplerAddressMode::eRepeat);
-    createInfo.setAddressModeV(vk::SamplerAddressMode::eRepeat);
-    createInfo.setAddressModeW(vk::SamplerAddressMode::eRepeat);
-    createInfo.setAnisotropyEnable(VK_TRUE);
-    createInfo.setMaxAnisotropy(16.0f);
-    createInfo.setBorderColor(vk::BorderColor::eIntOpaqueBlack);
-    createInfo.setUnnormalizedCoordinates(VK_FALSE);
-    createInfo.setCompareEnable(VK_FALSE);
-    createInfo.setCompareOp(vk::CompareOp::eAlways);
-    createInfo.setMipmapMode(vk::SamplerMipmapMode::eLinear);
-    createInfo.setMipLodBias(0.0f);
-    createInfo.setMinLod(0.0f);
-    createInfo.setMaxLod(0.0f);
+    constexpr uint32_t size = 32;
+    constexpr uint32_t checkerSize = 8;
+    constexpr vk::DeviceSize textureBytes = size * size * 4;
 
-    m_sampler = m_device.createSampler(createInfo);
-}
+    // A glTF scene's materials bring their own textures
+    uint32_t count = m_config.scenePath.empty() ? m_config.textureCount : 0;
+    if (count == 0)
+    {
+        return;
+    }
 
-void HelloTriangleApp::create_vertex_buffer()
-{
-    vk::DeviceSize bufferSize = sizeof(VERTICES[0]) * VERTICES.size();  // Buffer size in bytes
+    // The loaded texture takes one slot of the array
+    if (count + 1 > m_bindless.texture_capacity())
+    {
+        throw std::runtime_error("--textures " + std::to_string(count) + " exceeds the device's bindless texture limit of " +
+                                 std::to_string(m_bindless.texture_capacity() - 1));
+    }
+
+    vk::DeviceSize stagingSize = textureBytes * count;
 
     vk::Buffer stagingBuffer;
     vk::DeviceMemory stagingBufferMemory;
-    create_buffer(bufferSize,
+    create_buffer(stagingSize,
                   vk::BufferUsageFlagBits::eTransferSrc,
                   vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
                   stagingBuffer,
                   stagingBufferMemory);
 
-    void* data = m_device.mapMemory(stagingBufferMemory, 0, bufferSize);
-    memcpy(data, VERTICES.data(), static_cast<size_t>(bufferSize));
+    // Checkerboards of white and a colour whose hue steps by the golden ratio, so neighbouring indices are easy to tell apart
+    auto* pixels = static_cast<uint8_t*>(m_device.mapMemory(stagingBufferMemory, 0, stagingSize));
+    for (uint32_t t = 0; t < count; t++)
+    {
+        float hue = std::fmod(static_cast<float>(t) * 0.618034f, 1.0f);
+        glm::vec3 rgb = glm::clamp(glm::abs(glm::fract(glm::vec3(hue) + glm::vec3(1.0f, 2.0f / 3.0f, 1.0f / 3.0f)) * 6.0f - 3.0f) - 1.0f,
+                                   0.0f,
+                                   1.0f);
+
+        uint8_t* texels = pixels + textureBytes * t;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                bool white = ((x / checkerSize) + (y / checkerSize)) % 2 == 0;
+                uint8_t* texel = texels + (y * size + x) * 4;
+                texel[0] = white ? 255 : static_cast<uint8_t>(rgb.r * 255.0f);
+                texel[1] = white ? 255 : static_cast<uint8_t>(rgb.g * 255.0f);
+                texel[2] = white ? 255 : static_cast<uint8_t>(rgb.b * 255.0f);
+                texel[3] = 255;
+            }
+        }
+    }
     m_device.unmapMemory(stagingBufferMemory);
 
-    create_buffer(bufferSize,
-                  vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
-                  vk::MemoryPropertyFlagBits::eDeviceLocal,
-                  m_vertexBuffer,
-                  m_vertexBufferMemory);
+    m_proceduralTextures.resize(count);
+    for (auto& texture : m_proceduralTextures)
+    {
+        create_image(size,
+                     size,
+                     vk::Format::eR8G8B8A8Srgb,
+                     vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+                     texture.image,
+                     texture.allocation);
+    }
+
+    // Thousands of images would mean thousands of submits through transition_image_layout, so everything goes in one
+    vk::CommandBuffer cmd = begin_single_time_commands();
+
+    std::vector<vk::ImageMemoryBarrier2> barriers(count);
+    for (uint32_t t = 0; t < count; t++)
+    {
+        barriers[t].setImage(m_proceduralTextures[t].image);
+        barriers[t].setSubresourceRange({ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
+        barriers[t].setOldLayout(vk::ImageLayout::eUndefined);
+        barriers[t].setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+        barriers[t].setDstStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barriers[t].setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+    }
+    cmd.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(barriers));
+
+    for (uint32_t t = 0; t < count; t++)
+    {
+        vk::BufferImageCopy region{};
+        region.bufferOffset = textureBytes * t;
+        region.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+        region.imageExtent = vk::Extent3D{ size, size, 1 };
+        cmd.copyBufferToImage(stagingBuffer, m_proceduralTextures[t].image, vk::ImageLayout::eTransferDstOptimal, region);
+    }
+
+    for (auto& barrier : barriers)
+    {
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy);
+        barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eFragmentShader);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead);
+    }
+    cmd.pipelineBarrier2(vk::DependencyInfo{}.setImageMemoryBarriers(barriers));
 
-    copy_buffer(stagingBuffer, m_vertexBuffer, bufferSize);
+    end_single_time_commands(cmd);
 
     m_device.destroy(stagingBuffer);
     m_device.free(stagingBufferMemory);
+
+    for (auto& texture : m_proceduralTextures)
+    {
+        texture.view = create_image_view(texture.image, vk::Format::eR8G8B8A8Srgb);
+    }
 }
 
-void HelloTriangleApp::create_index_buffer()
+void HelloTriangleApp::register_bindless_textures()
 {
-    vk::DeviceSize bufferSize = sizeof(INDICES[0]) * INDICES.size();
+    // Materials sample the full mip chain with anisotropic filtering
+    vk::SamplerCreateInfo samplerInfo =
+        m_samplerCache.make_info(vk::Filter::eLinear, vk::SamplerAddressMode::eRepeat, 16.0f, static_cast<float>(m_texture.mipLevels));
+    m_sceneTextureBase = m_bindless.add_texture(m_texture.view, m_samplerCache.get(samplerInfo));
 
-    vk::Buffer stagingBuffer;
-    vk::DeviceMemory stagingBufferMemory;
-    create_buffer(bufferSize,
-                  vk::BufferUsageFlagBits::eTransferSrc,
-                  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                  stagingBuffer,
-                  stagingBufferMemory);
+    vk::SamplerCreateInfo proceduralSamplerInfo =
+        m_samplerCache.make_info(vk::Filter::eLinear, vk::SamplerAddressMode::eRepeat, 16.0f, 1.0f);
+    vk::Sampler proceduralSampler = m_samplerCache.get(proceduralSamplerInfo);
 
-    void* data = m_device.mapMemory(stagingBufferMemory, 0, bufferSize);
-    memcpy(data, INDICES.data(), static_cast<size_t>(bufferSize));
-    m_device.unmapMemory(stagingBufferMemory);
+    for (size_t t = 0; t < m_proceduralTextures.size(); t++)
+    {
+        uint32_t index = m_bindless.add_texture(m_proceduralTextures[t].view, proceduralSampler);
+        if (t == 0)
+        {
+            m_sceneTextureBase = index;
+        }
+    }
 
-    create_buffer(bufferSize,
-                  vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer,
-                  vk::MemoryPropertyFlagBits::eDeviceLocal,
-                  m_indexBuffer,
-                  m_indexBufferMemory);
+    m_stats.set_info("Bindless textures",
+                     std::to_string(m_bindless.texture_count()) + " of " + std::to_string(m_bindless.texture_capacity()));
+}
 
-    copy_buffer(stagingBuffer, m_indexBuffer, bufferSize);
+void HelloTriangleApp::create_sampler()
+{
+    m_samplerCache.init(m_device, m_physicalDevice.getProperties().limits);
 
-    m_device.destroy(stagingBuffer);
-    m_device.free(stagingBufferMemory);
+    auto properties = m_physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    m_bindless.init(m_device, properties.get<vk::PhysicalDeviceVulkan12Properties>(), MAX_BINDLESS_TEXTURES, MAX_BINDLESS_STORAGE_BUFFERS);
 }
 
-void HelloTriangleApp::create_uniform_buffers()
+void HelloTriangleApp::create_scene_buffers()
 {
-    vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
+    std::vector<InstanceData> instances;
+    std::vector<CullObject> cullObjects;
+
+    if (!m_config.scenePath.empty())
+    {
+        load_gltf_scene(instances, cullObjects);
+    }
+    else
+    {
+        create_generated_geometry(instances, cullObjects);
+    }
 
-    m_uniformBuffers.resize(m_swapChainImages.size());
-    m_uniformBuffersMemory.resize(m_swapChainImages.size());
+    m_instanceCount = static_cast<uint32_t>(instances.size());
+    m_cullObjectCount = static_cast<uint32_t>(cullObjects.size());
 
-    for (size_t i = 0; i < m_swapChainImages.size(); i++)
+    upload_buffer(instances.data(),
+                  sizeof(instances[0]) * instances.size(),
+                  vk::BufferUsageFlagBits::eVertexBuffer,
+                  m_instanceBuffer,
+                  m_instanceBufferMemory);
+
+    if (m_gpuCulling && m_cullObjectCount > m_physicalDevice.getProperties().limits.maxDrawIndirectCount)
     {
-        create_buffer(bufferSize,
-                      vk::BufferUsageFlagBits::eUniformBuffer,
-                      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-                      m_uniformBuffers[i],
-                      m_uniformBuffersMemory[i]);
+        std::cerr << "GPU culling needs " << m_cullObjectCount << " indirect draws, more than maxDrawIndirectCount, falling back to "
+                  << "CPU submitted draws" << std::endl;
+        m_gpuCulling = false;
     }
-}
+    m_stats.set_info("GPU culling", m_gpuCulling ? "on" : "off");
 
-void HelloTriangleApp::create_descriptor_pool()
-{
-    std::array<vk::DescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-    poolSizes[0].descriptorCount = 10;
-    poolSizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-    poolSizes[1].descriptorCount = 10;
+    m_occlusionCulling = m_gpuCulling && m_config.occlusion;
+    m_stats.set_info("Occlusion culling", m_occlusionCulling ? "on" : "off");
 
-    vk::DescriptorPoolCreateInfo poolInfo{};
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 10;
+    if (!m_gpuCulling)
+    {
+        return;
+    }
 
-    m_descriptorPool = m_device.createDescriptorPool(poolInfo);
+    upload_buffer(cullObjects.data(),
+                  sizeof(cullObjects[0]) * cullObjects.size(),
+                  vk::BufferUsageFlagBits::eStorageBuffer,
+                  m_cullObjectBuffer,
+                  m_cullObjectBufferMemory);
+
+    // The cull pass binds the table whether or not anything has levels
+    const MeshLod unusedLod{};
+    upload_buffer(m_meshLods.empty() ? &unusedLod : m_meshLods.data(),
+                  sizeof(MeshLod) * std::max<size_t>(m_meshLods.size(), 1),
+                  vk::BufferUsageFlagBits::eStorageBuffer,
+                  m_lodBuffer,
+                  m_lodBufferMemory);
 }
 
-void HelloTriangleApp::init_vulkan()
+void HelloTriangleApp::create_generated_geometry(std::vector<InstanceData>& instances, std::vector<CullObject>& cullObjects)
 {
-    create_instance();
-    create_surface();
-    pick_physical_device();
-    create_device();
-    create_allocator();
-    create_descriptor_pool();
-    create_sampler();
-    create_swapchain();
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    uint32_t instanceCount = m_config.drawCount;
+
+    if (m_config.meshlets)
+    {
+        make_sphere(SPHERE_RINGS, SPHERE_SEGMENTS, vertices, indices);
+    }
+    else
+    {
+        vertices = VERTICES;
+        indices = INDICES;
+    }
+
+    // Ahead of meshlet building, which forms tighter clusters from cache ordered triangles
+    if (m_config.meshOptimizer)
+    {
+        report_mesh_optimization(m_config.meshlets ? "sphere" : "quad", optimize_mesh(vertices, indices));
+    }
+
+    if (m_config.meshlets)
+    {
+        std::vector<glm::vec3> positions(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const Vertex& vertex) { return vertex.pos; });
+
+        // Each meshlet becomes a contiguous index range that the cull pass can emit as its own indirect draw
+        MeshletMesh meshlets = build_meshlets(positions, indices);
+        indices = meshlet_index_buffer(meshlets);
+
+        cullObjects.resize(meshlets.meshlets.size());
+        for (size_t m = 0; m < meshlets.meshlets.size(); m++)
+        {
+            const Meshlet& meshlet = meshlets.meshlets[m];
+            const MeshletBounds& bounds = meshlets.bounds[m];
+
+            cullObjects[m].sphere = glm::vec4(bounds.center, bounds.radius);
+            cullObjects[m].cone = glm::vec4(bounds.coneAxis, bounds.coneCutoff);
+            cullObjects[m].coneApex = glm::vec4(bounds.coneApex, 0.0f);
+            cullObjects[m].firstIndex = meshlet.triangleOffset * 3;
+            cullObjects[m].indexCount = meshlet.triangleCount * 3;
+            cullObjects[m].instance = 0;
+        }
+
+        instanceCount = 1;
+
+        auto averageTriangles = std::lround(static_cast<double>(indices.size() / 3) / static_cast<double>(meshlets.meshlets.size()));
+        m_stats.set_info("Meshlets",
+                         std::to_string(meshlets.meshlets.size()) + " (" + std::to_string(averageTriangles) + " triangles avg)");
+    }
+
+    // The meshlets are clusters of the full detail sphere, so it keeps its one level
+    auto fullIndexCount = static_cast<uint32_t>(indices.size());
+    if (m_config.lod && !m_config.meshlets)
+    {
+        m_meshLods = make_lod_chain(vertices, indices, m_config.meshOptimizer);
+
+        MeshLodReport lodReport;
+        lodReport.add(m_meshLods);
+        report_mesh_lods("quad", lodReport);
+    }
+
+    instances = make_instances(instanceCount, static_cast<uint32_t>(m_proceduralTextures.size()));
+
+    // The quad spans -0.5 to 0.5, so its bounding sphere reaches the transformed corner
+    m_sceneDraws.resize(instances.size());
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        const glm::mat4& model = instances[i].model;
+        m_sceneDraws[i].center = glm::vec3(model[3]);
+        m_sceneDraws[i].firstIndex = 0;
+        m_sceneDraws[i].indexCount = fullIndexCount;
+        m_sceneDraws[i].radius = glm::length(glm::vec3(model * glm::vec4(0.5f, 0.5f, 0.0f, 0.0f)));
+        m_sceneDraws[i].lodScale = std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])));
+        m_sceneDraws[i].firstLod = 0;
+        m_sceneDraws[i].lodCount = static_cast<uint32_t>(m_meshLods.size());
+    }
+
+    if (!m_config.meshlets)
+    {
+        // Quads are drawn double sided, so their cones never cull
+        cullObjects.resize(instances.size());
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            const SceneDraw& sceneDraw = m_sceneDraws[i];
+            cullObjects[i].sphere = glm::vec4(sceneDraw.center, sceneDraw.radius);
+            cullObjects[i].cone = glm::vec4(0.0f, 0.0f, 1.0f, 2.0f);
+            cullObjects[i].firstIndex = 0;
+            cullObjects[i].indexCount = fullIndexCount;
+            cullObjects[i].instance = static_cast<uint32_t>(i);
+            cullObjects[i].firstLod = sceneDraw.firstLod;
+            cullObjects[i].lodCount = sceneDraw.lodCount;
+            cullObjects[i].lodScale = sceneDraw.lodScale;
+        }
+    }
+
+    QuantizedVertices quantized = quantize_vertices(vertices, vertex_layout(m_config.vertexFormat));
+    report_vertex_quantization(m_config.meshlets ? "sphere" : "quad", quantized.layout, quantized.report);
+
+    m_vertexBinding = quantized.layout.binding_description(0);
+    m_vertexAttributes = quantized.layout.attribute_descriptions(0);
+    m_positionScale = { quantized.positionScale.x, quantized.positionScale.y, quantized.positionScale.z };
+    m_positionOffset = { quantized.positionOffset.x, quantized.positionOffset.y, quantized.positionOffset.z };
+
+    // Bounds come from the source positions, and the decoded ones may lie up to the quantization error outside them
+    for (CullObject& cullObject : cullObjects)
+    {
+        cullObject.sphere.w += quantized.report.maxPositionError;
+    }
+
+    upload_buffer(
+        quantized.data.data(), quantized.data.size(), vk::BufferUsageFlagBits::eVertexBuffer, m_vertexBuffer, m_vertexBufferMemory);
+    upload_buffer(
+        indices.data(), sizeof(indices[0]) * indices.size(), vk::BufferUsageFlagBits::eIndexBuffer, m_indexBuffer, m_indexBufferMemory);
+}
+
+void HelloTriangleApp::load_gltf_scene(std::vector<InstanceData>& instances, std::vector<CullObject>& cullObjects)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    GltfScene scene = GltfScene::load(m_config.scenePath);
+    create_gltf_textures(scene);
+
+    // Every primitive is stored once however many nodes draw it, with its indices rebased onto the shared vertex buffer. Its LOD
+    // chain follows its full detail indices.
+    struct PrimitiveRange
+    {
+        uint32_t baseVertex;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t firstLod;
+        uint32_t lodCount;
+    };
+    std::vector<std::vector<PrimitiveRange>> ranges(scene.meshes.size());
+
+    // The optimizer and the simplifier need each primitive in memory, so with either on the uploads copy from there instead of the
+    // mapping
+    struct PrimitiveCopy
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+    bool copyPrimitives = m_config.meshOptimizer || m_config.lod;
+    std::vector<std::vector<PrimitiveCopy>> copies(scene.meshes.size());
+    MeshOptimizationReport optimization;
+    MeshLodReport lodReport;
+
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    size_t triangleCount = 0;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (size_t m = 0; m < scene.meshes.size(); m++)
+    {
+        for (const GltfPrimitive& primitive : scene.meshes[m].primitives)
+        {
+            uint32_t primitiveVertices = primitive.positions.count;
+            uint32_t primitiveIndices = primitive.positions.count > 0 ? primitive.index_count() : 0;
+            uint32_t fullIndices = primitiveIndices;
+            auto firstLod = static_cast<uint32_t>(m_meshLods.size());
+
+            if (copyPrimitives && primitiveIndices > 0)
+            {
+                PrimitiveCopy& copy = copies[m].emplace_back();
+                copy.vertices.resize(primitive.positions.count);
+                copy.indices.resize(primitiveIndices);
+                for (uint32_t i = 0; i < primitive.positions.count; i++)
+                {
+                    copy.vertices[i] = primitive.read_vertex(i);
+                }
+                for (uint32_t i = 0; i < primitiveIndices; i++)
+                {
+                    uint32_t index = primitive.indices.is_valid() ? primitive.indices.read_index(i) : i;
+                    copy.indices[i] = std::min(index, primitive.positions.count - 1);
+                }
+
+                // Only whole triangles can be reordered or simplified
+                copy.indices.resize(copy.indices.size() / 3 * 3);
+                fullIndices = static_cast<uint32_t>(copy.indices.size());
+                if (m_config.meshOptimizer)
+                {
+                    optimization += optimize_mesh(copy.vertices, copy.indices);
+                }
+
+                if (m_config.lod)
+                {
+                    std::vector<MeshLod> lods = make_lod_chain(copy.vertices, copy.indices, m_config.meshOptimizer);
+                    lodReport.add(lods);
+                    for (MeshLod lod : lods)
+                    {
+                        lod.firstIndex += static_cast<uint32_t>(indexCount);
+                        m_meshLods.push_back(lod);
+                    }
+                }
+
+                primitiveVertices = static_cast<uint32_t>(copy.vertices.size());
+                primitiveIndices = static_cast<uint32_t>(copy.indices.size());
+            }
+            else if (copyPrimitives)
+            {
+                copies[m].emplace_back();
+                primitiveVertices = 0;
+            }
+
+            auto lodCount = static_cast<uint32_t>(m_meshLods.size()) - firstLod;
+            ranges[m].push_back({ static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(indexCount), fullIndices, firstLod, lodCount });
+
+            vertexCount += primitiveVertices;
+            indexCount += primitiveIndices;
+            triangleCount += fullIndices / 3;
+            boundsMin = glm::min(boundsMin, primitive.boundsMin);
+            boundsMax = glm::max(boundsMax, primitive.boundsMax);
+        }
+    }
+
+    if (m_config.meshOptimizer)
+    {
+        report_mesh_optimization("scene", optimization);
+    }
+    if (m_config.lod)
+    {
+        report_mesh_lods("scene", lodReport);
+    }
+
+    if (indexCount == 0 || scene.instances.empty())
+    {
+        throw std::runtime_error("glTF scene '" + m_config.scenePath + "' has no triangles to draw!");
+    }
+    if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+    {
+        throw std::runtime_error("glTF scene '" + m_config.scenePath + "' does not fit 32 bit indices!");
+    }
+
+    VertexEncoder encoder(vertex_layout(m_config.vertexFormat), boundsMin, boundsMax);
+    uint32_t stride = encoder.layout().stride();
+
+    // Accessors are read straight out of the mapped files into the staging memory, so the scene is never copied in between
+    upload_buffer(vertexCount * stride, vk::BufferUsageFlagBits::eVertexBuffer, m_vertexBuffer, m_vertexBufferMemory, [&](void* mapped) {
+        auto* destination = static_cast<uint8_t*>(mapped);
+        for (size_t m = 0; m < scene.meshes.size(); m++)
+        {
+            for (size_t p = 0; p < scene.meshes[m].primitives.size(); p++)
+            {
+                if (copyPrimitives)
+                {
+                    for (const Vertex& vertex : copies[m][p].vertices)
+                    {
+                        encoder.encode(vertex, destination);
+                        destination += stride;
+                    }
+                    continue;
+                }
+
+                const GltfPrimitive& primitive = scene.meshes[m].primitives[p];
+                for (uint32_t i = 0; i < primitive.positions.count; i++)
+                {
+                    encoder.encode(primitive.read_vertex(i), destination);
+                    destination += stride;
+                }
+            }
+        }
+    });
+
+    vk::DeviceSize indexBytes = indexCount * sizeof(uint32_t);
+    upload_buffer(indexBytes, vk::BufferUsageFlagBits::eIndexBuffer, m_indexBuffer, m_indexBufferMemory, [&](void* mapped) {
+        auto* destination = static_cast<uint32_t*>(mapped);
+        for (size_t m = 0; m < scene.meshes.size(); m++)
+        {
+            for (size_t p = 0; p < scene.meshes[m].primitives.size(); p++)
+            {
+                const GltfPrimitive& primitive = scene.meshes[m].primitives[p];
+                const PrimitiveRange& range = ranges[m][p];
+
+                if (copyPrimitives)
+                {
+                    for (uint32_t index : copies[m][p].indices)
+                    {
+                        *destination++ = range.baseVertex + index;
+                    }
+                    continue;
+                }
+
+                // An index past the primitive's own vertices would read another primitive's, or past the end of the buffer
+                uint32_t lastVertex = primitive.positions.count - 1;
+                for (uint32_t i = 0; i < range.indexCount; i++)
+                {
+                    uint32_t index = primitive.indices.is_valid() ? primitive.indices.read_index(i) : i;
+                    *destination++ = range.baseVertex + std::min(index, lastVertex);
+                }
+            }
+        }
+    });
+
+    const QuantizationReport& report = encoder.report();
+    report_vertex_quantization("scene", encoder.layout(), report);
+
+    m_vertexBinding = encoder.layout().binding_description(0);
+    m_vertexAttributes = encoder.layout().attribute_descriptions(0);
+    m_positionScale = { encoder.position_scale().x, encoder.position_scale().y, encoder.position_scale().z };
+    m_positionOffset = { encoder.position_offset().x, encoder.position_offset().y, encoder.position_offset().z };
+
+    auto transformBounds = [](const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& outMin,
+                              glm::vec3& outMax) {
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            glm::vec3 local(
+                (corner & 1) ? localMax.x : localMin.x, (corner & 2) ? localMax.y : localMin.y, (corner & 4) ? localMax.z : localMin.z);
+            glm::vec3 world(transform * glm::vec4(local, 1.0f));
+            outMin = glm::min(outMin, world);
+            outMax = glm::max(outMax, world);
+        }
+    };
+
+    // The camera frames the unit area the quads cover, so the scene is centred on it and scaled for its largest side to fit
+    glm::vec3 sceneMin(std::numeric_limits<float>::max());
+    glm::vec3 sceneMax(std::numeric_limits<float>::lowest());
+    std::vector<std::vector<uint32_t>> instancesOfMesh(scene.meshes.size());
+    for (uint32_t i = 0; i < scene.instances.size(); i++)
+    {
+        const GltfMeshInstance& instance = scene.instances[i];
+        for (const GltfPrimitive& primitive : scene.meshes[instance.mesh].primitives)
+        {
+            transformBounds(instance.transform, primitive.boundsMin, primitive.boundsMax, sceneMin, sceneMax);
+        }
+        instancesOfMesh[instance.mesh].push_back(i);
+    }
+
+    float sceneSize = std::max(sceneMax.x - sceneMin.x, std::max(sceneMax.y - sceneMin.y, sceneMax.z - sceneMin.z));
+    glm::mat4 fit = glm::scale(glm::mat4(1.0f), glm::vec3(sceneSize > 0.0f ? 1.0f / sceneSize : 1.0f)) *
+                    glm::translate(glm::mat4(1.0f), -(sceneMin + sceneMax) * 0.5f);
+
+    // One instance per primitive a node draws. Those of the same primitive are adjacent, so instanced rendering draws each with a
+    // single call.
+    for (size_t m = 0; m < scene.meshes.size(); m++)
+    {
+        for (size_t p = 0; p < scene.meshes[m].primitives.size(); p++)
+        {
+            const GltfPrimitive& primitive = scene.meshes[m].primitives[p];
+            const PrimitiveRange& range = ranges[m][p];
+            if (range.indexCount == 0)
+            {
+                continue;
+            }
+
+            GltfMaterial material;
+            if (primitive.material >= 0)
+            {
+                material = scene.materials[primitive.material];
+            }
+
+            for (uint32_t sceneInstance : instancesOfMesh[m])
+            {
+                glm::mat4 model = fit * scene.instances[sceneInstance].transform;
+                auto instance = static_cast<uint32_t>(instances.size());
+
+                InstanceData& instanceData = instances.emplace_back();
+                instanceData.model = model;
+                instanceData.color = glm::packUnorm4x8(material.baseColorFactor);
+                instanceData.textureIndex = material.baseColorTexture >= 0 ? static_cast<uint32_t>(material.baseColorTexture) + 1 : 0;
+
+                glm::vec3 center = glm::vec3(model * glm::vec4((primitive.boundsMin + primitive.boundsMax) * 0.5f, 1.0f));
+                float maxScale = std::max(glm::length(glm::vec3(model[0])),
+                                          std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+                float radius = (glm::length(primitive.boundsMax - primitive.boundsMin) * 0.5f + report.maxPositionError) * maxScale;
+
+                m_sceneDraws.push_back({ center,
+                                         range.firstIndex,
+                                         range.indexCount,
+                                         radius,
+                                         maxScale,
+                                         range.firstLod,
+                                         range.lodCount });
+
+                // Materials may be double sided, so the cones never cull
+                CullObject& cullObject = cullObjects.emplace_back();
+                cullObject.sphere = glm::vec4(center, radius);
+                cullObject.cone = glm::vec4(0.0f, 0.0f, 1.0f, 2.0f);
+                cullObject.firstIndex = range.firstIndex;
+                cullObject.indexCount = range.indexCount;
+                cullObject.instance = instance;
+                cullObject.firstLod = range.firstLod;
+                cullObject.lodCount = range.lodCount;
+                cullObject.lodScale = maxScale;
+            }
+        }
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    double loadTimeMs = std::chrono::duration<double, std::chrono::milliseconds::period>(endTime - startTime).count();
+    double mappedMiB = static_cast<double>(scene.mapped_bytes()) / (1024.0 * 1024.0);
+
+    m_stats.set_info("Scene",
+                     m_config.scenePath + ": " + std::to_string(scene.meshes.size()) + " meshes, " + std::to_string(instances.size()) +
+                          draws, " + std::to_string(triangleCount) + " triangles, " + std::to_string(scene.textures.size()) +
+                         " textures");
+    m_stats.set_info("Scene load",
+                     std::to_string(loadTimeMs) + " ms, " + std::to_string(mappedMiB) + " MiB mapped (" +
+                         std::to_string(loadTimeMs > 0.0 ? mappedMiB * 1000.0 / loadTimeMs : 0.0) + " MiB/s)");
+    m_stats.set_info("Draws", std::to_string(instances.size()));
+}
+
+void HelloTriangleApp::create_gltf_textures(const GltfScene& scene)
+{
+    auto count = static_cast<uint32_t>(scene.textures.size());
+    if (m_bindless.texture_count() + count + 1 > m_bindless.texture_capacity())
+    {
+        throw std::runtime_error("glTF scene '" + m_config.scenePath + "' has more textures than the device's bindless limit!");
+    }
+
+    // Decoding dominates for images that are not cached yet, so it is spread over the record threads. Images embedded in the
+    // scene's buffers are not decoded and draw as white.
+    TextureCache textureCache(TEXTURE_CACHE_DIR);
+    TextureProcessParams params{};
+    params.srgb = true;
+    params.generateMips = true;
+
+    // Textures often share an image. Each image is decoded and uploaded once, concurrent loads of one image would also race on
+    // its cache entry. Image 0 is plain white, for untextured materials and undecoded images.
+    std::vector<std::string> imagePaths = { "" };
+    std::vector<uint32_t> textureImages(count, 0);
+    std::unordered_map<std::string, uint32_t> imageIndices;
+    for (uint32_t t = 0; t < count; t++)
+    {
+        const std::string& path = scene.textures[t].imagePath;
+        if (path.empty())
+        {
+            continue;
+        }
+
+        auto [it, inserted] = imageIndices.emplace(path, static_cast<uint32_t>(imagePaths.size()));
+        if (inserted)
+        {
+            imagePaths.push_back(path);
+        }
+        textureImages[t] = it->second;
+    }
+
+    auto imageCount = static_cast<uint32_t>(imagePaths.size());
+    std::vector<TextureData> decoded(imageCount);
+    m_recordThreads->parallel_for(imageCount - 1, [&](uint32_t i, uint32_t) {
+        decoded[i + 1] = textureCache.load(imagePaths[i + 1], params);
+    });
+
+    TextureData white{};
+    white.width = 1;
+    white.height = 1;
+    white.mipOffsets = { 0 };
+    white.storage = { 255, 255, 255, 255 };
+    white.pixels = white.storage.data();
+    white.size = white.storage.size();
+
+    m_sceneTextures.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        const TextureData& data = decoded[i].pixels == nullptr ? white : decoded[i];
+        Texture& texture = m_sceneTextures[i];
+
+        create_texture(data, vk::Format::eR8G8B8A8Srgb, texture);
+        texture.view = create_image_view(texture.image, vk::Format::eR8G8B8A8Srgb, texture.mipLevels);
+    }
+
+    // Bindless slots stay one per glTF texture, after the white one, since the instances' texture indices count glTF textures
+    for (uint32_t t = 0; t <= count; t++)
+    {
+        const Texture& texture = m_sceneTextures[t == 0 ? 0 : textureImages[t - 1]];
+
+        vk::SamplerCreateInfo samplerInfo = m_samplerCache.make_info(
+            vk::Filter::eLinear, vk::SamplerAddressMode::eRepeat, 16.0f, static_cast<float>(texture.mipLevels));
+        uint32_t index = m_bindless.add_texture(texture.view, m_samplerCache.get(samplerInfo));
+        if (t == 0)
+        {
+            m_sceneTextureBase = index;
+        }
+    }
+
+    m_stats.set_info("Bindless textures",
+                     std::to_string(m_bindless.texture_count()) + " of " + std::to_string(m_bindless.texture_capacity()));
+}
+
+void HelloTriangleApp::report_mesh_optimization(const std::string& mesh, const MeshOptimizationReport& report)
+{
+    // Simulated with a FIFO cache of ANALYZED_VERTEX_CACHE_SIZE vertices
+    m_stats.set_info("Mesh optimizer (" + mesh + ")",
+                     "ACMR " + std::to_string(report.before.acmr()) + " -> " + std::to_string(report.after.acmr()) + ", ATVR " +
+                         std::to_string(report.before.atvr()) + " -> " + std::to_string(report.after.atvr()) + ", " +
+                         std::to_string(report.sourceVertices) + " -> " + std::to_string(report.optimizedVertices) + " vertices");
+}
+
+void HelloTriangleApp::report_mesh_lods(const std::string& mesh, const MeshLodReport& report)
+{
+    double coarsest = 100.0;
+    if (report.sourceTriangles > 0)
+    {
+        coarsest = 100.0 * static_cast<double>(report.coarsestTriangles) / static_cast<double>(report.sourceTriangles);
+    }
+
+    m_stats.set_info("LODs (" + mesh + ")",
+                     std::to_string(report.levelCount) + " levels over " + std::to_string(report.meshCount) + " meshes, coarsest " +
+                         std::to_string(coarsest) + "% of the triangles");
+}
+
+void HelloTriangleApp::report_vertex_quantization(const std::string& mesh, const VertexLayout& layout, const QuantizationReport& report)
+{
+    // Errors are what the GPU decodes against the source, positions relative to the mesh size
+    double positionError = report.meshExtent > 0.0f ? 100.0 * report.maxPositionError / report.meshExtent : 0.0;
+    double ratio = report.quantizedBytes > 0 ? static_cast<double>(report.sourceBytes) / static_cast<double>(report.quantizedBytes) : 1.0;
+
+    m_stats.set_info("Vertex format", layout.name() + ", " + std::to_string(layout.stride()) + " bytes");
+    m_stats.set_info("Vertex buffer (" + mesh + ")",
+                     std::to_string(report.vertexCount) + " vertices, " + std::to_string(report.quantizedBytes) + " bytes, " +
+                         std::to_string(ratio) + "x smaller than float");
+    m_stats.set_info("Vertex error (" + mesh + ")",
+                     "position " + std::to_string(positionError) + "% of extent, colour " + std::to_string(report.maxColorError) +
+                         ", uv " + std::to_string(report.maxTexCoordError));
+}
+
+void HelloTriangleApp::upload_buffer(
+    const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::Buffer& buffer, vk::DeviceMemory& memory)
+{
+    upload_buffer(size, usage, buffer, memory, [&](void* mapped) { memcpy(mapped, data, static_cast<size_t>(size)); });
+}
+
+void HelloTriangleApp::upload_buffer(vk::DeviceSize size,
+                                     vk::BufferUsageFlags usage,
+                                     vk::Buffer& buffer,
+                                     vk::DeviceMemory& memory,
+                                     const std::function<void(void* mapped)>& fill)
+{
+    vk::Buffer stagingBuffer;
+    vk::DeviceMemory stagingBufferMemory;
+    create_buffer(size,
+                  vk::BufferUsageFlagBits::eTransferSrc,
+                  vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                  stagingBuffer,
+                  stagingBufferMemory);
+
+    void* mapped = m_device.mapMemory(stagingBufferMemory, 0, size);
+    fill(mapped);
+    m_device.unmapMemory(stagingBufferMemory);
+
+    create_buffer(size, usage | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, memory);
+
+    copy_buffer(stagingBuffer, buffer, size);
+
+    m_device.destroy(stagingBuffer);
+    m_device.free(stagingBufferMemory);
+}
+
+void HelloTriangleApp::create_uniform_buffers()
+{
+    vk::DeviceSize bufferSize = sizeof(FrameUniforms);
+
+    m_uniformBuffers.resize(m_frames.size());
+    m_uniformBuffersMemory.resize(m_frames.size());
+
+    for (size_t i = 0; i < m_frames.size(); i++)
+    {
+        create_buffer(bufferSize,
+                      vk::BufferUsageFlagBits::eUniformBuffer,
+                      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                      m_uniformBuffers[i],
+                      m_uniformBuffersMemory[i]);
+    }
+}
+
+void HelloTriangleApp::create_descriptor_pool()
+{
+    // One offscreen and one cull set per frame in flight, up to one post and one final set per frame in flight (one render graph
+    // each with async compute), plus headroom for the graph sets retired on swapchain recreation
+    uint32_t maxSets = m_config.framesInFlight * 5 + 10;
+
+    std::array<vk::DescriptorPoolSize, 4> poolSizes{};
+    poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
+    poolSizes[0].descriptorCount = maxSets;
+    poolSizes[1].type = vk::DescriptorType::eCombinedImageSampler;
+    poolSizes[1].descriptorCount = maxSets * 2;
+    poolSizes[2].type = vk::DescriptorType::eStorageImage;
+    poolSizes[2].descriptorCount = maxSets;
+    poolSizes[3].type = vk::DescriptorType::eStorageBuffer;
+    poolSizes[3].descriptorCount = maxSets * 5;
+
+    vk::DescriptorPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = maxSets;
+
+    m_descriptorPool = m_device.createDescriptorPool(poolInfo);
+}
+
+void HelloTriangleApp::init_vulkan()
+{
+    create_instance();
+    create_surface();
+    pick_physical_device();
+    create_device();
+    create_allocator();
+    create_descriptor_pool();
+    create_sampler();
+    create_swapchain();
+
+    prepare_frames();
+
+    create_uniform_buffers();
+
+    create_texture_image();
+    create_texture_image_view();
+    create_procedural_textures();
+    register_bindless_textures();
+
+    // Settles whether the scene is culled on the GPU, which the render graph depends on
+    create_scene_buffers();
+
+    // Picks the depth format the render graph allocates the scene depth with
+    create_offscreen_pass_resources();
+    create_offscreen_pipeline();
+
+    build_render_graph();
+
+    if (!m_directToSwapchain)
+    {
+        create_post_pass_resources();
+        create_post_pipeline();
+
+        create_final_pass_resources();
+        create_final_pipeline();
+
+        write_graph_descriptors();
+    }
+
+    if (m_gpuCulling)
+    {
+        create_cull_pass_resources();
+        create_depth_pyramid_pass_resources();
+        create_depth_pyramid();
+        create_cull_pipeline();
+        create_depth_pyramid_pipeline();
+    }
+}
+
+auto HelloTriangleApp::simulate_frame() const -> FrameUniforms
+{
+    static auto startTime = std::chrono::high_resolution_clock::now();
+
+    auto currentTime = std::chrono::high_resolution_clock::now();
+    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+
+    FrameUniforms ubo{};
+    ubo.view = glm::translate(
+        glm::mat4(1.0f),
+        glm::vec3(0, 0, -2));  // glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    return ubo;
+}
+
+void HelloTriangleApp::update_camera(const FrameUniforms& ubo)
+{
+    glm::vec3 position = glm::inverse(ubo.view)[3];
+    std::array<float, 3> cameraPosition = { position.x, position.y, position.z };
+    bool moved = cameraPosition != m_cameraPosition;
+    m_cameraPosition = cameraPosition;
+
+    // GPU culled draws are neither sorted nor pick their levels on the CPU
+    if (m_gpuCulling)
+    {
+        return;
+    }
+
+    // The depth order of the sorted draws and the levels of detail picked on the CPU are baked into the recorded draws. Levels
+    // only make the recording stale when one of them actually changes.
+    bool stale = moved && !m_config.instancing;
+    if (moved || m_swapChainExtent != m_sceneDrawLodExtent || m_sceneDrawLods.size() != m_sceneDraws.size())
+    {
+        stale = update_scene_draw_lods() || stale;
+        m_sceneDrawLodExtent = m_swapChainExtent;
+    }
+
+    if (stale)
+    {
+        invalidate_recorded_commands();
+    }
+}
+
+auto HelloTriangleApp::update_scene_draw_lods() -> bool
+{
+    glm::mat4 proj = make_projection(m_swapChainExtent);
+    auto viewportHeight = static_cast<float>(m_swapChainExtent.height);
+    glm::vec3 cameraPosition(m_cameraPosition[0], m_cameraPosition[1], m_cameraPosition[2]);
+
+    bool changed = m_sceneDrawLods.size() != m_sceneDraws.size();
+    m_sceneDrawLods.resize(m_sceneDraws.size());
+    for (size_t draw = 0; draw < m_sceneDraws.size(); draw++)
+    {
+        MeshLod lod = select_lod(m_sceneDraws[draw], m_meshLods, proj, viewportHeight, cameraPosition);
+        MeshLod& recorded = m_sceneDrawLods[draw];
+        changed = changed || lod.firstIndex != recorded.firstIndex || lod.indexCount != recorded.indexCount;
+        recorded = lod;
+    }
+    return changed;
+}
+
+void HelloTriangleApp::write_uniform_buffer(uint32_t frameIndex, FrameUniforms ubo)
+{
+    // The projection follows the swapchain, which only the recording thread may look at
+    ubo.proj = make_projection(m_swapChainExtent);
+
+    ubo.viewProj = ubo.proj * ubo.view;
+
+    // The first frame has nothing to reproject, and the pyramid it culls against is still cleared to the far plane
+    ubo.previousViewProj = ubo.viewProj;
+    if (m_hasPreviousViewProj)
+    {
+        memcpy(&ubo.previousViewProj, m_previousViewProj.data(), sizeof(ubo.previousViewProj));
+    }
+    memcpy(m_previousViewProj.data(), &ubo.viewProj, sizeof(ubo.viewProj));
+    m_hasPreviousViewProj = true;
+    ubo.cameraPosition = glm::inverse(ubo.view)[3];
+
+    void* data = m_device.mapMemory(m_uniformBuffersMemory[frameIndex], 0, sizeof(ubo));
+    memcpy(data, &ubo, sizeof(ubo));
+    m_device.unmapMemory(m_uniformBuffersMemory[frameIndex]);
+}
+
+auto HelloTriangleApp::prepare_cmd_buffer(PerFrame& frame) -> vk::CommandBuffer
+{
+    if (!m_config.commandCache)
+    {
+        m_device.resetCommandPool(frame.cmdPool);
+
+        vk::CommandBufferBeginInfo beginInfo{};
+        beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        frame.cmd.begin(beginInfo);
+        record_cmd_buffer(frame.cmd);
+        frame.cmd.end();
+
+        return frame.cmd;
+    }
+
+    if (frame.cachedCmds.size() < m_swapChainImages.size())
+    {
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.setCommandPool(frame.cachedCmdPool);
+        allocInfo.setCommandBufferCount(static_cast<uint32_t>(m_swapChainImages.size() - frame.cachedCmds.size()));
+        allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+
+        std::vector<vk::CommandBuffer> cmds = m_device.allocateCommandBuffers(allocInfo);
+        frame.cachedCmds.insert(frame.cachedCmds.end(), cmds.begin(), cmds.end());
+        frame.cachedCmdGenerations.resize(frame.cachedCmds.size(), 0);
+    }
+
+    // Per-frame data lives in this slot's uniform buffer, so an up to date buffer can be submitted as is
+    vk::CommandBuffer cmd = frame.cachedCmds[m_imageIndex];
+    if (frame.cachedCmdGenerations[m_imageIndex] == m_commandGeneration)
+    {
+        m_stats.add_sample("cmd_buffers_recorded", 0.0);
+        return cmd;
+    }
+
+    cmd.reset();
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    cmd.begin(beginInfo);
+    record_cmd_buffer(cmd);
+    cmd.end();
+
+    frame.cachedCmdGenerations[m_imageIndex] = m_commandGeneration;
+    m_stats.add_sample("cmd_buffers_recorded", 1.0);
+
+    return cmd;
+}
+
+void HelloTriangleApp::invalidate_recorded_commands()
+{
+    m_commandGeneration++;
+}
+
+void HelloTriangleApp::record_cmd_buffer(const vk::CommandBuffer& cmd)
+{
+    auto& frame = m_frames[m_frameIndex];
+
+    cmd.resetQueryPool(frame.timestampPool, 0, MAX_TIMESTAMPS);
+    if (frame.statisticsPool)
+    {
+        cmd.resetQueryPool(frame.statisticsPool, 0, MAX_TIMESTAMPS);
+    }
+
+    RenderGraph& graph = frame_graph(m_frameIndex);
+    graph.set_imported_image(m_rgSwapchain, m_swapChainImages[m_imageIndex], m_swapChainImageViews[m_imageIndex]);
+    graph.execute(cmd, frame.timestampPool, frame.statisticsPool);
+
+    store_timestamp_layout(frame, graph);
+}
+
+void HelloTriangleApp::record_offscreen_pass(const RGPassContext& context, uint32_t cullPhases)
+{
+    auto& frame = m_frames[m_frameIndex];
+
+    // The scene draws do not depend on the swapchain image, so every cached primary of this slot shares one set of secondaries
+    if (m_config.commandCache && frame.sceneSecondariesGeneration == m_commandGeneration)
+    {
+        context.cmd.executeCommands(frame.sceneSecondaries);
+        add_state_change_samples(frame.sceneStateChanges);
+        return;
+    }
+
+    // Nothing recorded from this slot is still executing, and any primary referencing the old secondaries is stale as well
+    for (auto& threadCommands : frame.threadCommands)
+    {
+        m_device.resetCommandPool(threadCommands.cmdPool);
+        threadCommands.usedSecondaries = 0;
+    }
+
+    // Cached secondaries end up in one primary per swapchain image, which requires simultaneous use
+    vk::CommandBufferUsageFlags usage = m_config.commandCache ? vk::CommandBufferUsageFlagBits::eSimultaneousUse
+                                                              : vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    // Split the draw list into contiguous ranges, one secondary command buffer each. Small lists are not worth waking threads for,
+    // and an instanced or GPU culled scene is a single draw.
+    constexpr uint32_t MIN_DRAWS_PER_TASK = 256;
+    uint32_t drawCount = m_instanceCount;
+    bool singleDraw = m_config.instancing || m_gpuCulling;
+    uint32_t taskCount = singleDraw ? 1 : std::clamp(drawCount / MIN_DRAWS_PER_TASK, 1u, m_recordThreads->thread_count());
+
+    // With a pre-pass the list was sorted when the depth was laid down, earlier in the frame
+    if (!singleDraw && !m_config.depthPrepass)
+    {
+        build_scene_draw_list();
+    }
+
+    frame.sceneSecondaries.assign(taskCount, vk::CommandBuffer{});
+    std::vector<StateChangeStats> taskStateChanges(taskCount);
+
+    m_recordThreads->parallel_for(taskCount, [&](uint32_t taskIndex, uint32_t threadIndex) {
+        uint32_t firstDraw = static_cast<uint32_t>(static_cast<uint64_t>(drawCount) * taskIndex / taskCount);
+        uint32_t lastDraw = static_cast<uint32_t>(static_cast<uint64_t>(drawCount) * (taskIndex + 1) / taskCount);
+
+        vk::CommandBuffer secondary = begin_secondary(frame.threadCommands[threadIndex], context, usage);
+        taskStateChanges[taskIndex] =
+            record_offscreen_draws(secondary, m_offscreenPass.pipeline, firstDraw, lastDraw - firstDraw, cullPhases);
+        secondary.end();
+
+        frame.sceneSecondaries[taskIndex] = secondary;
+    });
+    frame.sceneSecondariesGeneration = m_commandGeneration;
+
+    frame.sceneStateChanges = StateChangeStats{};
+    for (const StateChangeStats& stateChanges : taskStateChanges)
+    {
+        frame.sceneStateChanges += stateChanges;
+    }
+    add_state_change_samples(frame.sceneStateChanges);
+
+    context.cmd.executeCommands(frame.sceneSecondaries);
+}
+
+void HelloTriangleApp::record_depth_prepass(const vk::CommandBuffer& cmd)
+{
+    // Depth only draws are cheap to record, so they go straight into the primary. Sorting front to back here is what lets the
+    // pre-pass reject most hidden fragments before they write depth.
+    bool singleDraw = m_config.instancing || m_gpuCulling;
+    if (!singleDraw)
+    {
+        build_scene_draw_list();
+    }
+
+    record_offscreen_draws(cmd, m_offscreenPass.depthPrepassPipeline, 0, m_instanceCount);
+}
+
+void HelloTriangleApp::build_scene_draw_list()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    glm::vec3 cameraPosition(m_cameraPosition[0], m_cameraPosition[1], m_cameraPosition[2]);
+
+    // Scene draws share all their bound state and pick textures per instance through the bindless array, so there is no material
+    // to group by and the list is sorted purely front to back
+    m_drawList.clear();
+    for (uint32_t draw = 0; draw < m_sceneDraws.size(); draw++)
+    {
+        const SceneDraw& sceneDraw = m_sceneDraws[draw];
+        uint32_t depth = quantize_draw_depth(glm::length(sceneDraw.center - cameraPosition), NEAR_PLANE, FAR_PLANE);
+        m_drawList.add(make_draw_key(DRAW_PASS_SCENE, DRAW_PIPELINE_OFFSCREEN, 0, depth), draw);
+    }
+
+    m_drawList.sort(*m_recordThreads);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.add_sample("cpu_sort_ms", std::chrono::duration<double, std::chrono::milliseconds::period>(end - start).count());
+}
+
+void HelloTriangleApp::add_state_change_samples(const StateChangeStats& stateChanges)
+{
+    m_stats.add_sample("state_changes", stateChanges.total());
+    m_stats.add_sample("pipeline_binds", stateChanges.pipelineBinds);
+    m_stats.add_sample("descriptor_set_binds", stateChanges.descriptorSetBinds);
+}
+
+auto HelloTriangleApp::record_offscreen_draws(
+    const vk::CommandBuffer& cmd, vk::Pipeline pipeline, uint32_t firstDraw, uint32_t drawCount, uint32_t cullPhases) -> StateChangeStats
+{
+    CommandStateTracker state(cmd);
+
+    set_viewport_and_scissor(cmd, m_offscreenPass.renderExtent);
+
+    // The quads are placed by their instance transforms and share one draw transform. Instance texture indices are offset by
+    // where the scene's textures start in the bindless array.
+    DrawConstants drawConstants{};
+    drawConstants.model = glm::mat4(1.0f);
+    drawConstants.textureBase = m_sceneTextureBase;
+    drawConstants.positionScale = glm::vec4(m_positionScale[0], m_positionScale[1], m_positionScale[2], 0.0f);
+    drawConstants.positionOffset = glm::vec4(m_positionOffset[0], m_positionOffset[1], m_positionOffset[2], 0.0f);
+
+    // Every scene draw shares this state. Draws only differ in their index range and instance, which textures are picked by
+    // through the bindless array, so it is bound once per command buffer.
+    state.bind_pipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    state.bind_vertex_buffer(0, m_vertexBuffer);
+    state.bind_vertex_buffer(1, m_instanceBuffer);
+    state.bind_index_buffer(m_indexBuffer, 0, vk::IndexType::eUint32);
+    state.bind_descriptor_set(
+        vk::PipelineBindPoint::eGraphics, m_offscreenPass.pipelineLayout, 0, m_offscreenPass.descriptorSets[m_frameIndex]);
+    state.bind_descriptor_set(vk::PipelineBindPoint::eGraphics, m_offscreenPass.pipelineLayout, 1, m_bindless.set());
+    state.push_constants(m_offscreenPass.pipelineLayout,
+                         vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+                         0,
+                         sizeof(DrawConstants),
+                         &drawConstants);
+
+    if (m_gpuCulling)
+    {
+        if (cullPhases & CULL_PHASE_EARLY)
+        {
+            cmd.drawIndexedIndirectCount(m_cullPass.drawBuffers[m_frameIndex],
+                                         0,
+                                         m_cullPass.countBuffers[m_frameIndex],
+                                         offsetof(CullCounts, drawCount),
+                                         m_cullObjectCount,
+                                         sizeof(vk::DrawIndexedIndirectCommand));
+        }
+        if (cullPhases & CULL_PHASE_LATE)
+        {
+            cmd.drawIndexedIndirectCount(m_cullPass.lateDrawBuffers[m_frameIndex],
+                                         0,
+                                         m_cullPass.countBuffers[m_frameIndex],
+                                         offsetof(CullCounts, lateDrawCount),
+                                         m_cullObjectCount,
+                                         sizeof(vk::DrawIndexedIndirectCommand));
+        }
+        return state.stats();
+    }
+
+    // Levels of detail were picked by update_camera() for this recording's camera, the same one the sort keys use
+    const std::vector<MeshLod>& lods = m_sceneDrawLods;
+
+    // Instances drawing the same index range are adjacent, so each run of them is one instanced draw. All the quads are one run,
+    // unless they are split by the levels they pick.
+    if (m_config.instancing)
+    {
+        uint32_t end = firstDraw + drawCount;
+        for (uint32_t first = firstDraw; first < end;)
+        {
+            const MeshLod& lod = lods[first];
+            uint32_t last = first + 1;
+            for (; last < end; last++)
+            {
+                const MeshLod& next = lods[last];
+                if (next.firstIndex != lod.firstIndex || next.indexCount != lod.indexCount)
+                {
+                    break;
+                }
+            }
+
+            cmd.drawIndexed(lod.indexCount, last - first, lod.firstIndex, 0, first);
+            first = last;
+        }
+        return state.stats();
+    }
+
+    // One draw per quad or primitive in sort key order, each picking its instance data through firstInstance
+    const std::vector<DrawItem>& items = m_drawList.items();
+    for (uint32_t i = firstDraw; i < firstDraw + drawCount; i++)
+    {
+        const MeshLod& lod = lods[items[i].draw];
+        cmd.drawIndexed(lod.indexCount, 1, lod.firstIndex, 0, items[i].draw);
+    }
+
+    return state.stats();
+}
+
+auto HelloTriangleApp::begin_secondary(ThreadCommands& threadCommands, const RGPassContext& context, vk::CommandBufferUsageFlags usage)
+    -> vk::CommandBuffer
+{
+    if (threadCommands.usedSecondaries == threadCommands.secondaries.size())
+    {
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.setCommandPool(threadCommands.cmdPool);
+        allocInfo.setCommandBufferCount(1);
+        allocInfo.setLevel(vk::CommandBufferLevel::eSecondary);
+        threadCommands.secondaries.push_back(m_device.allocateCommandBuffers(allocInfo)[0]);
+    }
+    vk::CommandBuffer secondary = threadCommands.secondaries[threadCommands.usedSecondaries++];
+
+    vk::CommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.setColorAttachmentFormats(context.colorFormats);
+    renderingInfo.depthAttachmentFormat = context.depthFormat;
+    renderingInfo.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+    vk::CommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.pNext = &renderingInfo;
+    if (context.pipelineStatistics)
+    {
+        inheritanceInfo.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+    }
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = usage | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    secondary.begin(beginInfo);
+
+    return secondary;
+}
+
+void HelloTriangleApp::record_cull_pass(const vk::CommandBuffer& cmd, uint32_t phase)
+{
+    constexpr uint32_t GROUP_SIZE = 64;
+
+    // The render graph only tracks images, so this pass orders its buffer accesses itself. The slot's previous frame has
+    // completed, which covers the indirect reads of the last draw from these buffers.
+    vk::Buffer countBuffer = m_cullPass.countBuffers[m_frameIndex];
+    if (phase == CULL_PHASE_EARLY)
+    {
+        cmd.fillBuffer(countBuffer, 0, sizeof(CullCounts), 0);
+
+        vk::BufferMemoryBarrier2 clearBarrier{};
+        clearBarrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+        clearBarrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+        clearBarrier.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+        clearBarrier.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite;
+        clearBarrier.buffer = countBuffer;
+        clearBarrier.size = VK_WHOLE_SIZE;
+
+        vk::DependencyInfo clearDependency{};
+        clearDependency.setBufferMemoryBarriers(clearBarrier);
+        cmd.pipelineBarrier2(clearDependency);
+    }
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_cullPass.pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                           m_cullPass.pipelineLayout,
+                           0,
+                           { m_cullPass.descriptorSets[m_frameIndex], m_depthPyramid.sampleSet },
+                           {});
+
+    CullParams params{};
+    params.objectCount = m_cullObjectCount;
+    params.phase = phase == CULL_PHASE_LATE ? 1 : 0;
+    params.occlusion = m_occlusionCulling ? 1 : 0;
+    params.lodPixelError = LOD_PIXEL_ERROR;
+    params.viewportHeight = static_cast<float>(m_swapChainExtent.height);
+    cmd.pushConstants(m_cullPass.pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullParams), &params);
+
+    // The late phase covers the deferred objects only, whose count is on the GPU. It is bounded by the object count.
+    cmd.dispatch((m_cullObjectCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+
+    // Besides the draws, the late phase reads the deferred list and the counts are copied for the CPU
+    vk::MemoryBarrier2 drawBarrier{};
+    drawBarrier.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+    drawBarrier.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite;
+    drawBarrier.dstStageMask =
+        vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eCopy;
+    drawBarrier.dstAccessMask = vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead |
+                                vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferRead;
+
+    vk::DependencyInfo drawDependency{};
+    drawDependency.setMemoryBarriers(drawBarrier);
+    cmd.pipelineBarrier2(drawDependency);
+
+    if (phase == CULL_PHASE_LATE || !m_occlusionCulling)
+    {
+        vk::BufferCopy region{};
+        region.size = sizeof(CullCounts);
+        cmd.copyBuffer(countBuffer, m_frames[m_frameIndex].cullCountsReadback, region);
+
+        vk::MemoryBarrier2 readbackBarrier{};
+        readbackBarrier.srcStageMask = vk::PipelineStageFlagBits2::eCopy;
+        readbackBarrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+        readbackBarrier.dstStageMask = vk::PipelineStageFlagBits2::eHost;
+        readbackBarrier.dstAccessMask = vk::AccessFlagBits2::eHostRead;
+
+        vk::DependencyInfo readbackDependency{};
+        readbackDependency.setMemoryBarriers(readbackBarrier);
+        cmd.pipelineBarrier2(readbackDependency);
+    }
+}
+
+void HelloTriangleApp::record_depth_pyramid_pass(const vk::CommandBuffer& cmd)
+{
+    constexpr uint32_t GROUP_SIZE = 8;
+
+    // This frame's early cull has to finish reading last frame's pyramid before the first level is overwritten
+    vk::MemoryBarrier2 reuseBarrier{};
+    reuseBarrier.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+    reuseBarrier.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+    reuseBarrier.dstAccessMask = vk::AccessFlagBits2::eShaderStorageWrite;
+
+    vk::DependencyInfo reuseDependency{};
+    reuseDependency.setMemoryBarriers(reuseBarrier);
+    cmd.pipelineBarrier2(reuseDependency);
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_depthPyramid.pipeline);
+
+    // Each level reads the one before it. The barrier after the last level also covers the late cull and next frame's early cull.
+    uint32_t firstSet = (m_frameIndex % static_cast<uint32_t>(m_renderGraphs.size())) * m_depthPyramid.mipLevels;
+    for (uint32_t level = 0; level < m_depthPyramid.mipLevels; level++)
+    {
+        cmd.bindDescriptorSets(
+            vk::PipelineBindPoint::eCompute, m_depthPyramid.pipelineLayout, 0, m_depthPyramid.buildSets[firstSet + level], {});
+
+        // The first level resamples only the rendered part of the scene depth, so the pyramid spans the screen at any scale
+        std::array<int32_t, 2> sourceSize = { static_cast<int32_t>(m_offscreenPass.renderExtent.width),
+                                              static_cast<int32_t>(m_offscreenPass.renderExtent.height) };
+        if (level > 0)
+        {
+            sourceSize[0] = static_cast<int32_t>(std::max(m_depthPyramid.extent.width >> (level - 1), 1u));
+            sourceSize[1] = static_cast<int32_t>(std::max(m_depthPyramid.extent.height >> (level - 1), 1u));
+        }
+        cmd.pushConstants(
+            m_depthPyramid.pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(sourceSize), sourceSize.data());
+
+        uint32_t width = std::max(m_depthPyramid.extent.width >> level, 1u);
+        uint32_t height = std::max(m_depthPyramid.extent.height >> level, 1u);
+        cmd.dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+        vk::MemoryBarrier2 levelBarrier{};
+        levelBarrier.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+        levelBarrier.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite;
+        levelBarrier.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader;
+        levelBarrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+
+        vk::DependencyInfo levelDependency{};
+        levelDependency.setMemoryBarriers(levelBarrier);
+        cmd.pipelineBarrier2(levelDependency);
+    }
+}
+
+void HelloTriangleApp::record_post_pass(const vk::CommandBuffer& cmd)
+{
+    constexpr uint32_t GROUP_SIZE = 8;
+
+    vk::DescriptorSet descriptorSet = m_postPass.descriptorSets[m_frameIndex % m_renderGraphs.size()];
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_postPass.pipeline);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_postPass.pipelineLayout, 0, descriptorSet, {});
+
+    // Only the rendered region is processed, the final pass never reads beyond it
+    uint32_t groupsX = (m_offscreenPass.renderExtent.width + GROUP_SIZE - 1) / GROUP_SIZE;
+    uint32_t groupsY = (m_offscreenPass.renderExtent.height + GROUP_SIZE - 1) / GROUP_SIZE;
+    cmd.dispatch(groupsX, groupsY, 1);
+}
+
+void HelloTriangleApp::record_final_pass(const vk::CommandBuffer& cmd)
+{
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_finalPass.pipeline);
+
+    set_viewport_and_scissor(cmd, m_swapChainExtent);
+
+    vk::DescriptorSet descriptorSet = m_finalPass.descriptorSets[m_frameIndex % m_renderGraphs.size()];
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_finalPass.pipelineLayout, 0, descriptorSet, {});
+
+    glm::vec2 extent(m_offscreenPass.extent.width, m_offscreenPass.extent.height);
+    glm::vec2 renderExtent(m_offscreenPass.renderExtent.width, m_offscreenPass.renderExtent.height);
+
+    FinalConstants constants{};
+    constants.uvScale = renderExtent / extent;
+    constants.uvMax = (renderExtent - 0.5f) / extent;
+    cmd.pushConstants(m_finalPass.pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(FinalConstants), &constants);
+
+    cmd.draw(3, 1, 0, 0);
+}
+
+void HelloTriangleApp::set_viewport_and_scissor(const vk::CommandBuffer& cmd, const vk::Extent2D& extent)
+{
+    vk::Viewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    cmd.setViewport(0, viewport);
+
+    vk::Rect2D scissor{};
+    scissor.offset = vk::Offset2D(0, 0);
+    scissor.extent = extent;
+    cmd.setScissor(0, scissor);
+}
+
+void HelloTriangleApp::throttle_frame_start()
+{
+    if (!m_presentWaitEnabled || m_lastPresentId == 0)
+    {
+        return;
+    }
+
+    // Keep at most one frame queued for display: the previous one has to be on screen before this one starts
+    VkResult result = m_vkWaitForPresentKHR(m_device, m_swapChain, m_lastPresentId, PRESENT_WAIT_TIMEOUT_NS);
+    m_lastPresentId = 0;
+    if (result != VK_SUCCESS)
+    {
+        // Timeouts and out of date swapchains are left to the acquire and present paths
+        return;
+    }
+
+    auto presentDone = std::chrono::steady_clock::now();
+    auto toMs = [](auto duration) { return std::chrono::duration<double, std::chrono::milliseconds::period>(duration).count(); };
+
+    m_stats.add_sample("motion_to_photon_ms", toMs(presentDone - m_lastPresentLatchTime));
+
+    // Consecutive presents land one refresh apart unless a frame was missed, which shows up as a multiple of the interval
+    if (m_lastPresentDoneTime.time_since_epoch().count() != 0)
+    {
+        double intervalMs = toMs(presentDone - m_lastPresentDoneTime);
+        if (m_refreshIntervalMs == 0.0 || intervalMs < m_refreshIntervalMs * 1.5)
+        {
+            m_refreshIntervalMs = m_refreshIntervalMs == 0.0 ? intervalMs : m_refreshIntervalMs * 0.9 + intervalMs * 0.1;
+        }
+    }
+    m_lastPresentDoneTime = presentDone;
+
+    // Only FIFO modes display on a fixed cadence worth aiming for; otherwise the queue depth limit is all we can do
+    if (m_presentMode != vk::PresentModeKHR::eFifo && m_presentMode != vk::PresentModeKHR::eFifoRelaxed)
+    {
+        return;
+    }
+
+    // Start just in time for the work to finish right before the next refresh
+    double slackMs = m_refreshIntervalMs - (m_cpuFrameWorkMs + m_gpuFrameTimeMs + LATENCY_MARGIN_MS);
+    if (slackMs > 0.0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(slackMs));
+    }
+}
+
+auto HelloTriangleApp::acquire_frame(PerFrame& frame) -> bool
+{
+    wait_for_frame(frame);
+    return acquire_image(frame);
+}
+
+void HelloTriangleApp::wait_for_frame(PerFrame& frame)
+{
+    vk::SemaphoreWaitInfo waitInfo{};
+    waitInfo.setSemaphores(m_frameTimeline);
+    waitInfo.setValues(frame.timelineValue);
+    m_device.waitSemaphores(waitInfo, UINT64_MAX);
+
+    read_timestamps(frame);
+
+    flush_deletion_queue(m_device.getSemaphoreCounterValue(m_frameTimeline));
+}
+
+auto HelloTriangleApp::acquire_image(PerFrame& frame) -> bool
+{
+    // The swapchain is shared with a concurrent present in pipelined mode. Images only come back once queued frames have been
+    // presented, so the lock is never held across a long wait.
+    vk::Result result = vk::Result::eTimeout;
+    while (result == vk::Result::eTimeout || result == vk::Result::eNotReady)
+    {
+        std::lock_guard lock(m_swapchainMutex);
+        result = m_device.acquireNextImageKHR(m_swapChain, ACQUIRE_TIMEOUT_NS, frame.imageReadySemaphore, {}, &m_imageIndex);
+    }
+
+    if (result == vk::Result::eErrorOutOfDateKHR)
+    {
+        return false;
+    }
+    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR)
+    {
+        throw std::runtime_error("Failed to acquire swapchain image!");
+    }
+
+    return true;
+}
+
+auto HelloTriangleApp::record_frame(PerFrame& frame) -> vk::CommandBuffer
+{
+    auto recordStart = std::chrono::high_resolution_clock::now();
+
+    vk::CommandBuffer cmd = prepare_cmd_buffer(frame);
+
+    auto recordEnd = std::chrono::high_resolution_clock::now();
+    double recordTimeMs = std::chrono::duration<double, std::chrono::milliseconds::period>(recordEnd - recordStart).count();
+    m_stats.add_sample("cpu_record_ms", recordTimeMs);
+
+    return cmd;
+}
+
+auto HelloTriangleApp::submit_frame(PerFrame& frame, vk::CommandBuffer cmd, uint32_t imageIndex, std::vector<vk::SemaphoreSubmitInfo> waits)
+    -> vk::Result
+{
+    vk::SemaphoreSubmitInfo waitSemaphoreInfo{};
+    waitSemaphoreInfo.semaphore = frame.imageReadySemaphore;
+    waitSemaphoreInfo.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+    waits.push_back(waitSemaphoreInfo);
+
+    std::array<vk::SemaphoreSubmitInfo, 2> signalSemaphoreInfos{};
+    signalSemaphoreInfos[0].semaphore = frame.renderDoneSemaphore;
+    signalSemaphoreInfos[0].stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+    signalSemaphoreInfos[1].semaphore = m_frameTimeline;
+    signalSemaphoreInfos[1].value = frame.timelineValue;
+    signalSemaphoreInfos[1].stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+
+    vk::CommandBufferSubmitInfo cmdInfo{};
+    cmdInfo.commandBuffer = cmd;
+
+    vk::SubmitInfo2 submitInfo{};
+    submitInfo.setWaitSemaphoreInfos(waits);
+    submitInfo.setCommandBufferInfos(cmdInfo);
+    submitInfo.setSignalSemaphoreInfos(signalSemaphoreInfos);
+
+    m_graphicsQueue.submit2(submitInfo);
+
+    std::lock_guard lock(m_swapchainMutex);
+
+    vk::PresentInfoKHR presentInfo{};
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &frame.renderDoneSemaphore;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &m_swapChain;
+    presentInfo.pImageIndices = &imageIndex;
+
+    // Frame numbers increase monotonically, which is all present ids require
+    vk::PresentIdKHR presentId{};
+    presentId.setPresentIds(frame.timelineValue);
+    if (m_presentWaitEnabled)
+    {
+        presentInfo.pNext = &presentId;
+    }
+
+    vk::Result result = m_presentQueue.presentKHR(&presentInfo);
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR && result != vk::Result::eErrorOutOfDateKHR)
+    {
+        throw std::runtime_error("Failed to present swapchain image!");
+    }
+
+    return result;
+}
+
+void HelloTriangleApp::draw_frame()
+{
+    throttle_frame_start();
+
+    auto workStart = std::chrono::steady_clock::now();
+
+    m_frameIndex = (m_frameIndex + 1) % m_frames.size();
+    auto& frame = m_frames[m_frameIndex];
+
+    if (!acquire_frame(frame))
+    {
+        recreate_swapchain();
+        return;
+    }
+
+    update_camera(simulate_frame());
+    vk::CommandBuffer cmd = record_frame(frame);
+
+    // Input and per-frame data are latched as late as possible, right before the frame is handed to the GPU. Recorded commands
+    // only reference the uniform buffer, so nothing has to be re-recorded for it.
+    if (m_config.lowLatency)
+    {
+        glfwPollEvents();
+    }
+    write_uniform_buffer(m_frameIndex, simulate_frame());
+    auto latchTime = std::chrono::steady_clock::now();
+
+    frame.timelineValue = ++m_frameNumber;
+    frame.timestampsPending = true;
+
+    vk::Result result = submit_frame(frame, cmd, m_imageIndex);
+
+    if (m_presentWaitEnabled && (result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR))
+    {
+        m_lastPresentId = frame.timelineValue;
+        m_lastPresentLatchTime = latchTime;
+    }
+
+    double workMs = std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - workStart).count();
+    m_cpuFrameWorkMs = m_cpuFrameWorkMs == 0.0 ? workMs : m_cpuFrameWorkMs * 0.9 + workMs * 0.1;
+
+    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || m_frameBufferResized)
+    {
+        m_frameBufferResized = false;
+        recreate_swapchain();
+    }
+}
+
+auto HelloTriangleApp::batch_waits(const PerFrame& frame, const RenderGraph& graph, uint32_t batch) const
+    -> std::vector<vk::SemaphoreSubmitInfo>
+{
+    std::vector<vk::SemaphoreSubmitInfo> waits;
+    for (uint32_t dependency : graph.batch_dependencies(batch))
+    {
+        // The acquire half of an ownership transfer has no source stage, so the wait has to cover whatever stage it is at
+        vk::SemaphoreSubmitInfo waitInfo{};
+        waitInfo.semaphore = m_batchTimeline;
+        waitInfo.value = frame.batchValues[dependency];
+        waitInfo.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+        waits.push_back(waitInfo);
+    }
+    return waits;
+}
+
+void HelloTriangleApp::submit_early_batches(PerFrame& frame)
+{
+    auto recordStart = std::chrono::high_resolution_clock::now();
+
+    RenderGraph& graph = frame_graph(m_frameIndex);
+    uint32_t presentBatch = graph.batch_count() - 1;
+
+    // Nothing recorded from this slot is still executing. The presenting batch has its own pool, it is recorded a frame later.
+    m_device.resetCommandPool(frame.cmdPool);
+    m_device.resetCommandPool(frame.computeCmdPool);
+
+    while (frame.batchCmds.size() < presentBatch)
+    {
+        bool compute = graph.batch_queue(static_cast<uint32_t>(frame.batchCmds.size())) == RGQueue::AsyncCompute;
+
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.setCommandPool(compute ? frame.computeCmdPool : frame.cmdPool);
+        allocInfo.setCommandBufferCount(1);
+        allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+        frame.batchCmds.push_back(m_device.allocateCommandBuffers(allocInfo)[0]);
+    }
+
+    frame.batchValues.assign(graph.batch_count(), 0);
+    store_timestamp_layout(frame, graph);
+
+    FrameUniforms ubo = simulate_frame();
+    update_camera(ubo);
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+
+    for (uint32_t batch = 0; batch < presentBatch; batch++)
+    {
+        vk::CommandBuffer cmd = frame.batchCmds[batch];
+        cmd.begin(beginInfo);
+        if (batch == 0)
+        {
+            cmd.resetQueryPool(frame.timestampPool, 0, MAX_TIMESTAMPS);
+            if (frame.statisticsPool)
+            {
+                cmd.resetQueryPool(frame.statisticsPool, 0, MAX_TIMESTAMPS);
+            }
+        }
+        graph.execute_batch(batch, cmd, frame.timestampPool, frame.statisticsPool);
+        cmd.end();
+    }
+
+    auto recordEnd = std::chrono::high_resolution_clock::now();
+    m_stats.add_sample("cpu_record_ms", std::chrono::duration<double, std::chrono::milliseconds::period>(recordEnd - recordStart).count());
+
+    write_uniform_buffer(m_frameIndex, ubo);
+
+    for (uint32_t batch = 0; batch < presentBatch; batch++)
+    {
+        std::vector<vk::SemaphoreSubmitInfo> waits = batch_waits(frame, graph, batch);
+
+        frame.batchValues[batch] = ++m_batchValue;
+
+        vk::SemaphoreSubmitInfo signalInfo{};
+        signalInfo.semaphore = m_batchTimeline;
+        signalInfo.value = frame.batchValues[batch];
+        signalInfo.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+
+        vk::CommandBufferSubmitInfo cmdInfo{};
+        cmdInfo.commandBuffer = frame.batchCmds[batch];
+
+        vk::SubmitInfo2 submitInfo{};
+        submitInfo.setWaitSemaphoreInfos(waits);
+        submitInfo.setCommandBufferInfos(cmdInfo);
+        submitInfo.setSignalSemaphoreInfos(signalInfo);
+
+        vk::Queue queue = graph.batch_queue(batch) == RGQueue::AsyncCompute ? m_computeQueue : m_graphicsQueue;
+        queue.submit2(submitInfo);
+    }
+}
+
+auto HelloTriangleApp::record_present_batch(PerFrame& frame) -> vk::CommandBuffer
+{
+    RenderGraph& graph = frame_graph(m_frameIndex);
+    graph.set_imported_image(m_rgSwapchain, m_swapChainImages[m_imageIndex], m_swapChainImageViews[m_imageIndex]);
+
+    m_device.resetCommandPool(frame.presentCmdPool);
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    frame.presentCmd.begin(beginInfo);
+    graph.execute_batch(graph.batch_count() - 1, frame.presentCmd, frame.timestampPool, frame.statisticsPool);
+    frame.presentCmd.end();
+
+    return frame.presentCmd;
+}
+
+void HelloTriangleApp::retire_pending_frame()
+{
+    if (!m_framePending)
+    {
+        return;
+    }
+    m_framePending = false;
+
+    // Its early batches are on the GPU, so the slot is only free again once they are done. Its timestamps are incomplete.
+    auto& frame = m_frames[m_frameIndex];
+    const RenderGraph& graph = frame_graph(m_frameIndex);
+    std::vector<vk::SemaphoreSubmitInfo> waits;
+    for (uint32_t batch = 0; batch + 1 < graph.batch_count(); batch++)
+    {
+        vk::SemaphoreSubmitInfo waitInfo{};
+        waitInfo.semaphore = m_batchTimeline;
+        waitInfo.value = frame.batchValues[batch];
+        waitInfo.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+        waits.push_back(waitInfo);
+    }
+
+    frame.timelineValue = ++m_frameNumber;
+    frame.timestampsPending = false;
+
+    vk::SemaphoreSubmitInfo signalInfo{};
+    signalInfo.semaphore = m_frameTimeline;
+    signalInfo.value = frame.timelineValue;
+    signalInfo.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+
+    vk::SubmitInfo2 submitInfo{};
+    submitInfo.setWaitSemaphoreInfos(waits);
+    submitInfo.setSignalSemaphoreInfos(signalInfo);
+    m_graphicsQueue.submit2(submitInfo);
+}
+
+void HelloTriangleApp::draw_frame_async()
+{
+    auto workStart = std::chrono::steady_clock::now();
+
+    // The previous frame gets its swapchain image now, and its presenting batch is recorded while m_frameIndex still points at it
+    vk::CommandBuffer presentCmd;
+    uint32_t pendingIndex = m_frameIndex;
+    if (m_framePending)
+    {
+        if (!acquire_image(m_frames[pendingIndex]))
+        {
+            retire_pending_frame();
+            recreate_swapchain();
+            return;
+        }
+        presentCmd = record_present_batch(m_frames[pendingIndex]);
+    }
 
-    prepare_frames();
+    m_frameIndex = (m_frameIndex + 1) % m_frames.size();
+    auto& frame = m_frames[m_frameIndex];
+    wait_for_frame(frame);
 
-    create_uniform_buffers();
+    // This frame's scene pass goes into the graphics queue ahead of the previous frame's final pass. The final pass waits for
+    // post-processing on the compute queue, which then overlaps the new scene instead of stalling the graphics queue.
+    submit_early_batches(frame);
 
-    create_texture_image();
-    create_texture_image_view();
+    vk::Result result = vk::Result::eSuccess;
+    if (presentCmd)
+    {
+        auto& pending = m_frames[pendingIndex];
+        const RenderGraph& pendingGraph = frame_graph(pendingIndex);
 
-    create_offscreen_pass_resources();
-    create_offscreen_pipeline();
+        pending.timelineValue = ++m_frameNumber;
+        pending.timestampsPending = true;
 
-    create_final_pass_resources();
-    create_final_pipeline();
+        result = submit_frame(pending, presentCmd, m_imageIndex, batch_waits(pending, pendingGraph, pendingGraph.batch_count() - 1));
+    }
+    m_framePending = true;
+
+    double workMs = std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - workStart).count();
+    m_cpuFrameWorkMs = m_cpuFrameWorkMs == 0.0 ? workMs : m_cpuFrameWorkMs * 0.9 + workMs * 0.1;
 
-    create_vertex_buffer();
-    create_index_buffer();
+    // The frame just started was recorded against the old graphs, so it is dropped along with them
+    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || m_frameBufferResized)
+    {
+        m_frameBufferResized = false;
+        retire_pending_frame();
+        recreate_swapchain();
+    }
 }
 
-void HelloTriangleApp::update_uniform_buffer(uint32_t currentImage)
+void HelloTriangleApp::draw_frames_pipelined(const std::function<void()>& onFrameQueued)
 {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    struct RecordedFrame
+    {
+        uint32_t frameIndex;
+        uint32_t imageIndex;
+        vk::CommandBuffer cmd;
+    };
 
-    UniformBufferObject ubo{};
-    ubo.model = glm::mat4(1.0f);  //  glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view = glm::translate(
-        glm::mat4(1.0f),
-        glm::vec3(0, 0, -2));  // glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.proj = glm::perspective(glm::radians(60.0f), m_swapChainExtent.width / (float)m_swapChainExtent.height, 0.1f, 10.0f);
+    // A single slot per hand-off lets every stage work on a different frame without any of them running further ahead
+    BoundedQueue<FrameUniforms> simulated(1);
+    BoundedQueue<RecordedFrame> recorded(1);
 
-    // GLM was designed for OpenGL, where the Y coordinate of the clip coordinates is inverted
-    ubo.proj[1][1] *= -1.0f;
+    std::mutex errorMutex;
+    std::exception_ptr workerError;
+    std::atomic<bool> failed{ false };
+    std::atomic<bool> swapchainStale{ false };
 
-    void* data = m_device.mapMemory(m_uniformBuffersMemory[currentImage], 0, sizeof(ubo));
-    memcpy(data, &ubo, sizeof(ubo));
-    m_device.unmapMemory(m_uniformBuffersMemory[currentImage]);
-}
+    auto fail = [&](std::exception_ptr error) {
+        {
+            std::lock_guard lock(errorMutex);
+            if (!workerError)
+            {
+                workerError = std::move(error);
+            }
+        }
+        failed = true;
+        simulated.close();
+        recorded.close();
+    };
 
-void HelloTriangleApp::record_cmd_buffer(const vk::CommandBuffer& cmd)
-{
-    /* Offscreen */
+    auto toMs = [](auto duration) { return std::chrono::duration<double, std::chrono::milliseconds::period>(duration).count(); };
 
-    vk::ImageMemoryBarrier barrier{};
-    barrier.srcAccessMask = {};
-    barrier.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-    barrier.oldLayout = vk::ImageLayout::eUndefined;
-    barrier.newLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.image = m_offscreenPass.image;
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+    std::thread simulateThread([&] {
+        try
+        {
+            while (true)
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                FrameUniforms ubo = simulate_frame();
+                m_stats.add_sample("cpu_simulate_ms", toMs(std::chrono::high_resolution_clock::now() - start));
+
+                if (!simulated.push(ubo))
+                {
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            fail(std::current_exception());
+        }
+    });
 
-    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eColorAttachmentOutput, {}, {}, {}, barrier);
+    std::thread submitThread([&] {
+        while (auto item = recorded.pop())
+        {
+            try
+            {
+                if (!failed)
+                {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    vk::Result result = submit_frame(m_frames[item->frameIndex], item->cmd, item->imageIndex);
+                    m_stats.add_sample("cpu_submit_ms", toMs(std::chrono::high_resolution_clock::now() - start));
+
+                    if (result != vk::Result::eSuccess)
+                    {
+                        swapchainStale = true;
+                    }
+                }
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+            }
 
-    vk::RenderingAttachmentInfo colorAttachmentInfo{};
-    colorAttachmentInfo.imageView = m_offscreenPass.view;
-    colorAttachmentInfo.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    colorAttachmentInfo.loadOp = vk::AttachmentLoadOp::eClear;
-    colorAttachmentInfo.storeOp = vk::AttachmentStoreOp::eStore;
-    colorAttachmentInfo.clearValue.color.setFloat32({ 0.232f, 0.304f, 0.540f, 1.0f });
+            recorded.task_done();
+        }
+    });
 
-    vk::RenderingInfo renderingInfo{};
-    renderingInfo.renderArea.offset = vk::Offset2D(0, 0);
-    renderingInfo.renderArea.extent = vk::Extent2D(WIDTH, HEIGHT);
-    renderingInfo.layerCount = 1;
-    renderingInfo.colorAttachmentCount = 1;
-    renderingInfo.pColorAttachments = &colorAttachmentInfo;
+    // The main thread owns the window, so it polls events, records and handles swapchain recreation. The workers have to be
+    // joined even when that fails, so errors here go through fail() as well.
+    try
+    {
+        std::optional<FrameUniforms> ubo;
+        while (!glfwWindowShouldClose(m_window) && !failed)
+        {
+            glfwPollEvents();
 
-    cmd.beginRendering(renderingInfo);
+            if (swapchainStale.exchange(false) || m_frameBufferResized)
+            {
+                // Recreation retires the swapchain the submit thread presents to, so let it run dry first
+                recorded.wait_until_drained();
+                swapchainStale = false;
+                m_frameBufferResized = false;
+                recreate_swapchain();
+            }
 
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_offscreenPass.pipeline);
+            if (!ubo)
+            {
+                ubo = simulated.pop();
+                if (!ubo)
+                {
+                    break;
+                }
+            }
 
-    std::vector<vk::Buffer> vertexBuffers = { m_vertexBuffer };
-    std::vector<vk::DeviceSize> offsets = { 0 };
-    cmd.bindVertexBuffers(0, 1, vertexBuffers.data(), offsets.data());
+            m_frameIndex = (m_frameIndex + 1) % m_frames.size();
+            auto& frame = m_frames[m_frameIndex];
 
-    cmd.bindIndexBuffer(m_indexBuffer, 0, vk::IndexType::eUint16);
+            if (!acquire_frame(frame))
+            {
+                recorded.wait_until_drained();
+                recreate_swapchain();
+                continue;
+            }
 
-    cmd.bindDescriptorSets(
-        vk::PipelineBindPoint::eGraphics, m_offscreenPass.pipelineLayout, 0, 1, &m_offscreenPass.descriptorSet, 0, nullptr);
+            update_camera(*ubo);
+            vk::CommandBuffer cmd = record_frame(frame);
 
-    cmd.drawIndexed(static_cast<uint32_t>(INDICES.size()), 1, 0, 0, 0);
+            write_uniform_buffer(m_frameIndex, *ubo);
+            ubo.reset();
 
-    cmd.endRendering();
+            frame.timelineValue = ++m_frameNumber;
+            frame.timestampsPending = true;
 
-    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-    barrier.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
-    barrier.image = m_offscreenPass.image;
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
+            if (!recorded.push({ m_frameIndex, m_imageIndex, cmd }))
+            {
+                break;
+            }
 
-    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+            onFrameQueued();
+        }
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
 
-    /* Swapchain */
+    simulated.close();
+    recorded.close();
+    simulateThread.join();
+    submitThread.join();
 
-    barrier.srcAccessMask = {};
-    barrier.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-    barrier.oldLayout = vk::ImageLayout::eUndefined;
-    barrier.newLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.image = m_swapChainImages[m_imageIndex];
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eColorAttachmentOutput, {}, {}, {}, barrier);
+    if (workerError)
+    {
+        std::rethrow_exception(workerError);
+    }
+}
 
-    colorAttachmentInfo.imageView = m_swapChainImageViews[m_imageIndex];
-    colorAttachmentInfo.imageLayout = vk::ImageLayout::eAttachmentOptimal;
-    colorAttachmentInfo.loadOp = vk::AttachmentLoadOp::eClear;
-    colorAttachmentInfo.storeOp = vk::AttachmentStoreOp::eStore;
-    colorAttachmentInfo.clearValue.color.setFloat32({ 0.0f, 0.0f, 0.0f, 1.0f });
+void HelloTriangleApp::store_timestamp_layout(PerFrame& frame, const RenderGraph& graph)
+{
+    frame.timestampPassNames = graph.executed_pass_names();
+    frame.timestampBatchStarts.clear();
+    for (uint32_t batch = 0; batch < graph.batch_count(); batch++)
+    {
+        frame.timestampBatchStarts.push_back(graph.batch_first_pass(batch));
+    }
+}
 
-    renderingInfo.renderArea.offset = vk::Offset2D(0, 0);
-    renderingInfo.renderArea.extent = vk::Extent2D(WIDTH, HEIGHT);
-    renderingInfo.layerCount = 1;
-    renderingInfo.colorAttachmentCount = 1;
-    renderingInfo.pColorAttachments = &colorAttachmentInfo;
+void HelloTriangleApp::read_timestamps(PerFrame& frame)
+{
+    if (!frame.timestampsPending)
+    {
+        return;
+    }
+    frame.timestampsPending = false;
+
+    const auto& passNames = frame.timestampPassNames;
+    uint32_t queryCount = static_cast<uint32_t>(passNames.size() * 2);
+
+    std::vector<uint64_t> timestamps(queryCount);
+    vk::Result result = m_device.getQueryPoolResults(frame.timestampPool,
+                                                     0,
+                                                     queryCount,
+                                                     timestamps.size() * sizeof(uint64_t),
+                                                     timestamps.data(),
+                                                     sizeof(uint64_t),
+                                                     vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+    {
+        return;
+    }
 
-    cmd.beginRendering(renderingInfo);
+    auto toMs = [this](uint64_t begin, uint64_t end) { return static_cast<double>(end - begin) * m_timestampPeriod / 1000000.0; };
 
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_finalPass.pipeline);
+    // Each batch is timed on its own queue and the spans are summed. With async compute the present batch is submitted a frame
+    // later, so the span from the first to the last timestamp would also cover the next frame's early batches.
+    const auto& batchStarts = frame.timestampBatchStarts;
+    m_gpuFrameTimeMs = 0.0;
+    for (size_t batch = 0; batch < batchStarts.size(); batch++)
+    {
+        size_t end = batch + 1 < batchStarts.size() ? batchStarts[batch + 1] : passNames.size();
+        if (end > batchStarts[batch])
+        {
+            m_gpuFrameTimeMs += toMs(timestamps[batchStarts[batch] * 2], timestamps[end * 2 - 1]);
+        }
+    }
+    m_stats.add_sample("gpu_frame_ms", m_gpuFrameTimeMs);
 
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_finalPass.pipelineLayout, 0, m_finalPass.descriptorSet, {});
+    // Frames already recorded keep their scale, so a change shows up in the timings frames in flight later
+    if (m_resolution.update(m_gpuFrameTimeMs))
+    {
+        update_render_extent();
+    }
+    if (m_resolution.enabled())
+    {
+        m_stats.add_sample("render_scale", m_resolution.scale());
+    }
 
-    cmd.draw(3, 1, 0, 0);
+    for (size_t i = 0; i < passNames.size(); i++)
+    {
+        m_stats.add_sample("gpu_" + passNames[i] + "_pass_ms", toMs(timestamps[i * 2], timestamps[i * 2 + 1]));
+    }
 
-    cmd.endRendering();
+    if (m_gpuCulling)
+    {
+        CullCounts counts{};
+        void* data = m_device.mapMemory(frame.cullCountsReadbackMemory, 0, sizeof(CullCounts));
+        memcpy(&counts, data, sizeof(counts));
+        m_device.unmapMemory(frame.cullCountsReadbackMemory);
+
+        m_stats.add_sample("cull_visible", counts.drawCount + counts.lateDrawCount);
+        m_stats.add_sample("cull_triangles", counts.triangleCount);
+        m_stats.add_sample("cull_cone_culled", counts.coneCulledCount);
+        m_stats.add_sample("cull_frustum_culled", m_cullObjectCount - counts.drawCount - counts.deferredCount - counts.coneCulledCount);
+        if (m_occlusionCulling)
+        {
+            m_stats.add_sample("cull_occluded", counts.occludedCount);
+            m_stats.add_sample("cull_disoccluded", counts.lateDrawCount);
+        }
+    }
 
-    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-    barrier.dstAccessMask = {};
-    barrier.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.newLayout = vk::ImageLayout::ePresentSrcKHR;
-    barrier.image = m_swapChainImages[m_imageIndex];
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, barrier);
-}
+    if (!frame.statisticsPool)
+    {
+        return;
+    }
 
-void HelloTriangleApp::draw_frame()
-{
-    m_frameIndex = (m_frameIndex + 1) % m_frames.size();
-    auto& frame = m_frames[m_frameIndex];
+    // Only the scene passes begin a query, the others were reset and never became available
+    uint64_t fragmentInvocations = 0;
+    for (size_t i = 0; i < passNames.size(); i++)
+    {
+        if (std::find(STATISTICS_PASS_NAMES.begin(), STATISTICS_PASS_NAMES.end(), passNames[i]) == STATISTICS_PASS_NAMES.end())
+        {
+            continue;
+        }
 
-    m_device.waitForFences(frame.cmdExecFence, VK_TRUE, UINT64_MAX);
-    m_device.resetFences(frame.cmdExecFence);
+        uint64_t invocations = 0;
+        result = m_device.getQueryPoolResults(frame.statisticsPool,
+                                              static_cast<uint32_t>(i),
+                                              1,
+                                              sizeof(uint64_t),
+                                              &invocations,
+                                              sizeof(uint64_t),
+                                              vk::QueryResultFlagBits::e64);
+        if (result != vk::Result::eSuccess)
+        {
+            return;
+        }
 
-    m_device.resetCommandPool(frame.cmdPool);
+        m_stats.add_sample(passNames[i] + "_fragment_invocations", static_cast<double>(invocations));
+        fragmentInvocations += invocations;
+    }
+    m_stats.add_sample("fragment_invocations", static_cast<double>(fragmentInvocations));
+}
 
-    m_imageIndex = m_device.acquireNextImageKHR(m_swapChain, UINT64_MAX, frame.imageReadySemaphore, {}).value;
+void HelloTriangleApp::recreate_swapchain()
+{
+    // A minimised window has a zero sized framebuffer, which is not a valid swapchain extent
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    while (width == 0 || height == 0)
+    {
+        glfwWaitEvents();
+        glfwGetFramebufferSize(m_window, &width, &height);
+    }
 
-    update_uniform_buffer(m_imageIndex);
+    // Retire the old swapchain and everything sized to it. They are destroyed once the frames using them complete, so there is
+    // no device wait here.
+    vk::SwapchainKHR oldSwapchain = m_swapChain;
+    std::vector<vk::ImageView> oldImageViews = std::move(m_swapChainImageViews);
+    vk::Format oldFormat = m_swapChainImageFormat;
 
-    vk::CommandBufferBeginInfo beginInfo{};
-    frame.cmd.begin(beginInfo);
+    create_swapchain(oldSwapchain);
 
-    record_cmd_buffer(frame.cmd);
+    defer_destroy([this, oldSwapchain, oldImageViews] {
+        for (auto imageView : oldImageViews)
+        {
+            m_device.destroy(imageView);
+        }
+        m_device.destroy(oldSwapchain);
+    });
 
-    frame.cmd.end();
+    // Transient images are sized to the swapchain, so the graphs are recompiled for the new configuration
+    build_render_graph();
 
-    vk::SubmitInfo submitInfo{};
+    if (!m_directToSwapchain)
+    {
+        std::vector<vk::DescriptorSet> oldSets = m_postPass.descriptorSets;
+        oldSets.insert(oldSets.end(), m_finalPass.descriptorSets.begin(), m_finalPass.descriptorSets.end());
+        defer_destroy([this, oldSets] { m_device.free(m_descriptorPool, oldSets); });
 
-    std::vector<vk::Semaphore> waitSemaphores = { frame.imageReadySemaphore };
-    std::vector<vk::PipelineStageFlags> waitStages = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores.data();
-    submitInfo.pWaitDstStageMask = waitStages.data();
-    submitInfo.setCommandBuffers(frame.cmd);
+        write_graph_descriptors();
+    }
 
-    std::vector<vk::Semaphore> signalSemaphores = { frame.renderDoneSemaphore };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores.data();
+    // Sized to the scene depth, and its build sets point at the graphs' depth images
+    if (m_gpuCulling)
+    {
+        create_depth_pyramid();
+    }
 
-    m_graphicsQueue.submit(submitInfo, frame.cmdExecFence);
+    if (m_swapChainImageFormat != oldFormat && m_directToSwapchain)
+    {
+        // The scene pipelines render into the swapchain, so they follow its format
+        OffscreenPass oldPass = m_offscreenPass;
+        defer_destroy([this, oldPass] {
+            m_device.destroy(oldPass.pipeline);
+            m_device.destroy(oldPass.depthPrepassPipeline);
+            m_device.destroy(oldPass.pipelineLayout);
+        });
+
+        m_offscreenPass.colorFormat = m_swapChainImageFormat;
+        create_offscreen_pipeline();
+    }
+    else if (m_swapChainImageFormat != oldFormat)
+    {
+        vk::Pipeline oldPipeline = m_finalPass.pipeline;
+        vk::PipelineLayout oldLayout = m_finalPass.pipelineLayout;
+        defer_destroy([this, oldPipeline, oldLayout] {
+            m_device.destroy(oldPipeline);
+            m_device.destroy(oldLayout);
+        });
+
+        create_final_pipeline();
+    }
+}
 
-    std::vector<vk::SwapchainKHR> swapChains = { m_swapChain };
-    vk::PresentInfoKHR presentInfo{};
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores.data();
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains.data();
-    presentInfo.pImageIndices = &m_imageIndex;
+void HelloTriangleApp::defer_destroy(std::function<void()>&& destroy)
+{
+    m_deletionQueue.push_back({ m_frameNumber, std::move(destroy) });
+}
 
-    m_presentQueue.presentKHR(&presentInfo);
+void HelloTriangleApp::flush_deletion_queue(uint64_t completedFrames)
+{
+    while (!m_deletionQueue.empty() && m_deletionQueue.front().frameNumber <= completedFrames)
+    {
+        m_deletionQueue.front().destroy();
+        m_deletionQueue.pop_front();
+    }
 }
 
 void HelloTriangleApp::main_loop()
 {
-    while (!glfwWindowShouldClose(m_window))
+    bool pipelined = m_config.pipelined && !m_config.lowLatency;
+    if (m_config.pipelined && !pipelined)
     {
-        glfwPollEvents();
-        draw_frame();
+        std::cerr << "Pipelined execution queues frames ahead, which low latency mode avoids; running serially" << std::endl;
+    }
+    m_stats.set_info("Pipelined", pipelined ? "on" : "off");
+
+    uint32_t frameCount = 0;
+    auto lastFrameTime = std::chrono::high_resolution_clock::now();
+
+    auto onFrame = [&] {
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        double frameTimeMs = std::chrono::duration<double, std::chrono::milliseconds::period>(currentTime - lastFrameTime).count();
+        m_stats.add_sample("cpu_frame_ms", frameTimeMs);
+        lastFrameTime = currentTime;
+
+        if (m_config.benchmarkFrames > 0 && ++frameCount >= m_config.benchmarkFrames)
+        {
+            glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+        }
+    };
+
+    if (pipelined)
+    {
+        draw_frames_pipelined(onFrame);
+    }
+    else if (m_asyncCompute)
+    {
+        while (!glfwWindowShouldClose(m_window))
+        {
+            glfwPollEvents();
+            draw_frame_async();
+            onFrame();
+        }
+        retire_pending_frame();
+    }
+    else
+    {
+        while (!glfwWindowShouldClose(m_window))
+        {
+            glfwPollEvents();
+            draw_frame();
+            onFrame();
+        }
     }
 
     m_device.waitIdle();
+
+    if (m_config.benchmarkFrames > 0)
+    {
+        m_stats.print_report(std::cout);
+    }
 }
 
-void HelloTriangleApp::cleanup() const
+void HelloTriangleApp::cleanup()
 {
     m_device.waitIdle();
 
+    flush_deletion_queue(UINT64_MAX);
+
     m_device.destroy(m_offscreenPass.pipeline, nullptr);
+    m_device.destroy(m_offscreenPass.depthPrepassPipeline);
     m_device.destroy(m_offscreenPass.pipelineLayout, nullptr);
 
+    m_device.destroy(m_postPass.pipeline, nullptr);
+    m_device.destroy(m_postPass.pipelineLayout, nullptr);
+
     m_device.destroy(m_finalPass.pipeline, nullptr);
     m_device.destroy(m_finalPass.pipelineLayout, nullptr);
 
@@ -1104,7 +4088,7 @@ void HelloTriangleApp::cleanup() const
 
     m_device.destroy(m_swapChain, nullptr);
 
-    for (size_t i = 0; i < m_swapChainImages.size(); i++)
+    for (size_t i = 0; i < m_uniformBuffers.size(); i++)
     {
         m_device.destroy(m_uniformBuffers[i]);
         m_device.free(m_uniformBuffersMemory[i]);
@@ -1112,15 +4096,31 @@ void HelloTriangleApp::cleanup() const
 
     m_device.destroy(m_descriptorPool);
 
-    m_device.destroy(m_sampler);
+    m_bindless.destroy();
+    m_samplerCache.destroy();
     m_device.destroy(m_texture.view);
     vmaDestroyImage(m_allocator, m_texture.image, m_texture.allocation);
 
+    for (auto& texture : m_proceduralTextures)
+    {
+        m_device.destroy(texture.view);
+        vmaDestroyImage(m_allocator, texture.image, texture.allocation);
+    }
+
+    for (auto& texture : m_sceneTextures)
+    {
+        m_device.destroy(texture.view);
+        vmaDestroyImage(m_allocator, texture.image, texture.allocation);
+    }
+
     m_device.destroy(m_offscreenPass.descriptorSetLayout);
+    m_device.destroy(m_postPass.descriptorSetLayout);
     m_device.destroy(m_finalPass.descriptorSetLayout);
 
-    m_device.destroy(m_offscreenPass.view);
-    vmaDestroyImage(m_allocator, m_offscreenPass.image, m_offscreenPass.allocation);
+    for (auto& graph : m_renderGraphs)
+    {
+        graph->destroy();
+    }
 
     m_device.destroy(m_vertexBuffer);
     m_device.free(m_vertexBufferMemory);
@@ -1128,15 +4128,71 @@ void HelloTriangleApp::cleanup() const
     m_device.destroy(m_indexBuffer);
     m_device.free(m_indexBufferMemory);
 
+    m_device.destroy(m_instanceBuffer);
+    m_device.free(m_instanceBufferMemory);
+
+    if (m_gpuCulling)
+    {
+        m_device.destroy(m_cullObjectBuffer);
+        m_device.free(m_cullObjectBufferMemory);
+        m_device.destroy(m_lodBuffer);
+        m_device.free(m_lodBufferMemory);
+
+        for (size_t i = 0; i < m_cullPass.drawBuffers.size(); i++)
+        {
+            m_device.destroy(m_cullPass.drawBuffers[i]);
+            m_device.free(m_cullPass.drawBuffersMemory[i]);
+            m_device.destroy(m_cullPass.countBuffers[i]);
+            m_device.free(m_cullPass.countBuffersMemory[i]);
+            m_device.destroy(m_cullPass.lateDrawBuffers[i]);
+            m_device.free(m_cullPass.lateDrawBuffersMemory[i]);
+            m_device.destroy(m_cullPass.deferredBuffers[i]);
+            m_device.free(m_cullPass.deferredBuffersMemory[i]);
+        }
+
+        for (auto& frame : m_frames)
+        {
+            m_device.destroy(frame.cullCountsReadback);
+            m_device.free(frame.cullCountsReadbackMemory);
+        }
+
+        m_device.destroy(m_cullPass.pipeline);
+        m_device.destroy(m_cullPass.pipelineLayout);
+        m_device.destroy(m_cullPass.descriptorSetLayout);
+
+        destroy_depth_pyramid(m_depthPyramid);
+        m_device.destroy(m_depthPyramid.pipeline);
+        m_device.destroy(m_depthPyramid.pipelineLayout);
+        m_device.destroy(m_depthPyramid.buildSetLayout);
+        m_device.destroy(m_depthPyramid.sampleSetLayout);
+    }
+
     for (auto& frame : m_frames)
     {
         m_device.destroy(frame.imageReadySemaphore);
         m_device.destroy(frame.renderDoneSemaphore);
-        m_device.destroy(frame.cmdExecFence);
+        m_device.destroy(frame.timestampPool);
+        m_device.destroy(frame.statisticsPool);
 
+        for (auto& threadCommands : frame.threadCommands)
+        {
+            m_device.destroy(threadCommands.cmdPool);
+        }
+        m_device.destroy(frame.cachedCmdPool);
         m_device.destroy(frame.cmdPool);
+
+        if (frame.computeCmdPool)
+        {
+            m_device.destroy(frame.computeCmdPool);
+            m_device.destroy(frame.presentCmdPool);
+        }
     }
 
+    m_recordThreads.reset();
+
+    m_device.destroy(m_frameTimeline);
+    m_device.destroy(m_batchTimeline);
+
     vmaDestroyAllocator(m_allocator);
 
     m_device.destroy();
@@ -1215,6 +4271,18 @@ auto HelloTriangleApp::find_queue_families(vk::PhysicalDevice device) -> QueueFa
         i++;
     }
 
+    // A family with compute but no graphics maps to separate hardware queues on most GPUs. Pass timings need timestamps there too.
+    for (uint32_t family = 0; family < queueFamilies.size(); family++)
+    {
+        const auto& properties = queueFamilies[family];
+        if ((properties.queueFlags & vk::QueueFlagBits::eCompute) && !(properties.queueFlags & vk::QueueFlagBits::eGraphics) &&
+            properties.timestampValidBits > 0)
+        {
+            indices.computeFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -1232,6 +4300,38 @@ auto HelloTriangleApp::check_device_extension_support(vk::PhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+auto HelloTriangleApp::supports_present_wait(vk::PhysicalDevice device) -> bool
+{
+    std::set<std::string> requiredExtensions = { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME };
+
+    for (const auto& extension : device.enumerateDeviceExtensionProperties())
+    {
+        requiredExtensions.erase(extension.extensionName);
+    }
+
+    if (!requiredExtensions.empty())
+    {
+        return false;
+    }
+
+    auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2,
+                                        vk::PhysicalDevicePresentIdFeaturesKHR,
+                                        vk::PhysicalDevicePresentWaitFeaturesKHR>();
+
+    return features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+           features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+}
+
+auto HelloTriangleApp::supports_gpu_culling(vk::PhysicalDevice device) -> bool
+{
+    auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    const vk::PhysicalDeviceFeatures& coreFeatures = features.get<vk::PhysicalDeviceFeatures2>().features;
+
+    // The cull pass selects each draw's instance data through a non-zero firstInstance in the indirect commands
+    return coreFeatures.multiDrawIndirect && coreFeatures.drawIndirectFirstInstance &&
+           features.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+}
+
 auto HelloTriangleApp::query_swap_chain_support(vk::PhysicalDevice device) -> SwapChainSupportDetails
 {
     SwapChainSupportDetails details;
@@ -1255,9 +4355,22 @@ auto HelloTriangleApp::is_device_suitable(vk::PhysicalDevice device) -> bool
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    auto deviceFeatures = device.getFeatures();
+    auto features =
+        device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+    const auto& deviceFeatures = features.get<vk::PhysicalDeviceFeatures2>().features;
+    const auto& vulkan12Features = features.get<vk::PhysicalDeviceVulkan12Features>();
+    const auto& vulkan13Features = features.get<vk::PhysicalDeviceVulkan13Features>();
+
+    bool featuresSupported = deviceFeatures.samplerAnisotropy && vulkan12Features.timelineSemaphore &&
+                             vulkan13Features.dynamicRendering && vulkan13Features.synchronization2;
+
+    bool descriptorIndexingSupported = vulkan12Features.runtimeDescriptorArray && vulkan12Features.descriptorBindingPartiallyBound &&
+                                       vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+                                       vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind &&
+                                       vulkan12Features.shaderSampledImageArrayNonUniformIndexing;
+    featuresSupported = featuresSupported && descriptorIndexingSupported;
 
-    return indices.is_complete() && extensionsSupported && swapChainAdequate && deviceFeatures.samplerAnisotropy;
+    return indices.is_complete() && extensionsSupported && swapChainAdequate && featuresSupported;
 }
 
 auto HelloTriangleApp::choose_swap_surface_format(const std::vector<vk::SurfaceFormatKHR>& availableFormats) -> vk::SurfaceFormatKHR
@@ -1272,8 +4385,27 @@ auto HelloTriangleApp::choose_swap_surface_format(const std::vector<vk::SurfaceF
     return availableFormats[0];
 }
 
-auto HelloTriangleApp::choose_swap_present_mode(const std::vector<vk::PresentModeKHR>& availablePresentModes) -> vk::PresentModeKHR
+auto HelloTriangleApp::choose_swap_present_mode(const std::vector<vk::PresentModeKHR>& availablePresentModes) const -> vk::PresentModeKHR
 {
+    if (m_config.presentMode != PresentModePreference::Auto)
+    {
+        vk::PresentModeKHR requested = vk::PresentModeKHR::eFifo;
+        switch (m_config.presentMode)
+        {
+            case PresentModePreference::Immediate: requested = vk::PresentModeKHR::eImmediate; break;
+            case PresentModePreference::Mailbox: requested = vk::PresentModeKHR::eMailbox; break;
+            case PresentModePreference::FifoRelaxed: requested = vk::PresentModeKHR::eFifoRelaxed; break;
+            default: break;
+        }
+
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), requested) != availablePresentModes.end())
+        {
+            return requested;
+        }
+
+        std::cerr << "Present mode " << vk::to_string(requested) << " is not supported, falling back" << std::endl;
+    }
+
     for (const auto& availablePresentMode : availablePresentModes)
     {
         if (availablePresentMode == vk::PresentModeKHR::eMailbox)
@@ -1286,6 +4418,19 @@ auto HelloTriangleApp::choose_swap_present_mode(const std::vector<vk::PresentMod
     return vk::PresentModeKHR::eFifo;
 }
 
+auto HelloTriangleApp::choose_swap_image_count(const vk::SurfaceCapabilitiesKHR& capabilities) const -> uint32_t
+{
+    uint32_t imageCount = m_config.swapchainImageCount > 0 ? m_config.swapchainImageCount : capabilities.minImageCount + 1;
+
+    imageCount = std::max(imageCount, capabilities.minImageCount);
+    if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
+    {
+        imageCount = capabilities.maxImageCount;
+    }
+
+    return imageCount;
+}
+
 auto HelloTriangleApp::choose_swap_extent(const vk::SurfaceCapabilitiesKHR& capabilities) -> vk::Extent2D
 {
     if (capabilities.currentExtent.width != UINT32_MAX)
@@ -1329,6 +4474,28 @@ auto HelloTriangleApp::find_memory_type(uint32_t typeFilter, const vk::MemoryPro
     throw std::runtime_error("Failed to find suitable memory type!");
 }
 
+auto HelloTriangleApp::find_depth_format() const -> vk::Format
+{
+    // D32 without stencil is the common case. The stencil formats are fallbacks, D16 is always supported for depth attachments.
+    const std::array<vk::Format, 4> candidates = {
+        vk::Format::eD32Sfloat,
+        vk::Format::eD32SfloatS8Uint,
+        vk::Format::eD24UnormS8Uint,
+        vk::Format::eD16Unorm,
+    };
+
+    for (vk::Format format : candidates)
+    {
+        vk::FormatProperties properties = m_physicalDevice.getFormatProperties(format);
+        if (properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+        {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("Failed to find a supported depth format!");
+}
+
 void HelloTriangleApp::create_buffer(vk::DeviceSize size,
                                      const vk::BufferUsageFlags& usage,
                                      const vk::MemoryPropertyFlags& properties,
@@ -1395,15 +4562,20 @@ void HelloTriangleApp::end_single_time_commands(vk::CommandBuffer commandBuffer)
     m_device.free(m_frames[m_frameIndex].cmdPool, 1, &commandBuffer);
 }
 
-void HelloTriangleApp::create_image(
-    uint32_t width, uint32_t height, vk::Format format, const vk::ImageUsageFlags& usage, vk::Image& image, VmaAllocation& allocation)
+void HelloTriangleApp::create_image(uint32_t width,
+                                    uint32_t height,
+                                    vk::Format format,
+                                    const vk::ImageUsageFlags& usage,
+                                    vk::Image& image,
+                                    VmaAllocation& allocation,
+                                    uint32_t mipLevels)
 {
     vk::ImageCreateInfo imageInfo{};
     imageInfo.imageType = vk::ImageType::e2D;
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = vk::ImageTiling::eOptimal;
@@ -1422,29 +4594,35 @@ void HelloTriangleApp::create_image(
     image = vkImage;
 }
 
-void HelloTriangleApp::copy_buffer_to_image(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height)
+void HelloTriangleApp::copy_buffer_to_image(
+    vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height, const std::vector<size_t>& mipOffsets)
 {
     vk::CommandBuffer commandBuffer = begin_single_time_commands();
 
-    vk::BufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = vk::Offset3D(0, 0, 0);
-    region.imageExtent = vk::Extent3D(width, height, 1);
+    std::vector<vk::BufferImageCopy> regions(mipOffsets.size());
+    for (uint32_t level = 0; level < regions.size(); level++)
+    {
+        auto& region = regions[level];
+        region.bufferOffset = mipOffsets[level];
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+
+        region.imageOffset = vk::Offset3D(0, 0, 0);
+        region.imageExtent = vk::Extent3D(std::max(width >> level, 1u), std::max(height >> level, 1u), 1);
+    }
 
-    commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+    commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, regions);
 
     end_single_time_commands(commandBuffer);
 }
 
-void HelloTriangleApp::transition_image_layout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+void HelloTriangleApp::transition_image_layout(
+    vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t mipLevels)
 {
     vk::CommandBuffer commandBuffer = begin_single_time_commands();
 
@@ -1458,7 +4636,7 @@ void HelloTriangleApp::transition_image_layout(vk::Image image, vk::Format forma
     barrier.image = image;
     barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
 
@@ -1491,7 +4669,7 @@ void HelloTriangleApp::transition_image_layout(vk::Image image, vk::Format forma
     end_single_time_commands(commandBuffer);
 }
 
-auto HelloTriangleApp::create_image_view(vk::Image image, vk::Format format) -> vk::ImageView
+auto HelloTriangleApp::create_image_view(vk::Image image, vk::Format format, uint32_t mipLevels) -> vk::ImageView
 {
     vk::ImageViewCreateInfo createInfo{};
     createInfo.image = image;
@@ -1499,7 +4677,7 @@ auto HelloTriangleApp::create_image_view(vk::Image image, vk::Format format) ->
     createInfo.format = format;
     createInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
     createInfo.subresourceRange.baseMipLevel = 0;
-    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.levelCount = mipLevels;
     createInfo.subresourceRange.baseArrayLayer = 0;
     createInfo.subresourceRange.layerCount = 1;
 
@@ -1508,10 +4686,11 @@ auto HelloTriangleApp::create_image_view(vk::Image image, vk::Format format) ->
 
 auto main(int argc, char** argv) -> int
 {
-    HelloTriangleApp app{};
-
     try
     {
+        AppConfig config = AppConfig::parse(argc, argv);
+
+        HelloTriangleApp app(config);
         app.run();
     }
     catch (const std::exception& e)
@@ -6,19 +6,49 @@
 #include <vulkan/vulkan.hpp>
 #include <vma/vk_mem_alloc.h>
 
+#include "AppConfig.hpp"
+#include "BindlessDescriptors.hpp"
+#include "DrawList.hpp"
+#include "FrameStats.hpp"
+#include "RenderGraph.hpp"
+#include "ResolutionController.hpp"
+#include "SamplerCache.hpp"
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 struct QueueFamilyIndices;
 struct SwapChainSupportDetails;
-
-constexpr int FRAMES_IN_FLIGHT = 2;
+struct FrameUniforms;
+struct SceneDraw;
+struct InstanceData;
+struct CullObject;
+struct QuantizationReport;
+struct MeshOptimizationReport;
+struct MeshLod;
+struct MeshLodReport;
+struct VertexLayout;
+struct TextureData;
+class GltfScene;
 
 class HelloTriangleApp
 {
 public:
+    explicit HelloTriangleApp(const AppConfig& config);
+
     void run();
 
 private:
+    AppConfig m_config;
+    FrameStats m_stats;
+
     GLFWwindow* m_window;
 
     vk::Instance m_instance;
@@ -28,6 +58,11 @@ private:
     uint32_t m_graphicsQueueFamily;
     vk::Queue m_graphicsQueue;
 
+    /* Dedicated compute family for post-processing, if the device has one and async compute is in use */
+    bool m_asyncCompute = false;
+    uint32_t m_computeQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+    vk::Queue m_computeQueue;
+
     vk::SurfaceKHR m_surface;
     vk::Queue m_presentQueue;
 
@@ -35,45 +70,190 @@ private:
     std::vector<vk::Image> m_swapChainImages;
     vk::Format m_swapChainImageFormat;
     vk::Extent2D m_swapChainExtent;
+    vk::PresentModeKHR m_presentMode;
+
+    /* Serialises acquire and present, which may run on different threads in pipelined mode */
+    std::mutex m_swapchainMutex;
 
     std::vector<vk::ImageView> m_swapChainImageViews;
 
+    /* Secondary command buffers recorded by one thread. Each thread has its own pool so recording needs no locking. */
+    struct ThreadCommands
+    {
+        vk::CommandPool cmdPool;
+        std::vector<vk::CommandBuffer> secondaries;
+        uint32_t usedSecondaries = 0;
+    };
+
     struct PerFrame
     {
         vk::CommandPool cmdPool;
         vk::CommandBuffer cmd;
 
+        /* Indexed by ThreadPool thread index */
+        std::vector<ThreadCommands> threadCommands;
+
+        /* Scene pass secondaries currently held by threadCommands, in execution order, and the generation they were recorded at */
+        std::vector<vk::CommandBuffer> sceneSecondaries;
+        uint64_t sceneSecondariesGeneration = 0;
+
+        /* Binds the scene secondaries issue, reported every frame they execute */
+        StateChangeStats sceneStateChanges;
+
+        /* Pre-recorded primaries indexed by swapchain image. An entry is reusable while its generation is current. */
+        vk::CommandPool cachedCmdPool;
+        std::vector<vk::CommandBuffer> cachedCmds;
+        std::vector<uint64_t> cachedCmdGenerations;
+
+        /* Async compute only. Command buffers for the render graph batches before the one that presents, a pool per queue family,
+         * and the m_batchTimeline value each batch signals. The presenting batch is recorded a frame later from its own pool. */
+        vk::CommandPool computeCmdPool;
+        std::vector<vk::CommandBuffer> batchCmds;
+        std::vector<uint64_t> batchValues;
+        vk::CommandPool presentCmdPool;
+        vk::CommandBuffer presentCmd;
+
         vk::Semaphore imageReadySemaphore;
         vk::Semaphore renderDoneSemaphore;
-        vk::Fence cmdExecFence;
+
+        /* m_frameTimeline reaches this value once the GPU has finished this slot's last submission */
+        uint64_t timelineValue = 0;
+
+        vk::QueryPool timestampPool;
+        /* Fragment shader invocations of the scene passes, indexed like the passes in timestampPassNames */
+        vk::QueryPool statisticsPool;
+        bool timestampsPending = false;
+
+        /* GPU culling only. Host visible copy of the cull counts, read back with the timestamps. */
+        vk::Buffer cullCountsReadback;
+        vk::DeviceMemory cullCountsReadbackMemory;
+        /* Passes the render graph executed when this slot was last recorded, in timestamp order */
+        std::vector<std::string> timestampPassNames;
+        /* Index of each render graph batch's first pass in timestampPassNames */
+        std::vector<uint32_t> timestampBatchStarts;
     };
-    std::array<PerFrame, FRAMES_IN_FLIGHT> m_frames{};
+    std::vector<PerFrame> m_frames;
     uint32_t m_frameIndex = 0;
     uint32_t m_imageIndex;
 
+    /* Number of frames submitted so far. Frame N signals m_frameTimeline to N once complete. */
+    uint64_t m_frameNumber = 0;
+    vk::Semaphore m_frameTimeline;
+
+    /* Signalled by each render graph batch submitted on its own in async compute mode, to order the batches across queues */
+    uint64_t m_batchValue = 0;
+    vk::Semaphore m_batchTimeline;
+
+    /* Async compute mode: the slot at m_frameIndex has its early batches submitted, but has not been presented yet */
+    bool m_framePending = false;
+
+    std::unique_ptr<ThreadPool> m_recordThreads;
+
+    /* Per-draw sort inputs of the CPU submitted scene, and the draws in the order they are recorded */
+    std::vector<SceneDraw> m_sceneDraws;
+    DrawList m_drawList;
+
+    /* Every --lod chain of the scene, indexed by the firstLod of its draws and cull objects. Index ranges are absolute. */
+    std::vector<MeshLod> m_meshLods;
+
+    /* Of the frame about to be recorded, for front to back sorting */
+    std::array<float, 3> m_cameraPosition{};
+
+    /* Level of detail each CPU submitted scene draw records with, picked for m_cameraPosition at m_sceneDrawLodExtent */
+    std::vector<MeshLod> m_sceneDrawLods;
+    vk::Extent2D m_sceneDrawLodExtent;
+
+    /* View projection of the frame uniforms last written, which the next frame reprojects the depth pyramid with */
+    std::array<float, 16> m_previousViewProj{};
+    bool m_hasPreviousViewProj = false;
+
+    /* Low latency mode. Each frame starts once the previous one is on screen, as late as the expected CPU and GPU work allows. */
+    bool m_presentWaitEnabled = false;
+    PFN_vkWaitForPresentKHR m_vkWaitForPresentKHR = nullptr;
+    uint64_t m_lastPresentId = 0;
+    std::chrono::steady_clock::time_point m_lastPresentLatchTime;
+    std::chrono::steady_clock::time_point m_lastPresentDoneTime;
+    double m_refreshIntervalMs = 0.0;
+    double m_cpuFrameWorkMs = 0.0;
+
+    /* Bumped whenever something recorded command buffers reference changes, which makes every cached buffer stale */
+    uint64_t m_commandGeneration = 1;
+
+    /* One timestamp before and one after each render graph pass */
+    static constexpr uint32_t MAX_TIMESTAMPS = 32;
+    float m_timestampPeriod = 1.0f;
+    double m_gpuFrameTimeMs = 0.0;
+
+    /* Pipeline statistics queries around the scene passes, if the device can inherit them into secondary command buffers */
+    bool m_pipelineStatistics = false;
+
+    /* Resources retired while frames in flight may still reference them */
+    struct PendingDeletion
+    {
+        uint64_t frameNumber;
+        std::function<void()> destroy;
+    };
+    std::deque<PendingDeletion> m_deletionQueue;
+
     vk::Buffer m_vertexBuffer;
     vk::DeviceMemory m_vertexBufferMemory;
+    /* Layout picked with --vertex-format. Normalised positions decode as stored * scale + offset in the vertex shader. */
+    vk::VertexInputBindingDescription m_vertexBinding;
+    std::array<vk::VertexInputAttributeDescription, 3> m_vertexAttributes{};
+    std::array<float, 3> m_positionScale = { 1.0f, 1.0f, 1.0f };
+    std::array<float, 3> m_positionOffset = { 0.0f, 0.0f, 0.0f };
     vk::Buffer m_indexBuffer;
     vk::DeviceMemory m_indexBufferMemory;
 
+    /* One InstanceData per quad in the scene, a single one for the meshlet mesh, or one per primitive a glTF node draws */
+    vk::Buffer m_instanceBuffer;
+    vk::DeviceMemory m_instanceBufferMemory;
+    uint32_t m_instanceCount = 0;
+
+    /* What the GPU cull pass tests and turns into indirect draws: one CullObject per quad, per meshlet, or per glTF draw */
+    vk::Buffer m_cullObjectBuffer;
+    vk::DeviceMemory m_cullObjectBufferMemory;
+    uint32_t m_cullObjectCount = 0;
+
+    /* m_meshLods for the cull pass to pick levels from, a single unused entry when there are none */
+    vk::Buffer m_lodBuffer;
+    vk::DeviceMemory m_lodBufferMemory;
+
     std::vector<vk::Buffer> m_uniformBuffers;
     std::vector<vk::DeviceMemory> m_uniformBuffersMemory;
 
     vk::DescriptorPool m_descriptorPool;
 
-    vk::Sampler m_sampler;
+    SamplerCache m_samplerCache;
+
+    /* Every texture the scene samples, indexed from shaders */
+    BindlessDescriptors m_bindless;
+
+    /* Rebuilt whenever the swapchain changes. Shared so a retired graph can outlive the frames still using its images. With async
+     * compute, frames overlap on the GPU and every slot gets its own copy of the graph; the resource handles are the same in each. */
+    std::vector<std::shared_ptr<RenderGraph>> m_renderGraphs;
+    RGResource m_rgSceneColor = RG_INVALID_RESOURCE;
+    RGResource m_rgSceneDepth = RG_INVALID_RESOURCE;
+    RGResource m_rgPostColor = RG_INVALID_RESOURCE;
+    RGResource m_rgSwapchain = RG_INVALID_RESOURCE;
 
     struct OffscreenPass
     {
-        vk::Image image;
-        VmaAllocation allocation;
-        vk::ImageView view;
+        vk::Extent2D extent;
+        /* The part of the scene images rendered this frame, smaller than extent under dynamic resolution */
+        vk::Extent2D renderExtent;
+        /* The swapchain format when rendering straight into it */
+        vk::Format colorFormat = vk::Format::eUndefined;
+        vk::Format depthFormat = vk::Format::eUndefined;
 
         vk::DescriptorSetLayout descriptorSetLayout;
-        vk::DescriptorSet descriptorSet;
+        std::vector<vk::DescriptorSet> descriptorSets;
 
         vk::PipelineLayout pipelineLayout;
         vk::Pipeline pipeline;
+
+        /* Depth only, same layout and vertex stage. Only created with --depth-prepass. */
+        vk::Pipeline depthPrepassPipeline;
     } m_offscreenPass;
 
     struct Texture
@@ -81,12 +261,95 @@ private:
         vk::Image image;
         VmaAllocation allocation;
         vk::ImageView view;
+        uint32_t mipLevels = 1;
     } m_texture;
 
+    /* Generated with --textures, to put many distinct textures in one draw */
+    std::vector<Texture> m_proceduralTextures;
+
+    /* Base colour images of the --scene materials, each decoded once, after a white one for the untextured materials */
+    std::vector<Texture> m_sceneTextures;
+
+    /* Bindless index of the first texture the instances' texture indices count from */
+    uint32_t m_sceneTextureBase = 0;
+
+    /* Culls the scene on the GPU, writing one indirect draw per visible quad or meshlet and the number of them */
+    bool m_gpuCulling = false;
+
+    /* Without post-processing the scene passes render into the swapchain image, with no post or final pass */
+    bool m_directToSwapchain = false;
+
+    /* Scales the scene's render extent to hold the GPU frame time budget. The final pass upscales, so it needs post-processing. */
+    ResolutionController m_resolution;
+
+    /* Two phase occlusion culling. The early phase draws what last frame's depth pyramid shows as visible and defers the rest,
+     * the late phase tests the deferred objects again against a pyramid built from the early depth and draws what was
+     * disoccluded. */
+    bool m_occlusionCulling = false;
+    static constexpr uint32_t CULL_PHASE_EARLY = 1u << 0;
+    static constexpr uint32_t CULL_PHASE_LATE = 1u << 1;
+
+    struct CullPass
+    {
+        vk::DescriptorSetLayout descriptorSetLayout;
+        std::vector<vk::DescriptorSet> descriptorSets;
+
+        vk::PipelineLayout pipelineLayout;
+        vk::Pipeline pipeline;
+
+        /* Per frame in flight, so a frame can cull while the previous one still draws */
+        std::vector<vk::Buffer> drawBuffers;
+        std::vector<vk::DeviceMemory> drawBuffersMemory;
+        std::vector<vk::Buffer> countBuffers;
+        std::vector<vk::DeviceMemory> countBuffersMemory;
+
+        /* Occlusion culling only: the late phase's draws and the objects the early phase deferred to it */
+        std::vector<vk::Buffer> lateDrawBuffers;
+        std::vector<vk::DeviceMemory> lateDrawBuffersMemory;
+        std::vector<vk::Buffer> deferredBuffers;
+        std::vector<vk::DeviceMemory> deferredBuffersMemory;
+    } m_cullPass;
+
+    /* Farthest depth of the scene at every mip level, kept in the general layout. Persistent, so one frame's pyramid can cull the
+     * next frame's early phase. Every render graph shares it: they all run it on the graphics queue, in submission order. */
+    struct DepthPyramid
+    {
+        vk::Extent2D extent;
+        uint32_t mipLevels = 0;
+
+        vk::Image image;
+        VmaAllocation allocation = nullptr;
+        /* All levels for sampling, and one per level for writing */
+        vk::ImageView view;
+        std::vector<vk::ImageView> mipViews;
+
+        /* Recreated with the pyramid. Holds a build set per level for every render graph, and the set the cull pass samples. */
+        vk::DescriptorPool descriptorPool;
+        vk::DescriptorSetLayout buildSetLayout;
+        std::vector<vk::DescriptorSet> buildSets;
+        vk::DescriptorSetLayout sampleSetLayout;
+        vk::DescriptorSet sampleSet;
+
+        vk::PipelineLayout pipelineLayout;
+        vk::Pipeline pipeline;
+    } m_depthPyramid;
+
+    /* Compute pass between the scene and the swapchain blit, run on the async compute queue when there is one */
+    struct PostPass
+    {
+        vk::DescriptorSetLayout descriptorSetLayout;
+        /* One per render graph */
+        std::vector<vk::DescriptorSet> descriptorSets;
+
+        vk::PipelineLayout pipelineLayout;
+        vk::Pipeline pipeline;
+    } m_postPass;
+
     struct FinalPass
     {
         vk::DescriptorSetLayout descriptorSetLayout;
-        vk::DescriptorSet descriptorSet;
+        /* One per render graph */
+        std::vector<vk::DescriptorSet> descriptorSets;
 
         vk::PipelineLayout pipelineLayout;
         vk::Pipeline pipeline;
@@ -107,31 +370,146 @@ private:
     void create_descriptor_pool();
     void create_sampler();
 
-    void create_swapchain();
+    void create_swapchain(vk::SwapchainKHR oldSwapchain = {});
+    void recreate_swapchain();
     void prepare_frames();
 
+    void build_render_graph();
+    /* Applies the resolution controller's scale to the scene extent */
+    void update_render_extent();
+    /* The graph recorded for the given frame slot */
+    auto frame_graph(uint32_t frameIndex) const -> RenderGraph&;
+
     void create_offscreen_pass_resources();
+    void create_cull_pass_resources();
+    void create_cull_pipeline();
+    void create_depth_pyramid_pass_resources();
+    void create_depth_pyramid_pipeline();
+    /* Sized to the render graphs' scene depth. Retires the previous pyramid, so it is rebuilt along with the graphs. */
+    void create_depth_pyramid();
+    /* Destroys the images, views and descriptor pool of a retired pyramid */
+    void destroy_depth_pyramid(const DepthPyramid& pyramid);
+    void create_post_pass_resources();
     void create_final_pass_resources();
+    /* Points the post and final pass sets at the images of the current render graphs */
+    void write_graph_descriptors();
     void create_offscreen_pipeline();
+    void create_post_pipeline();
     void create_final_pipeline();
 
     void create_texture_image();
     void create_texture_image_view();
+    void create_procedural_textures();
+    void register_bindless_textures();
+
+    /* Vertex, index and instance buffers for the quads, the meshlet sphere or the glTF scene, plus the cull objects when culling on
+     * the GPU */
+    void create_scene_buffers();
+    void create_generated_geometry(std::vector<InstanceData>& instances, std::vector<CullObject>& cullObjects);
+
+    /* Loads --scene, reading its accessors out of the mapped files straight into the staging buffers. The scene is scaled to the
+     * area the quads cover. */
+    void load_gltf_scene(std::vector<InstanceData>& instances, std::vector<CullObject>& cullObjects);
+    void create_gltf_textures(const GltfScene& scene);
+
+    /* Cache statistics before and after --mesh-optimizer, as a stats info */
+    void report_mesh_optimization(const std::string& mesh, const MeshOptimizationReport& report);
+
+    /* Levels and triangle reduction of the --lod chains, as a stats info */
+    void report_mesh_lods(const std::string& mesh, const MeshLodReport& report);
 
-    void create_vertex_buffer();
-    void create_index_buffer();
+    /* Size, ratio to full floats and decode error of a mesh's vertex buffer, as stats infos */
+    void report_vertex_quantization(const std::string& mesh, const VertexLayout& layout, const QuantizationReport& report);
+
+    /* Creates a device local buffer and fills it through a staging buffer */
+    void upload_buffer(const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::Buffer& buffer, vk::DeviceMemory& memory);
+
+    /* As above, with fill writing the size bytes into the mapped staging memory itself */
+    void upload_buffer(vk::DeviceSize size,
+                       vk::BufferUsageFlags usage,
+                       vk::Buffer& buffer,
+                       vk::DeviceMemory& memory,
+                       const std::function<void(void* mapped)>& fill);
+
+    /* Creates a sampled RGBA8 image with the texture's mip chain, left in shader read layout. The view is up to the caller. */
+    void create_texture(const TextureData& data, vk::Format format, Texture& texture);
 
     void create_uniform_buffers();
 
     void init_vulkan();
 
-    void update_uniform_buffer(uint32_t currentImage);
+    /* CPU side scene update for the next frame. Independent of the swapchain, so it can run ahead on its own thread. */
+    auto simulate_frame() const -> FrameUniforms;
+    /* Takes the camera the next recording sorts and picks levels of detail with, before anything is recorded */
+    void update_camera(const FrameUniforms& ubo);
+    /* Picks every scene draw's level of detail again, returning whether any draw picked a different one */
+    auto update_scene_draw_lods() -> bool;
+    void write_uniform_buffer(uint32_t frameIndex, FrameUniforms ubo);
+    /* Returns the command buffer to submit this frame, re-recording it only if the cached one is stale */
+    auto prepare_cmd_buffer(PerFrame& frame) -> vk::CommandBuffer;
+    void invalidate_recorded_commands();
+
     void record_cmd_buffer(const vk::CommandBuffer& cmd);
+    void record_depth_prepass(const vk::CommandBuffer& cmd);
+    /* cullPhases selects which of the GPU culling draw lists the pass draws */
+    void record_offscreen_pass(const RGPassContext& context, uint32_t cullPhases);
+    /* Sorts the scene's draws by their 64 bit keys before they are split between the recording threads */
+    void build_scene_draw_list();
+    void add_state_change_samples(const StateChangeStats& stateChanges);
+    /* Draws [firstDraw, firstDraw + drawCount) of the sorted draw list, or the whole scene when it is a single draw */
+    auto record_offscreen_draws(const vk::CommandBuffer& cmd,
+                                vk::Pipeline pipeline,
+                                uint32_t firstDraw,
+                                uint32_t drawCount,
+                                uint32_t cullPhases = CULL_PHASE_EARLY) -> StateChangeStats;
+
+    /* Allocates (or reuses) a secondary command buffer from the thread's pool and begins it for the context's dynamic rendering pass */
+    auto begin_secondary(ThreadCommands& threadCommands, const RGPassContext& context, vk::CommandBufferUsageFlags usage)
+        -> vk::CommandBuffer;
+    /* phase is CULL_PHASE_EARLY or CULL_PHASE_LATE */
+    void record_cull_pass(const vk::CommandBuffer& cmd, uint32_t phase);
+    void record_depth_pyramid_pass(const vk::CommandBuffer& cmd);
+    void record_post_pass(const vk::CommandBuffer& cmd);
+    void record_final_pass(const vk::CommandBuffer& cmd);
+
+    static void set_viewport_and_scissor(const vk::CommandBuffer& cmd, const vk::Extent2D& extent);
+
+    /* Remembers which passes and batches the slot's timestamp queries belong to */
+    static void store_timestamp_layout(PerFrame& frame, const RenderGraph& graph);
+    /* Collects the GPU pass timings, pipeline statistics and cull counts of the frame previously recorded in this slot */
+    void read_timestamps(PerFrame& frame);
+
+    /* Waits for the previous present to reach the screen, then sleeps until the latest safe start time for the next frame */
+    void throttle_frame_start();
+
+    /* Frame stages. draw_frame() runs them back to back, draw_frames_pipelined() overlaps them on separate threads. */
+    auto acquire_frame(PerFrame& frame) -> bool;
+    /* Waits until the GPU is done with the slot's previous frame and collects its results */
+    void wait_for_frame(PerFrame& frame);
+    auto acquire_image(PerFrame& frame) -> bool;
+    auto record_frame(PerFrame& frame) -> vk::CommandBuffer;
+    auto submit_frame(PerFrame& frame, vk::CommandBuffer cmd, uint32_t imageIndex, std::vector<vk::SemaphoreSubmitInfo> waits = {})
+        -> vk::Result;
+
+    /* Async compute mode: semaphore waits of a batch on the batches it depends on */
+    auto batch_waits(const PerFrame& frame, const RenderGraph& graph, uint32_t batch) const -> std::vector<vk::SemaphoreSubmitInfo>;
+    void submit_early_batches(PerFrame& frame);
+    auto record_present_batch(PerFrame& frame) -> vk::CommandBuffer;
+    /* Completes the pending frame's timeline value without presenting it, e.g. before swapchain recreation */
+    void retire_pending_frame();
 
     void draw_frame();
+    /* Presents each frame one iteration late, after the next frame's scene pass is queued, so that post-processing on the compute
+     * queue overlaps the next scene on the graphics queue */
+    void draw_frame_async();
+    void draw_frames_pipelined(const std::function<void()>& onFrameQueued);
     void main_loop();
 
-    void cleanup() const;
+    void cleanup();
+
+    /* Destroys the resource once every frame submitted so far has completed on the GPU */
+    void defer_destroy(std::function<void()>&& destroy);
+    void flush_deletion_queue(uint64_t completedFrames);
 
     /* Checks if all of the requested layers are available */
     static auto check_validation_layer_support() -> bool;
@@ -142,6 +520,10 @@ private:
 
     static auto check_device_extension_support(vk::PhysicalDevice device) -> bool;
 
+    static auto supports_present_wait(vk::PhysicalDevice device) -> bool;
+
+    static auto supports_gpu_culling(vk::PhysicalDevice device) -> bool;
+
     auto query_swap_chain_support(vk::PhysicalDevice device) -> SwapChainSupportDetails;
 
     auto is_device_suitable(vk::PhysicalDevice device) -> bool;
@@ -157,7 +539,10 @@ private:
      * Vvk::PresentModeKHR::eMailbox: Can be used to implement triple buffering, which allows you to avoid tearing with
      * significantly less latency issues than standard VSync that used double buffering.
      */
-    static auto choose_swap_present_mode(const std::vector<vk::PresentModeKHR>& availablePresentModes) -> vk::PresentModeKHR;
+    auto choose_swap_present_mode(const std::vector<vk::PresentModeKHR>& availablePresentModes) const -> vk::PresentModeKHR;
+
+    /* Honours the configured image count, clamped to what the surface supports */
+    auto choose_swap_image_count(const vk::SurfaceCapabilitiesKHR& capabilities) const -> uint32_t;
 
     /* Swap Extent us the resolution of the swap chain images and its almost
      * always exactly equal to the resolution of the window that we're drawing to.
@@ -168,6 +553,9 @@ private:
 
     auto find_memory_type(uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) -> uint32_t;
 
+    /* First depth format the device can render to, most precise first */
+    auto find_depth_format() const -> vk::Format;
+
     void create_buffer(vk::DeviceSize size,
                        const vk::BufferUsageFlags& usage,
                        const vk::MemoryPropertyFlags& properties,
@@ -180,12 +568,19 @@ private:
 
     void end_single_time_commands(vk::CommandBuffer commandBuffer);
 
-    void create_image(
-        uint32_t width, uint32_t height, vk::Format format, const vk::ImageUsageFlags& usage, vk::Image& image, VmaAllocation& allocation);
+    void create_image(uint32_t width,
+                      uint32_t height,
+                      vk::Format format,
+                      const vk::ImageUsageFlags& usage,
+                      vk::Image& image,
+                      VmaAllocation& allocation,
+                      uint32_t mipLevels = 1);
 
-    void copy_buffer_to_image(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height);
+    /* Copies tightly packed mip levels, one region per entry in mipOffsets */
+    void copy_buffer_to_image(vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height, const std::vector<size_t>& mipOffsets);
 
-    void transition_image_layout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+    void transition_image_layout(
+        vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t mipLevels = 1);
 
-    auto create_image_view(vk::Image image, vk::Format format) -> vk::ImageView;
+    auto create_image_view(vk::Image image, vk::Format format, uint32_t mipLevels = 1) -> vk::ImageView;
 };
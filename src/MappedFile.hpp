@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* Read-only memory mapping of a whole file. A failed open leaves the mapping closed rather than throwing, so callers can treat a
+ * missing file as a cache miss. */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+    auto is_open() const -> bool
+    {
+        return m_data != nullptr;
+    }
+
+    auto data() const -> const uint8_t*
+    {
+        return m_data;
+    }
+
+    auto size() const -> size_t
+    {
+        return m_size;
+    }
+
+    void close();
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
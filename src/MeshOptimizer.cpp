@@ -0,0 +1,526 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    /* Forsyth's tuning: the LRU cache size scored against, the flat score of the last triangle's vertices, and how strongly vertices
+     * with few triangles left are pulled forward so they do not end up stranded */
+    constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+    constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    /* Overdraw clusters shorter than this are not split any further */
+    constexpr uint32_t MIN_OVERDRAW_CLUSTER = 16;
+
+    auto forsyth_score(int32_t cachePosition, uint32_t remainingTriangles) -> float
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0 && cachePosition < 3)
+        {
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        }
+        else if (cachePosition >= 3)
+        {
+            float scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+        }
+
+        return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+    }
+
+    /* FIFO post-transform cache that can be emptied, as if drawing restarted at that point */
+    class FifoCacheSimulator
+    {
+    public:
+        explicit FifoCacheSimulator(size_t vertexCount, uint32_t cacheSize = ANALYZED_VERTEX_CACHE_SIZE)
+            : m_insertedAt(vertexCount, UINT32_MAX), m_cacheSize(cacheSize)
+        {
+        }
+
+        /* A vertex is cached while fewer than cacheSize misses have happened since it was inserted, and not since a reset */
+        auto access(uint32_t vertex) -> bool
+        {
+            uint32_t insertedAt = m_insertedAt[vertex];
+            if (insertedAt != UINT32_MAX && insertedAt >= m_resetAt && m_transformed - insertedAt < m_cacheSize)
+            {
+                return true;
+            }
+            m_insertedAt[vertex] = m_transformed++;
+            return false;
+        }
+
+        auto triangle_misses(const uint32_t* corners) -> uint32_t
+        {
+            return (access(corners[0]) ? 0 : 1) + (access(corners[1]) ? 0 : 1) + (access(corners[2]) ? 0 : 1);
+        }
+
+        auto transformed() const -> uint32_t
+        {
+            return m_transformed;
+        }
+
+        void reset()
+        {
+            m_resetAt = m_transformed;
+        }
+
+    private:
+        std::vector<uint32_t> m_insertedAt;
+        uint32_t m_cacheSize;
+        uint32_t m_transformed = 0;
+        uint32_t m_resetAt = 0;
+    };
+
+    /* Triangles of each vertex, as offsets into one shared list */
+    struct Adjacency
+    {
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+    auto build_adjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount) -> Adjacency
+    {
+        Adjacency adjacency;
+        adjacency.counts.assign(vertexCount, 0);
+        adjacency.offsets.assign(vertexCount, 0);
+        adjacency.triangles.resize(indices.size());
+
+        for (uint32_t index : indices)
+        {
+            adjacency.counts[index]++;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            adjacency.offsets[v] = offset;
+            offset += adjacency.counts[v];
+        }
+
+        std::vector<uint32_t> fill = adjacency.offsets;
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        return adjacency;
+    }
+
+    void check_indices(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        if (indices.size() % 3 != 0)
+        {
+            throw std::runtime_error("Mesh optimization needs a triangle list!");
+        }
+        for (uint32_t index : indices)
+        {
+            if (index >= vertexCount)
+            {
+                throw std::runtime_error("Mesh optimization index out of range!");
+            }
+        }
+    }
+}
+
+auto VertexCacheStats::operator+=(const VertexCacheStats& other) -> VertexCacheStats&
+{
+    triangleCount += other.triangleCount;
+    vertexCount += other.vertexCount;
+    transformedCount += other.transformedCount;
+    return *this;
+}
+
+auto MeshOptimizationReport::operator+=(const MeshOptimizationReport& other) -> MeshOptimizationReport&
+{
+    before += other.before;
+    after += other.after;
+    sourceVertices += other.sourceVertices;
+    optimizedVertices += other.optimizedVertices;
+    return *this;
+}
+
+auto analyze_vertex_cache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) -> VertexCacheStats
+{
+    VertexCacheStats stats;
+    stats.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+    FifoCacheSimulator cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        cache.access(index);
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            stats.vertexCount++;
+        }
+    }
+    stats.transformedCount = cache.transformed();
+
+    return stats;
+}
+
+auto find_duplicate_vertices(const std::vector<Vertex>& vertices) -> std::vector<uint32_t>
+{
+    // Open addressing over the vertex bytes. Vertex has no padding, so identical attributes mean identical bytes.
+    static_assert(sizeof(Vertex) == sizeof(float) * 8, "Vertex must not contain padding");
+
+    size_t tableSize = 1;
+    while (tableSize < vertices.size() * 2)
+    {
+        tableSize *= 2;
+    }
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);
+
+    auto hash = [](const Vertex& vertex) {
+        uint64_t h = 14695981039346656037ull;
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&vertex);
+        for (size_t i = 0; i < sizeof(Vertex); i++)
+        {
+            h = (h ^ bytes[i]) * 1099511628211ull;
+        }
+        return h;
+    };
+
+    std::vector<uint32_t> first(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        size_t slot = hash(vertices[v]) & (tableSize - 1);
+        while (table[slot] != UINT32_MAX && std::memcmp(&vertices[table[slot]], &vertices[v], sizeof(Vertex)) != 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] == UINT32_MAX)
+        {
+            table[slot] = static_cast<uint32_t>(v);
+        }
+        first[v] = table[slot];
+    }
+
+    return first;
+}
+
+auto deduplicate_vertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) -> uint32_t
+{
+    check_indices(indices, vertices.size());
+
+    std::vector<uint32_t> first = find_duplicate_vertices(vertices);
+
+    // A vertex's first occurrence never comes after it, so it already has its place in the unique ones
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        if (first[v] == v)
+        {
+            remap[v] = static_cast<uint32_t>(unique.size());
+            unique.push_back(vertices[v]);
+        }
+        else
+        {
+            remap[v] = remap[first[v]];
+        }
+    }
+
+    for (uint32_t& index : indices)
+    {
+        index = remap[index];
+    }
+
+    auto removed = static_cast<uint32_t>(vertices.size() - unique.size());
+    vertices = std::move(unique);
+    return removed;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    check_indices(indices, vertexCount);
+
+    auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Each vertex keeps its not yet emitted triangles at the front of its adjacency range
+    Adjacency adjacency = build_adjacency(indices, vertexCount);
+    std::vector<uint32_t>& remaining = adjacency.counts;
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        vertexScore[v] = forsyth_score(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    // Three extra slots hold the vertices pushed out by the triangle just emitted
+    std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> cache{};
+    std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> nextCache{};
+    uint32_t cacheCount = 0;
+
+    auto bestTriangle = static_cast<uint32_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    uint32_t deadEndCursor = 0;
+
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        if (bestTriangle == UINT32_MAX)
+        {
+            // Nothing in the cache has triangles left, so continue with the next unemitted triangle in input order
+            while (emitted[deadEndCursor])
+            {
+                deadEndCursor++;
+            }
+            bestTriangle = deadEndCursor;
+        }
+
+        emitted[bestTriangle] = 1;
+        const uint32_t* corners = &indices[bestTriangle * 3];
+        output.insert(output.end(), corners, corners + 3);
+
+        // The emitted triangle's vertices move to the front of the cache, everything else shifts back
+        uint32_t nextCount = 0;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            uint32_t vertex = corners[c];
+            if (std::find(nextCache.begin(), nextCache.begin() + nextCount, vertex) == nextCache.begin() + nextCount)
+            {
+                nextCache[nextCount++] = vertex;
+            }
+
+            uint32_t* triangles = &adjacency.triangles[adjacency.offsets[vertex]];
+            uint32_t* end = triangles + remaining[vertex];
+            uint32_t* found = std::find(triangles, end, bestTriangle);
+            if (found != end)
+            {
+                std::swap(*found, *(end - 1));
+                remaining[vertex]--;
+            }
+        }
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            uint32_t vertex = cache[i];
+            if (std::find(nextCache.begin(), nextCache.begin() + nextCount, vertex) == nextCache.begin() + nextCount)
+            {
+                nextCache[nextCount++] = vertex;
+            }
+        }
+
+        std::swap(cache, nextCache);
+        cacheCount = nextCount;
+
+        // Rescore the vertices whose cache position changed, including those that just fell out, and pick the best triangle
+        // touching the cache
+        bestTriangle = UINT32_MAX;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            uint32_t vertex = cache[i];
+            int32_t position = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            cachePosition[vertex] = position;
+
+            float score = forsyth_score(position, remaining[vertex]);
+            float delta = score - vertexScore[vertex];
+            vertexScore[vertex] = score;
+
+            const uint32_t* triangles = &adjacency.triangles[adjacency.offsets[vertex]];
+            for (uint32_t t = 0; t < remaining[vertex]; t++)
+            {
+                triangleScore[triangles[t]] += delta;
+            }
+        }
+        for (uint32_t i = 0; i < std::min(cacheCount, FORSYTH_CACHE_SIZE); i++)
+        {
+            uint32_t vertex = cache[i];
+            const uint32_t* triangles = &adjacency.triangles[adjacency.offsets[vertex]];
+            for (uint32_t t = 0; t < remaining[vertex]; t++)
+            {
+                if (triangleScore[triangles[t]] > bestScore)
+                {
+                    bestScore = triangleScore[triangles[t]];
+                    bestTriangle = triangles[t];
+                }
+            }
+        }
+
+        cacheCount = std::min(cacheCount, FORSYTH_CACHE_SIZE);
+    }
+
+    indices = std::move(output);
+}
+
+void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+    check_indices(indices, vertices.size());
+
+    auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount < MIN_OVERDRAW_CLUSTER * 2)
+    {
+        return;
+    }
+
+    // Hard boundaries where a triangle misses on all three vertices, since locality restarts there whatever comes before
+    FifoCacheSimulator cache(vertices.size());
+    std::vector<uint32_t> hard = { 0 };
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        if (cache.triangle_misses(&indices[t * 3]) == 3 && t > 0)
+        {
+            hard.push_back(t);
+        }
+    }
+    hard.push_back(triangleCount);
+
+    // Soft boundaries inside each hard cluster. Clusters are drawn in a new order, so each is costed from a cold cache and split
+    // wherever its ACMR so far is within the threshold of the whole hard cluster's.
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++)
+    {
+        uint32_t begin = hard[h];
+        uint32_t end = hard[h + 1];
+
+        cache.reset();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; t++)
+        {
+            clusterMisses += cache.triangle_misses(&indices[t * 3]);
+        }
+        float limit = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        clusters.push_back(begin);
+        cache.reset();
+        uint32_t start = begin;
+        uint32_t runMisses = 0;
+        for (uint32_t t = begin; t < end; t++)
+        {
+            runMisses += cache.triangle_misses(&indices[t * 3]);
+            uint32_t length = t + 1 - start;
+            if (length >= MIN_OVERDRAW_CLUSTER && end - (t + 1) >= MIN_OVERDRAW_CLUSTER &&
+                static_cast<float>(runMisses) / static_cast<float>(length) <= limit)
+            {
+                clusters.push_back(t + 1);
+                cache.reset();
+                start = t + 1;
+                runMisses = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Clusters pointing away from the mesh centre occlude the rest more often than they are occluded, so they go first
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    auto clusterCount = static_cast<uint32_t>(clusters.size() - 1);
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        float clusterArea = 0.0f;
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+
+            centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[c] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += centroids[c];
+        meshArea += clusterArea;
+        centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : vertices[indices[clusters[c] * 3]].pos;
+
+        float normalLength = glm::length(normals[c]);
+        normals[c] = normalLength > 0.0f ? normals[c] / normalLength : glm::vec3(0.0f);
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+    std::vector<float> sortKeys(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+    {
+        sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order)
+    {
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices = std::move(output);
+}
+
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    check_indices(indices, vertices.size());
+
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(ordered);
+}
+
+auto optimize_mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) -> MeshOptimizationReport
+{
+    MeshOptimizationReport report;
+    report.sourceVertices = static_cast<uint32_t>(vertices.size());
+    report.before = analyze_vertex_cache(indices, static_cast<uint32_t>(vertices.size()));
+
+    deduplicate_vertices(vertices, indices);
+    optimize_vertex_cache(indices, static_cast<uint32_t>(vertices.size()));
+    optimize_overdraw(indices, vertices);
+    optimize_vertex_fetch(vertices, indices);
+
+    report.optimizedVertices = static_cast<uint32_t>(vertices.size());
+    report.after = analyze_vertex_cache(indices, static_cast<uint32_t>(vertices.size()));
+
+    return report;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VertexFormat.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/* FIFO size of the post-transform cache the statistics simulate, a conservative stand in for what current GPUs reuse */
+constexpr uint32_t ANALYZED_VERTEX_CACHE_SIZE = 16;
+
+/* Post-transform vertex cache behaviour of an index buffer */
+struct VertexCacheStats
+{
+    uint32_t triangleCount = 0;
+    /* Distinct vertices the indices reference */
+    uint32_t vertexCount = 0;
+    /* Vertex shader invocations, one per cache miss */
+    uint32_t transformedCount = 0;
+
+    /* Average cache miss ratio, transformed vertices per triangle. 0.5 is the ideal for a regular grid, 3 means no reuse at all. */
+    auto acmr() const -> float
+    {
+        return triangleCount > 0 ? static_cast<float>(transformedCount) / static_cast<float>(triangleCount) : 0.0f;
+    }
+
+    /* Average transform to vertex ratio, 1 when every vertex is shaded exactly once */
+    auto atvr() const -> float
+    {
+        return vertexCount > 0 ? static_cast<float>(transformedCount) / static_cast<float>(vertexCount) : 0.0f;
+    }
+
+    auto operator+=(const VertexCacheStats& other) -> VertexCacheStats&;
+};
+
+auto analyze_vertex_cache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = ANALYZED_VERTEX_CACHE_SIZE)
+    -> VertexCacheStats;
+
+/* For each vertex, the first one bitwise identical to it, which is the vertex itself for all but duplicates */
+auto find_duplicate_vertices(const std::vector<Vertex>& vertices) -> std::vector<uint32_t>;
+
+/* Merges bitwise identical vertices and rewrites the indices to match. Returns how many were removed. */
+auto deduplicate_vertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) -> uint32_t;
+
+/* Reorders triangles for post-transform cache reuse with Forsyth's linear-speed algorithm, simulating a 32 entry LRU cache */
+void optimize_vertex_cache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+/*
+ * Reorders clusters of a cache optimized index buffer so that triangles facing out of the mesh are drawn first, which lets the depth
+ * test reject more of what lies behind them (Sander, Nehab and Barczak, 2007). Clusters are split where the cache restarts anyway,
+ * or where the ACMR so far stays within threshold times that of the whole cluster, so locality is mostly kept.
+ */
+void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+/* Reorders vertices into the order the indices first use them, so fetches walk the vertex buffer forwards. Unreferenced vertices
+ * are dropped. */
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+struct MeshOptimizationReport
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    uint32_t sourceVertices = 0;
+    uint32_t optimizedVertices = 0;
+
+    auto operator+=(const MeshOptimizationReport& other) -> MeshOptimizationReport&;
+};
+
+/* All of the above in order: deduplication, vertex cache, overdraw and then fetch order */
+auto optimize_mesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) -> MeshOptimizationReport;
@@ -0,0 +1,443 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "MeshSimplifier.hpp"
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    /* A level keeping more than this fraction of the triangles it was simplified from is not worth an index range of its own */
+    constexpr double MAX_LOD_TRIANGLE_RATIO = 0.85;
+
+    /* Cosine of the largest turn a collapse may give a triangle's normal, about 75 degrees. Beyond it the surface is close to
+     * folding over. */
+    constexpr double MIN_NORMAL_COSINE = 0.25;
+
+    /* Sum of squared distances to a set of planes, each weighted by the area of its triangle. Stored as the upper half of the
+     * symmetric 4x4 matrix Q of p^T Q p, with p = (x, y, z, 1). */
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+        double weight = 0.0;
+
+        /* The plane n.p + d = 0, with n of unit length */
+        void add_plane(const glm::dvec3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x;
+            a01 += w * n.x * n.y;
+            a02 += w * n.x * n.z;
+            a03 += w * n.x * d;
+            a11 += w * n.y * n.y;
+            a12 += w * n.y * n.z;
+            a13 += w * n.y * d;
+            a22 += w * n.z * n.z;
+            a23 += w * n.z * d;
+            a33 += w * d * d;
+            weight += w;
+        }
+
+        auto operator+=(const Quadric& other) -> Quadric&
+        {
+            a00 += other.a00;
+            a01 += other.a01;
+            a02 += other.a02;
+            a03 += other.a03;
+            a11 += other.a11;
+            a12 += other.a12;
+            a13 += other.a13;
+            a22 += other.a22;
+            a23 += other.a23;
+            a33 += other.a33;
+            weight += other.weight;
+            return *this;
+        }
+
+        /* Area weighted mean of the squared distances from p to the planes. Only ranks collapses, it is no bound on any distance. */
+        auto error(const glm::vec3& p) const -> double
+        {
+            double x = p.x;
+            double y = p.y;
+            double z = p.z;
+            double sum = a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+                         2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x + a13 * y + a23 * z);
+            return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+        }
+    };
+
+    /* Moving vertex from onto vertex to, at the mean squared error it would leave */
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    auto edge_key(uint32_t a, uint32_t b) -> uint64_t
+    {
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    auto triangle_normal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) -> glm::dvec3
+    {
+        return glm::cross(glm::dvec3(p1) - glm::dvec3(p0), glm::dvec3(p2) - glm::dvec3(p0));
+    }
+
+    /* Maps every index through remap and drops the triangles that end up with a repeated vertex */
+    void remap_triangles(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t a = remap[indices[i]];
+            uint32_t b = remap[indices[i + 1]];
+            uint32_t c = remap[indices[i + 2]];
+            if (a == b || b == c || c == a)
+            {
+                continue;
+            }
+
+            indices[written++] = a;
+            indices[written++] = b;
+            indices[written++] = c;
+        }
+        indices.resize(written);
+    }
+}
+
+auto simplify_mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError)
+    -> SimplifiedMesh
+{
+    if (indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("Mesh simplification needs a triangle list!");
+    }
+    for (uint32_t index : indices)
+    {
+        if (index >= vertices.size())
+        {
+            throw std::runtime_error("Mesh simplification index out of range!");
+        }
+    }
+
+    // Identical vertices are welded first, so that only real borders and attribute seams separate triangles
+    SimplifiedMesh result;
+    result.indices = indices;
+    remap_triangles(result.indices, find_duplicate_vertices(vertices));
+
+    if (result.indices.size() <= targetIndexCount)
+    {
+        return result;
+    }
+
+    auto vertexCount = static_cast<uint32_t>(vertices.size());
+
+    // An edge is interior when exactly one triangle uses it in each direction. Anything else is a border, a seam or non-manifold,
+    // and its ends are locked.
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(result.indices.size());
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                edges.push_back(edge_key(result.indices[i + corner], result.indices[i + (corner + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        auto count = [&](uint64_t key) {
+            auto range = std::equal_range(edges.begin(), edges.end(), key);
+            return range.second - range.first;
+        };
+
+        for (uint64_t key : edges)
+        {
+            auto a = static_cast<uint32_t>(key >> 32);
+            auto b = static_cast<uint32_t>(key & 0xffffffffu);
+            if (count(key) != 1 || count(edge_key(b, a)) != 1)
+            {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+
+    // Planes of the source triangles. A vertex's quadric and plane list take over those of the vertices collapsed onto it, so errors
+    // are always measured against the original surface. The quadric ranks collapses, the planes give the actual distance.
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<glm::dvec4> planes;
+    std::vector<std::vector<uint32_t>> vertexPlanes(vertexCount);
+    for (size_t i = 0; i < result.indices.size(); i += 3)
+    {
+        const glm::vec3& p0 = vertices[result.indices[i]].pos;
+        glm::dvec3 normal = triangle_normal(p0, vertices[result.indices[i + 1]].pos, vertices[result.indices[i + 2]].pos);
+        double length = glm::length(normal);
+        if (length == 0.0)
+        {
+            continue;
+        }
+
+        normal /= length;
+        double d = -glm::dot(normal, glm::dvec3(p0));
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            quadrics[result.indices[i + corner]].add_plane(normal, d, length * 0.5);
+            vertexPlanes[result.indices[i + corner]].push_back(static_cast<uint32_t>(planes.size()));
+        }
+        planes.emplace_back(normal, d);
+    }
+
+    // Largest distance from a vertex to the source planes it carries
+    auto planeDistance = [&](const glm::vec3& p, const std::vector<uint32_t>& planeIndices) {
+        double distance = 0.0;
+        for (uint32_t plane : planeIndices)
+        {
+            distance = std::max(distance, std::abs(glm::dot(glm::dvec3(planes[plane]), glm::dvec3(p)) + planes[plane].w));
+        }
+        return distance;
+    };
+
+    double maxErrorSquared = static_cast<double>(maxError) * static_cast<double>(maxError);
+    double largestError = 0.0;
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> marks(vertexCount, 0);
+    uint32_t mark = 0;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    // Each pass collapses the cheapest edges whose neighbourhoods do not overlap, then rebuilds the adjacency from the result
+    while (result.indices.size() > targetIndexCount)
+    {
+        size_t triangleCount = result.indices.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (uint32_t index : result.indices)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(result.indices.size());
+        {
+            std::vector<uint32_t> filled(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.indices.size(); i++)
+            {
+                adjacency[filled[result.indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // An interior edge runs a < b in exactly one of its two triangles, so each is listed once. The free end collapses onto the
+        // other, the cheaper way round when both are free.
+        collapses.clear();
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t a = result.indices[i + corner];
+                uint32_t b = result.indices[i + (corner + 1) % 3];
+                if (a > b || (locked[a] && locked[b]))
+                {
+                    continue;
+                }
+
+                Quadric merged = quadrics[a];
+                merged += quadrics[b];
+                double aOntoB = locked[a] ? std::numeric_limits<double>::max() : merged.error(vertices[b].pos);
+                double bOntoA = locked[b] ? std::numeric_limits<double>::max() : merged.error(vertices[a].pos);
+                collapses.push_back(aOntoB <= bOntoA ? Collapse{ a, b, aOntoB } : Collapse{ b, a, bOntoA });
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+        auto trianglesOf = [&](uint32_t vertex) {
+            return std::make_pair(adjacency.begin() + adjacencyOffsets[vertex], adjacency.begin() + adjacencyOffsets[vertex + 1]);
+        };
+
+        auto canCollapse = [&](const Collapse& collapse) {
+            // The ends may only share the two vertices opposite the edge, or the collapse pinches the surface into a non-manifold one
+            mark += 2;
+            auto [toBegin, toEnd] = trianglesOf(collapse.to);
+            for (auto t = toBegin; t != toEnd; ++t)
+            {
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    marks[result.indices[*t * 3 + corner]] = mark;
+                }
+            }
+
+            uint32_t shared = 0;
+            auto [fromBegin, fromEnd] = trianglesOf(collapse.from);
+            for (auto t = fromBegin; t != fromEnd; ++t)
+            {
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t vertex = result.indices[*t * 3 + corner];
+                    if (vertex != collapse.from && vertex != collapse.to && marks[vertex] == mark)
+                    {
+                        marks[vertex] = mark + 1;
+                        shared++;
+                    }
+                }
+            }
+            if (shared != 2)
+            {
+                return false;
+            }
+
+            // The triangles that survive must not turn too far, let alone flip
+            const glm::vec3& target = vertices[collapse.to].pos;
+            for (auto t = fromBegin; t != fromEnd; ++t)
+            {
+                const uint32_t* triangle = &result.indices[*t * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    continue;
+                }
+
+                std::array<glm::vec3, 3> moved = { vertices[triangle[0]].pos, vertices[triangle[1]].pos, vertices[triangle[2]].pos };
+                glm::dvec3 before = triangle_normal(moved[0], moved[1], moved[2]);
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    if (triangle[corner] == collapse.from)
+                    {
+                        moved[corner] = target;
+                    }
+                }
+                glm::dvec3 after = triangle_normal(moved[0], moved[1], moved[2]);
+
+                double afterLength = glm::length(after);
+                if (afterLength == 0.0 || glm::dot(before, after) < MIN_NORMAL_COSINE * glm::length(before) * afterLength)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        size_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+        size_t removedTriangles = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            // No plane is further away than the mean, so every later collapse would exceed maxError as well
+            if (collapse.error > maxErrorSquared)
+            {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] || !canCollapse(collapse))
+            {
+                continue;
+            }
+
+            // to stays where it is, so only the planes coming over from the other vertex can move further away from it
+            double distance = planeDistance(vertices[collapse.to].pos, vertexPlanes[collapse.from]);
+            if (distance > maxError)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            std::vector<uint32_t>& toPlanes = vertexPlanes[collapse.to];
+            toPlanes.insert(toPlanes.end(), vertexPlanes[collapse.from].begin(), vertexPlanes[collapse.from].end());
+            vertexPlanes[collapse.from] = {};
+            largestError = std::max(largestError, distance);
+
+            // Every triangle around from changes, so nothing else they touch collapses until the next pass has rebuilt them
+            auto [fromBegin, fromEnd] = trianglesOf(collapse.from);
+            for (auto t = fromBegin; t != fromEnd; ++t)
+            {
+                const uint32_t* triangle = &result.indices[*t * 3];
+                touched[triangle[0]] = 1;
+                touched[triangle[1]] = 1;
+                touched[triangle[2]] = 1;
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    removedTriangles++;
+                }
+            }
+
+            if (removedTriangles >= trianglesToRemove)
+            {
+                break;
+            }
+        }
+
+        if (removedTriangles == 0)
+        {
+            break;
+        }
+
+        remap_triangles(result.indices, remap);
+    }
+
+    result.error = static_cast<float>(largestError);
+    return result;
+}
+
+auto build_mesh_lods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float maxRelativeError) -> std::vector<MeshLod>
+{
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (uint32_t index : indices)
+    {
+        boundsMin = glm::min(boundsMin, vertices.at(index).pos);
+        boundsMax = glm::max(boundsMax, vertices.at(index).pos);
+    }
+    float maxError = indices.empty() ? 0.0f : maxRelativeError * glm::length(boundsMax - boundsMin);
+
+    std::vector<MeshLod> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    std::vector<uint32_t> level(indices);
+    while (lods.size() < MAX_MESH_LODS)
+    {
+        SimplifiedMesh simplified = simplify_mesh(vertices, level, level.size() / 6 * 3, maxError - lods.back().error);
+        if (simplified.indices.empty() ||
+            static_cast<double>(simplified.indices.size()) > static_cast<double>(level.size()) * MAX_LOD_TRIANGLE_RATIO)
+        {
+            break;
+        }
+
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.indices.size());
+        lod.error = lods.back().error + simplified.error;
+        lods.push_back(lod);
+        indices.insert(indices.end(), simplified.indices.begin(), simplified.indices.end());
+        level = std::move(simplified.indices);
+    }
+
+    return lods;
+}
+
+void MeshLodReport::add(const std::vector<MeshLod>& lods)
+{
+    if (lods.empty())
+    {
+        return;
+    }
+
+    meshCount++;
+    levelCount += static_cast<uint32_t>(lods.size());
+    sourceTriangles += lods.front().indexCount / 3;
+    coarsestTriangles += lods.back().indexCount / 3;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "VertexFormat.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Most levels build_mesh_lods makes, the source mesh included */
+constexpr uint32_t MAX_MESH_LODS = 8;
+
+/* One level of a LOD chain: its range of the index buffer, and a bound on how far its vertices lie from the planes of the source
+ * triangles they replace, in the mesh's own units. Matches MeshLod in cull.comp. */
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+};
+
+struct SimplifiedMesh
+{
+    std::vector<uint32_t> indices;
+    /* Largest distance from a remaining vertex to the planes of the source triangles collapsed into it, in the mesh's units */
+    float error = 0.0f;
+};
+
+/*
+ * Edge collapse driven by quadric error metrics (Garland and Heckbert, 1997), down towards targetIndexCount indices without any
+ * collapse exceeding maxError. Vertices collapse onto one another rather than moving, so the result indexes the same vertex buffer.
+ * Vertices on an open border or an attribute seam, where an edge belongs to a single triangle, stay in place.
+ */
+auto simplify_mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError)
+    -> SimplifiedMesh;
+
+/*
+ * Appends coarser levels to indices, each simplified from the one before to about half its triangles, until a level gains too little
+ * or would deviate by more than maxRelativeError times the mesh's bounding box diagonal. Level 0 is the source indices as passed in,
+ * and errors accumulate down the chain so they never decrease.
+ */
+auto build_mesh_lods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, float maxRelativeError) -> std::vector<MeshLod>;
+
+/* Totals over the LOD chains of a scene */
+struct MeshLodReport
+{
+    uint32_t meshCount = 0;
+    uint32_t levelCount = 0;
+    size_t sourceTriangles = 0;
+    size_t coarsestTriangles = 0;
+
+    void add(const std::vector<MeshLod>& lods);
+};
@@ -0,0 +1,174 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "Meshlets.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    /* Cones wider than this cannot cull anything useful, so they are disabled */
+    constexpr float MIN_CONE_DOT = 0.1f;
+
+    void compute_bounds(const std::vector<glm::vec3>& positions, const MeshletMesh& mesh, const Meshlet& meshlet, MeshletBounds& bounds)
+    {
+        const uint32_t* vertices = &mesh.vertices[meshlet.vertexOffset];
+        const uint8_t* triangles = &mesh.triangles[meshlet.triangleOffset * 3];
+
+        // Sphere around the centre of the bounding box. Not minimal, but within a few percent for the compact shapes we get here.
+        glm::vec3 minPos(std::numeric_limits<float>::max());
+        glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+        {
+            minPos = glm::min(minPos, positions[vertices[v]]);
+            maxPos = glm::max(maxPos, positions[vertices[v]]);
+        }
+
+        bounds.center = (minPos + maxPos) * 0.5f;
+        bounds.radius = 0.0f;
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+        {
+            bounds.radius = std::max(bounds.radius, glm::length(positions[vertices[v]] - bounds.center));
+        }
+
+        // The cone axis is the average triangle normal, the cutoff follows from the normal furthest from it
+        std::vector<glm::vec3> normals(meshlet.triangleCount);
+        glm::vec3 normalSum(0.0f);
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            const glm::vec3& p0 = positions[vertices[triangles[t * 3 + 0]]];
+            const glm::vec3& p1 = positions[vertices[triangles[t * 3 + 1]]];
+            const glm::vec3& p2 = positions[vertices[triangles[t * 3 + 2]]];
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            normals[t] = area > 0.0f ? normal / area : glm::vec3(0.0f);
+            normalSum += normals[t];
+        }
+
+        float axisLength = glm::length(normalSum);
+        bounds.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+        bounds.coneApex = bounds.center;
+        bounds.coneCutoff = 2.0f;
+
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals)
+        {
+            minDot = std::min(minDot, glm::dot(normal, bounds.coneAxis));
+        }
+
+        if (axisLength == 0.0f || minDot <= MIN_CONE_DOT)
+        {
+            return;
+        }
+
+        // Move the apex back along the axis until it is behind the plane of every triangle, so the test holds for viewers
+        // anywhere, not just far away
+        float maxT = 0.0f;
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            const glm::vec3& p0 = positions[vertices[triangles[t * 3]]];
+            float distance = glm::dot(bounds.center - p0, normals[t]);
+            float along = glm::dot(bounds.coneAxis, normals[t]);
+            if (along > 0.0f)
+            {
+                maxT = std::max(maxT, distance / along);
+            }
+        }
+
+        bounds.coneApex = bounds.center - bounds.coneAxis * maxT;
+        bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+auto build_meshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) -> MeshletMesh
+{
+    if (indices.size() % 3 != 0)
+    {
+        throw std::runtime_error("Meshlets need a triangle list!");
+    }
+
+    MeshletMesh mesh;
+
+    // Local index of each source vertex in the meshlet being built, valid while localStamp matches the meshlet number
+    std::vector<uint8_t> localIndex(positions.size());
+    std::vector<uint32_t> localStamp(positions.size(), UINT32_MAX);
+
+    Meshlet current{};
+
+    auto flush = [&] {
+        if (current.triangleCount == 0)
+        {
+            return;
+        }
+        mesh.meshlets.push_back(current);
+        current = Meshlet{};
+        current.vertexOffset = static_cast<uint32_t>(mesh.vertices.size());
+        current.triangleOffset = static_cast<uint32_t>(mesh.triangles.size() / 3);
+    };
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        auto stamp = static_cast<uint32_t>(mesh.meshlets.size());
+
+        uint32_t newVertices = 0;
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[i + corner];
+            if (vertex >= positions.size())
+            {
+                throw std::runtime_error("Meshlet index out of range!");
+            }
+            newVertices += localStamp[vertex] != stamp ? 1 : 0;
+        }
+        // Degenerate triangles referencing one vertex twice are counted twice, which only ever splits early
+
+        if (current.vertexCount + newVertices > MAX_MESHLET_VERTICES || current.triangleCount == MAX_MESHLET_TRIANGLES)
+        {
+            flush();
+            stamp = static_cast<uint32_t>(mesh.meshlets.size());
+        }
+
+        for (size_t corner = 0; corner < 3; corner++)
+        {
+            uint32_t vertex = indices[i + corner];
+            if (localStamp[vertex] != stamp)
+            {
+                localStamp[vertex] = stamp;
+                localIndex[vertex] = static_cast<uint8_t>(current.vertexCount++);
+                mesh.vertices.push_back(vertex);
+            }
+            mesh.triangles.push_back(localIndex[vertex]);
+        }
+        current.triangleCount++;
+    }
+    flush();
+
+    mesh.bounds.resize(mesh.meshlets.size());
+    for (size_t m = 0; m < mesh.meshlets.size(); m++)
+    {
+        compute_bounds(positions, mesh, mesh.meshlets[m], mesh.bounds[m]);
+    }
+
+    return mesh;
+}
+
+auto meshlet_index_buffer(const MeshletMesh& mesh) -> std::vector<uint32_t>
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(mesh.triangles.size());
+
+    for (const Meshlet& meshlet : mesh.meshlets)
+    {
+        for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++)
+        {
+            indices.push_back(mesh.vertices[meshlet.vertexOffset + mesh.triangles[meshlet.triangleOffset * 3 + i]]);
+        }
+    }
+
+    return indices;
+}
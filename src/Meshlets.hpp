@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+/* A cluster of triangles sharing at most MAX_MESHLET_VERTICES vertices. Offsets point into the arrays of MeshletMesh. */
+struct Meshlet
+{
+    uint32_t vertexOffset;
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+/*
+ * Culling data of a meshlet, in the space of the input positions. Every triangle of the cluster faces away from a viewer at eye when
+ * dot(normalize(coneApex - eye), coneAxis) >= coneCutoff. Clusters whose normals spread too far get a cutoff of 2, which never culls.
+ */
+struct MeshletBounds
+{
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneApex;
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+struct MeshletMesh
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+
+    /* Index of the source vertex for each meshlet local vertex */
+    std::vector<uint32_t> vertices;
+
+    /* Three meshlet local vertex indices per triangle */
+    std::vector<uint8_t> triangles;
+};
+
+/*
+ * Splits an indexed triangle list into meshlets, keeping triangles in their input order. Meshes that went through a vertex cache
+ * optimizer produce tighter clusters, since neighbouring triangles then share most of their vertices.
+ */
+auto build_meshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) -> MeshletMesh;
+
+/* Expands the meshlets back into a triangle list of source vertex indices. Meshlet i covers indices triangleOffset * 3 up to
+ * (triangleOffset + triangleCount) * 3, so each cluster can be drawn with an ordinary indexed draw when there are no mesh shaders. */
+auto meshlet_index_buffer(const MeshletMesh& mesh) -> std::vector<uint32_t>;
@@ -0,0 +1,823 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "RenderGraph.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr vk::AccessFlags2 WRITE_ACCESS_MASK = vk::AccessFlagBits2::eColorAttachmentWrite |
+                                                   vk::AccessFlagBits2::eDepthStencilAttachmentWrite |
+                                                   vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eShaderWrite |
+                                                   vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eMemoryWrite;
+
+    auto has_write(vk::AccessFlags2 access) -> bool
+    {
+        return static_cast<bool>(access & WRITE_ACCESS_MASK);
+    }
+
+    struct AccessInfo
+    {
+        RGImageState state;
+        vk::ImageUsageFlags usage;
+    };
+
+    auto aspect_mask(vk::Format format) -> vk::ImageAspectFlags
+    {
+        switch (format)
+        {
+            case vk::Format::eD16Unorm:
+            case vk::Format::eX8D24UnormPack32:
+            case vk::Format::eD32Sfloat: return vk::ImageAspectFlagBits::eDepth;
+            case vk::Format::eD16UnormS8Uint:
+            case vk::Format::eD24UnormS8Uint:
+            case vk::Format::eD32SfloatS8Uint: return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+            case vk::Format::eS8Uint: return vk::ImageAspectFlagBits::eStencil;
+            default: return vk::ImageAspectFlagBits::eColor;
+        }
+    }
+
+    auto access_info(RGAccess access, vk::AttachmentLoadOp loadOp) -> AccessInfo
+    {
+        switch (access)
+        {
+            case RGAccess::ColorAttachment:
+            {
+                vk::AccessFlags2 accessMask = vk::AccessFlagBits2::eColorAttachmentWrite;
+                if (loadOp == vk::AttachmentLoadOp::eLoad)
+                {
+                    accessMask |= vk::AccessFlagBits2::eColorAttachmentRead;
+                }
+                return { { vk::ImageLayout::eColorAttachmentOptimal, vk::PipelineStageFlagBits2::eColorAttachmentOutput, accessMask },
+                         vk::ImageUsageFlagBits::eColorAttachment };
+            }
+            case RGAccess::DepthAttachment:
+                // The depth test reads the attachment even when the pass clears it
+                return { { vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                           vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+                           vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite },
+                         vk::ImageUsageFlagBits::eDepthStencilAttachment };
+            case RGAccess::DepthRead:
+                return { { vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+                           vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+                           vk::AccessFlagBits2::eDepthStencilAttachmentRead },
+                         vk::ImageUsageFlagBits::eDepthStencilAttachment };
+            case RGAccess::SampledFragment:
+                return { { vk::ImageLayout::eShaderReadOnlyOptimal,
+                           vk::PipelineStageFlagBits2::eFragmentShader,
+                           vk::AccessFlagBits2::eShaderSampledRead },
+                         vk::ImageUsageFlagBits::eSampled };
+            case RGAccess::SampledCompute:
+                return { { vk::ImageLayout::eShaderReadOnlyOptimal,
+                           vk::PipelineStageFlagBits2::eComputeShader,
+                           vk::AccessFlagBits2::eShaderSampledRead },
+                         vk::ImageUsageFlagBits::eSampled };
+            case RGAccess::StorageReadCompute:
+                return { { vk::ImageLayout::eGeneral, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead },
+                         vk::ImageUsageFlagBits::eStorage };
+            case RGAccess::StorageWriteCompute:
+                return { { vk::ImageLayout::eGeneral,
+                           vk::PipelineStageFlagBits2::eComputeShader,
+                           vk::AccessFlagBits2::eShaderStorageWrite },
+                         vk::ImageUsageFlagBits::eStorage };
+        }
+
+        throw std::runtime_error("Unknown render graph access!");
+    }
+}
+
+/* RGPassBuilder */
+
+RGPassBuilder::RGPassBuilder(RenderGraph& graph, uint32_t passIndex) : m_graph(graph), m_passIndex(passIndex) {}
+
+void RGPassBuilder::write_color(RGResource resource, vk::AttachmentLoadOp loadOp, const vk::ClearColorValue& clearValue)
+{
+    m_graph.m_passes[m_passIndex].uses.push_back({ resource, RGAccess::ColorAttachment, true, loadOp, vk::ClearValue(clearValue) });
+}
+
+void RGPassBuilder::write_depth(RGResource resource, vk::AttachmentLoadOp loadOp, float clearDepth)
+{
+    vk::ClearValue clearValue(vk::ClearDepthStencilValue(clearDepth, 0));
+    m_graph.m_passes[m_passIndex].uses.push_back({ resource, RGAccess::DepthAttachment, true, loadOp, clearValue });
+}
+
+void RGPassBuilder::read(RGResource resource, RGAccess access)
+{
+    m_graph.m_passes[m_passIndex].uses.push_back({ resource, access, false });
+}
+
+void RGPassBuilder::write(RGResource resource, RGAccess access)
+{
+    m_graph.m_passes[m_passIndex].uses.push_back({ resource, access, true });
+}
+
+void RGPassBuilder::set_side_effects()
+{
+    m_graph.m_passes[m_passIndex].sideEffects = true;
+}
+
+void RGPassBuilder::set_secondary_command_buffers()
+{
+    m_graph.m_passes[m_passIndex].secondaryCommandBuffers = true;
+}
+
+void RGPassBuilder::set_pipeline_statistics()
+{
+    m_graph.m_passes[m_passIndex].pipelineStatistics = true;
+}
+
+void RGPassBuilder::set_render_extent(std::function<vk::Extent2D()> renderExtent)
+{
+    m_graph.m_passes[m_passIndex].renderExtent = std::move(renderExtent);
+}
+
+/* RGPassContext */
+
+auto RGPassContext::image(RGResource resource) const -> vk::Image
+{
+    return m_graph->image(resource);
+}
+
+auto RGPassContext::view(RGResource resource) const -> vk::ImageView
+{
+    return m_graph->view(resource);
+}
+
+auto RGPassContext::extent(RGResource resource) const -> vk::Extent2D
+{
+    return m_graph->extent(resource);
+}
+
+/* RenderGraph */
+
+RenderGraph::RenderGraph(vk::Device device, VmaAllocator allocator) : m_device(device), m_allocator(allocator) {}
+
+RenderGraph::~RenderGraph()
+{
+    destroy();
+}
+
+auto RenderGraph::create_image(const std::string& name, const RGImageDesc& desc) -> RGResource
+{
+    Resource resource{};
+    resource.name = name;
+    resource.desc = desc;
+
+    m_resources.push_back(resource);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+auto RenderGraph::import_image(const std::string& name,
+                               const RGImageDesc& desc,
+                               const RGImageState& initialState,
+                               const RGImageState& finalState) -> RGResource
+{
+    Resource resource{};
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = true;
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+
+    m_resources.push_back(resource);
+    return static_cast<RGResource>(m_resources.size() - 1);
+}
+
+void RenderGraph::set_imported_image(RGResource resource, vk::Image image, vk::ImageView view)
+{
+    m_resources[resource].image = image;
+    m_resources[resource].view = view;
+}
+
+void RenderGraph::mark_output(RGResource resource)
+{
+    m_resources[resource].output = true;
+}
+
+void RenderGraph::add_graphics_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute)
+{
+    add_pass(name, true, RGQueue::Graphics, setup, std::move(execute));
+}
+
+void RenderGraph::add_compute_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute, RGQueue queue)
+{
+    add_pass(name, false, queue, setup, std::move(execute));
+}
+
+void RenderGraph::set_queue_families(uint32_t graphicsFamily, uint32_t computeFamily)
+{
+    m_graphicsFamily = graphicsFamily;
+    m_computeFamily = computeFamily;
+}
+
+void RenderGraph::add_pass(const std::string& name, bool graphics, RGQueue queue, const SetupFn& setup, ExecuteFn execute)
+{
+    if (m_compiled)
+    {
+        throw std::runtime_error("Cannot add passes to a compiled render graph!");
+    }
+
+    Pass pass{};
+    pass.name = name;
+    pass.graphics = graphics;
+    pass.queue = queue;
+    pass.execute = std::move(execute);
+    m_passes.push_back(std::move(pass));
+
+    RGPassBuilder builder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::compile()
+{
+    cull_passes();
+    compute_lifetimes();
+    allocate_transients();
+    build_barriers();
+
+    m_compiled = true;
+}
+
+void RenderGraph::cull_passes()
+{
+    // Walk backwards from the outputs. A pass survives if it writes something a later surviving pass (or the outside world)
+    // still needs; a surviving pass then needs everything it reads, and anything it loads rather than overwrites.
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        needed[i] = m_resources[i].output;
+    }
+
+    for (auto pass = m_passes.rbegin(); pass != m_passes.rend(); ++pass)
+    {
+        pass->culled = !pass->sideEffects;
+        for (const auto& use : pass->uses)
+        {
+            if (use.write && needed[use.resource])
+            {
+                pass->culled = false;
+            }
+        }
+
+        if (pass->culled)
+        {
+            continue;
+        }
+
+        for (const auto& use : pass->uses)
+        {
+            if (use.write && use.loadOp != vk::AttachmentLoadOp::eLoad)
+            {
+                needed[use.resource] = false;
+            }
+        }
+        for (const auto& use : pass->uses)
+        {
+            if (!use.write || use.loadOp == vk::AttachmentLoadOp::eLoad)
+            {
+                needed[use.resource] = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::compute_lifetimes()
+{
+    for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+    {
+        const auto& pass = m_passes[passIndex];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        for (const auto& use : pass.uses)
+        {
+            auto& resource = m_resources[use.resource];
+            resource.firstPass = std::min(resource.firstPass, passIndex);
+            resource.lastPass = std::max(resource.lastPass, passIndex);
+            resource.usage |= access_info(use.access, use.loadOp).usage;
+            resource.queueMask |= 1u << static_cast<uint32_t>(resolve_queue(pass));
+        }
+    }
+}
+
+void RenderGraph::allocate_transients()
+{
+    std::vector<RGResource> transients;
+    for (RGResource i = 0; i < m_resources.size(); i++)
+    {
+        const auto& resource = m_resources[i];
+        if (!resource.imported && resource.firstPass != UINT32_MAX)
+        {
+            transients.push_back(i);
+        }
+    }
+
+    std::sort(transients.begin(), transients.end(), [this](RGResource a, RGResource b) {
+        return m_resources[a].firstPass < m_resources[b].firstPass;
+    });
+
+    for (RGResource handle : transients)
+    {
+        auto& resource = m_resources[handle];
+
+        vk::ImageCreateInfo imageInfo{};
+        imageInfo.imageType = vk::ImageType::e2D;
+        imageInfo.extent = vk::Extent3D(resource.desc.extent.width, resource.desc.extent.height, 1);
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = resource.desc.format;
+        imageInfo.tiling = vk::ImageTiling::eOptimal;
+        imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+        imageInfo.usage = resource.usage;
+        imageInfo.sharingMode = vk::SharingMode::eExclusive;
+        imageInfo.samples = vk::SampleCountFlagBits::e1;
+        resource.image = m_device.createImage(imageInfo);
+
+        vk::MemoryRequirements requirements = m_device.getImageMemoryRequirements(resource.image);
+
+        // Greedy interval packing: reuse the first slot whose previous occupant is dead before this image is first used. Memory
+        // handed between queues would need a semaphore per reuse, so only images that stay on one queue are packed together.
+        bool singleQueue = (resource.queueMask & (resource.queueMask - 1)) == 0;
+
+        for (uint32_t slotIndex = 0; slotIndex < m_aliasSlots.size() && singleQueue; slotIndex++)
+        {
+            auto& slot = m_aliasSlots[slotIndex];
+            const auto& previous = m_resources[slot.occupants.back()];
+
+            if (previous.lastPass < resource.firstPass && previous.queueMask == resource.queueMask &&
+                (slot.requirements.memoryTypeBits & requirements.memoryTypeBits) != 0)
+            {
+                slot.occupants.push_back(handle);
+                slot.requirements.size = std::max(slot.requirements.size, requirements.size);
+                slot.requirements.alignment = std::max(slot.requirements.alignment, requirements.alignment);
+                slot.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+                resource.aliasSlot = slotIndex;
+                break;
+            }
+        }
+
+        if (resource.aliasSlot == UINT32_MAX)
+        {
+            AliasSlot slot{};
+            slot.occupants.push_back(handle);
+            slot.requirements = requirements;
+            m_aliasSlots.push_back(slot);
+            resource.aliasSlot = static_cast<uint32_t>(m_aliasSlots.size() - 1);
+        }
+    }
+
+    for (auto& slot : m_aliasSlots)
+    {
+        VkMemoryRequirements requirements = slot.requirements;
+
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        if (vmaAllocateMemory(m_allocator, &requirements, &allocInfo, &slot.allocation, nullptr) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate render graph memory!");
+        }
+
+        for (RGResource handle : slot.occupants)
+        {
+            auto& resource = m_resources[handle];
+            vmaBindImageMemory(m_allocator, slot.allocation, resource.image);
+
+            vk::ImageViewCreateInfo viewInfo{};
+            viewInfo.image = resource.image;
+            viewInfo.viewType = vk::ImageViewType::e2D;
+            viewInfo.format = resource.desc.format;
+            // Passes render to and sample the depth of depth/stencil images, and a sampled view may only have one aspect
+            vk::ImageAspectFlags aspectMask = aspect_mask(resource.desc.format);
+            viewInfo.subresourceRange.aspectMask =
+                aspectMask & vk::ImageAspectFlagBits::eDepth ? vk::ImageAspectFlags(vk::ImageAspectFlagBits::eDepth) : aspectMask;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+            resource.view = m_device.createImageView(viewInfo);
+        }
+    }
+}
+
+void RenderGraph::build_barriers()
+{
+    std::vector<RGImageState> states(m_resources.size());
+    std::vector<bool> touched(m_resources.size(), false);
+
+    // Queue and batch of the first and latest access to each image, for ownership transfers
+    std::vector<RGQueue> firstQueues(m_resources.size(), RGQueue::Graphics);
+    std::vector<RGQueue> owners(m_resources.size(), RGQueue::Graphics);
+    std::vector<uint32_t> ownerBatches(m_resources.size(), 0);
+
+    // Where the discard barrier of each transient lives, so it can wait on the memory's previous occupant afterwards
+    std::vector<std::pair<size_t, size_t>> firstBarrier(m_resources.size(), { SIZE_MAX, SIZE_MAX });
+
+    for (size_t i = 0; i < m_resources.size(); i++)
+    {
+        states[i] = m_resources[i].imported ? m_resources[i].initialState : RGImageState{};
+    }
+
+    for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+    {
+        const auto& pass = m_passes[passIndex];
+        if (pass.culled)
+        {
+            continue;
+        }
+
+        RGQueue queue = resolve_queue(pass);
+        if (m_batches.empty() || m_batches.back().queue != queue)
+        {
+            Batch batch{};
+            batch.queue = queue;
+            batch.firstStep = static_cast<uint32_t>(m_steps.size());
+            m_batches.push_back(batch);
+        }
+        auto batchIndex = static_cast<uint32_t>(m_batches.size() - 1);
+        auto& batch = m_batches.back();
+
+        Step step{};
+        step.passIndex = passIndex;
+
+        for (const auto& use : pass.uses)
+        {
+            RGImageState dst = access_info(use.access, use.loadOp).state;
+            RGImageState& current = states[use.resource];
+            bool firstUse = !touched[use.resource];
+            touched[use.resource] = true;
+
+            if (firstUse)
+            {
+                // Imported images are owned by the queue that first uses them
+                firstQueues[use.resource] = queue;
+                owners[use.resource] = queue;
+            }
+
+            // Transients are discarded on first use; their previous contents never matter
+            if (firstUse && !m_resources[use.resource].imported)
+            {
+                current.layout = vk::ImageLayout::eUndefined;
+                firstBarrier[use.resource] = { m_steps.size(), step.barriers.size() };
+            }
+
+            if (owners[use.resource] != queue)
+            {
+                // Queue family ownership transfer. Both halves carry the same layout transition; the release is recorded at the
+                // end of the batch that last used the image and the acquire here, with the semaphore between them doing the waiting.
+                uint32_t srcFamily = queue_family(owners[use.resource]);
+                uint32_t dstFamily = queue_family(queue);
+
+                RGImageState released{ dst.layout, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
+                RGImageState acquired{ current.layout, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
+
+                uint32_t ownerBatch = ownerBatches[use.resource];
+                m_batches[ownerBatch].endBarriers.push_back({ use.resource, current, released, srcFamily, dstFamily });
+                step.barriers.push_back({ use.resource, acquired, dst, srcFamily, dstFamily });
+
+                if (std::find(batch.dependencies.begin(), batch.dependencies.end(), ownerBatch) == batch.dependencies.end())
+                {
+                    batch.dependencies.push_back(ownerBatch);
+                }
+
+                current = dst;
+            }
+            else if (firstUse || current.layout != dst.layout || has_write(current.access) || use.write)
+            {
+                step.barriers.push_back({ use.resource, current, dst });
+                current = dst;
+            }
+            else
+            {
+                // Read after read in the same layout - just widen the set of stages a later writer has to wait for
+                current.stage |= dst.stage;
+                current.access |= dst.access;
+            }
+
+            owners[use.resource] = queue;
+            ownerBatches[use.resource] = batchIndex;
+        }
+
+        m_steps.push_back(std::move(step));
+        batch.stepCount++;
+    }
+
+    // The first use of a transient has to wait for whatever last used its memory: the previous occupant of its alias slot, or
+    // for the first occupant, the last occupant in the previous frame. A previous use on another queue is ordered by the
+    // semaphores of that frame instead, and its stages may not even exist on this queue.
+    for (const auto& slot : m_aliasSlots)
+    {
+        for (size_t i = 0; i < slot.occupants.size(); i++)
+        {
+            RGResource handle = slot.occupants[i];
+            RGResource previous = slot.occupants[(i + slot.occupants.size() - 1) % slot.occupants.size()];
+
+            auto [stepIndex, barrierIndex] = firstBarrier[handle];
+            auto& src = m_steps[stepIndex].barriers[barrierIndex].src;
+            src.layout = vk::ImageLayout::eUndefined;
+
+            if (owners[previous] == firstQueues[handle])
+            {
+                src.stage = states[previous].stage;
+                src.access = states[previous].access & WRITE_ACCESS_MASK;
+            }
+            else
+            {
+                src.stage = vk::PipelineStageFlagBits2::eNone;
+                src.access = vk::AccessFlagBits2::eNone;
+            }
+        }
+    }
+
+    for (RGResource i = 0; i < m_resources.size(); i++)
+    {
+        const auto& resource = m_resources[i];
+        if (resource.imported && touched[i] && resource.finalState.layout != states[i].layout)
+        {
+            m_batches[ownerBatches[i]].endBarriers.push_back({ i, states[i], resource.finalState });
+        }
+    }
+}
+
+void RenderGraph::execute(vk::CommandBuffer cmd, vk::QueryPool timestampPool, vk::QueryPool statisticsPool) const
+{
+    if (m_batches.size() > 1)
+    {
+        throw std::runtime_error("Render graph spans several queues, record it batch by batch!");
+    }
+
+    for (uint32_t batch = 0; batch < m_batches.size(); batch++)
+    {
+        execute_batch(batch, cmd, timestampPool, statisticsPool);
+    }
+}
+
+auto RenderGraph::batch_count() const -> uint32_t
+{
+    return static_cast<uint32_t>(m_batches.size());
+}
+
+auto RenderGraph::batch_queue(uint32_t batch) const -> RGQueue
+{
+    return m_batches[batch].queue;
+}
+
+auto RenderGraph::batch_first_pass(uint32_t batch) const -> uint32_t
+{
+    return m_batches[batch].firstStep;
+}
+
+auto RenderGraph::batch_dependencies(uint32_t batch) const -> const std::vector<uint32_t>&
+{
+    return m_batches[batch].dependencies;
+}
+
+void RenderGraph::execute_batch(uint32_t batch, vk::CommandBuffer cmd, vk::QueryPool timestampPool, vk::QueryPool statisticsPool) const
+{
+    if (!m_compiled)
+    {
+        throw std::runtime_error("Render graph must be compiled before execution!");
+    }
+
+    const auto& info = m_batches[batch];
+    for (uint32_t step = info.firstStep; step < info.firstStep + info.stepCount; step++)
+    {
+        record_step(cmd, step, timestampPool, statisticsPool);
+    }
+
+    record_barriers(cmd, info.endBarriers);
+}
+
+void RenderGraph::record_step(vk::CommandBuffer cmd, uint32_t stepIndex, vk::QueryPool timestampPool, vk::QueryPool statisticsPool) const
+{
+    const auto& step = m_steps[stepIndex];
+    const auto& pass = m_passes[step.passIndex];
+
+    record_barriers(cmd, step.barriers);
+
+    // Both ends of a pass are written from the same command buffer, so the difference never mixes the clocks of two queues
+    if (timestampPool)
+    {
+        cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, timestampPool, stepIndex * 2);
+    }
+
+    RGPassContext context{};
+    context.cmd = cmd;
+    context.m_graph = this;
+
+    if (pass.graphics)
+    {
+        std::vector<vk::RenderingAttachmentInfo> colorAttachments;
+        vk::RenderingAttachmentInfo depthAttachment{};
+        vk::Extent2D renderExtent;
+
+        for (const auto& use : pass.uses)
+        {
+            if (use.access == RGAccess::ColorAttachment)
+            {
+                vk::RenderingAttachmentInfo attachment{};
+                attachment.imageView = view(use.resource);
+                attachment.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+                attachment.loadOp = use.loadOp;
+                attachment.storeOp = vk::AttachmentStoreOp::eStore;
+                attachment.clearValue = use.clearValue;
+                colorAttachments.push_back(attachment);
+                context.colorFormats.push_back(m_resources[use.resource].desc.format);
+            }
+            else if (use.access == RGAccess::DepthAttachment || use.access == RGAccess::DepthRead)
+            {
+                // A read only attachment keeps what an earlier pass wrote and has nothing to store
+                bool readOnly = use.access == RGAccess::DepthRead;
+                depthAttachment.imageView = view(use.resource);
+                depthAttachment.imageLayout = access_info(use.access, use.loadOp).state.layout;
+                depthAttachment.loadOp = readOnly ? vk::AttachmentLoadOp::eLoad : use.loadOp;
+                depthAttachment.storeOp = readOnly ? vk::AttachmentStoreOp::eNone : vk::AttachmentStoreOp::eStore;
+                depthAttachment.clearValue = use.clearValue;
+                context.depthFormat = m_resources[use.resource].desc.format;
+            }
+            else
+            {
+                continue;
+            }
+
+            renderExtent = extent(use.resource);
+        }
+
+        if (pass.renderExtent)
+        {
+            vk::Extent2D requested = pass.renderExtent();
+            renderExtent = vk::Extent2D(std::min(requested.width, renderExtent.width), std::min(requested.height, renderExtent.height));
+        }
+        context.renderExtent = renderExtent;
+
+        vk::RenderingInfo renderingInfo{};
+        renderingInfo.renderArea.offset = vk::Offset2D(0, 0);
+        renderingInfo.renderArea.extent = renderExtent;
+        renderingInfo.layerCount = 1;
+        renderingInfo.setColorAttachments(colorAttachments);
+        if (depthAttachment.imageView)
+        {
+            renderingInfo.setPDepthAttachment(&depthAttachment);
+        }
+        if (pass.secondaryCommandBuffers)
+        {
+            renderingInfo.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+        }
+
+        // Queries may not begin inside a render pass instance and end outside it, so the query brackets the whole instance
+        bool statistics = statisticsPool && pass.pipelineStatistics;
+        context.pipelineStatistics = statistics;
+        if (statistics)
+        {
+            cmd.beginQuery(statisticsPool, stepIndex, {});
+        }
+
+        cmd.beginRendering(renderingInfo);
+        pass.execute(context);
+        cmd.endRendering();
+
+        if (statistics)
+        {
+            cmd.endQuery(statisticsPool, stepIndex);
+        }
+    }
+    else
+    {
+        pass.execute(context);
+    }
+
+    if (timestampPool)
+    {
+        cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, timestampPool, stepIndex * 2 + 1);
+    }
+}
+
+void RenderGraph::record_barriers(vk::CommandBuffer cmd, const std::vector<Barrier>& barriers) const
+{
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+    imageBarriers.reserve(barriers.size());
+
+    for (const auto& barrier : barriers)
+    {
+        vk::ImageMemoryBarrier2 imageBarrier{};
+        imageBarrier.srcStageMask = barrier.src.stage;
+        imageBarrier.srcAccessMask = barrier.src.access & WRITE_ACCESS_MASK;
+        imageBarrier.dstStageMask = barrier.dst.stage;
+        imageBarrier.dstAccessMask = barrier.dst.access;
+        imageBarrier.oldLayout = barrier.src.layout;
+        imageBarrier.newLayout = barrier.dst.layout;
+        imageBarrier.srcQueueFamilyIndex = barrier.srcQueueFamily;
+        imageBarrier.dstQueueFamilyIndex = barrier.dstQueueFamily;
+        imageBarrier.image = image(barrier.resource);
+        imageBarrier.subresourceRange.aspectMask = aspect_mask(m_resources[barrier.resource].desc.format);
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarriers.push_back(imageBarrier);
+    }
+
+    vk::DependencyInfo dependencyInfo{};
+    dependencyInfo.setImageMemoryBarriers(imageBarriers);
+    cmd.pipelineBarrier2(dependencyInfo);
+}
+
+auto RenderGraph::resolve_queue(const Pass& pass) const -> RGQueue
+{
+    bool hasAsyncQueue = m_computeFamily != VK_QUEUE_FAMILY_IGNORED && m_computeFamily != m_graphicsFamily;
+    return pass.queue == RGQueue::AsyncCompute && hasAsyncQueue ? RGQueue::AsyncCompute : RGQueue::Graphics;
+}
+
+auto RenderGraph::queue_family(RGQueue queue) const -> uint32_t
+{
+    return queue == RGQueue::AsyncCompute ? m_computeFamily : m_graphicsFamily;
+}
+
+auto RenderGraph::image(RGResource resource) const -> vk::Image
+{
+    return m_resources[resource].image;
+}
+
+auto RenderGraph::view(RGResource resource) const -> vk::ImageView
+{
+    return m_resources[resource].view;
+}
+
+auto RenderGraph::extent(RGResource resource) const -> vk::Extent2D
+{
+    return m_resources[resource].desc.extent;
+}
+
+auto RenderGraph::executed_pass_names() const -> std::vector<std::string>
+{
+    std::vector<std::string> names;
+    for (const auto& step : m_steps)
+    {
+        names.push_back(m_passes[step.passIndex].name);
+    }
+    return names;
+}
+
+auto RenderGraph::barrier_count() const -> uint32_t
+{
+    size_t count = 0;
+    for (const auto& step : m_steps)
+    {
+        count += step.barriers.size();
+    }
+    for (const auto& batch : m_batches)
+    {
+        count += batch.endBarriers.size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+auto RenderGraph::aliased_image_count() const -> uint32_t
+{
+    uint32_t count = 0;
+    for (const auto& slot : m_aliasSlots)
+    {
+        count += static_cast<uint32_t>(slot.occupants.size() - 1);
+    }
+    return count;
+}
+
+void RenderGraph::destroy()
+{
+    for (auto& resource : m_resources)
+    {
+        if (resource.imported)
+        {
+            continue;
+        }
+
+        if (resource.view)
+        {
+            m_device.destroy(resource.view);
+        }
+        if (resource.image)
+        {
+            m_device.destroy(resource.image);
+        }
+        resource.view = nullptr;
+        resource.image = nullptr;
+    }
+
+    for (auto& slot : m_aliasSlots)
+    {
+        vmaFreeMemory(m_allocator, slot.allocation);
+    }
+    m_aliasSlots.clear();
+}
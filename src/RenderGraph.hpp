@@ -0,0 +1,287 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vma/vk_mem_alloc.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using RGResource = uint32_t;
+
+constexpr RGResource RG_INVALID_RESOURCE = UINT32_MAX;
+
+/* How a pass uses an image. Determines the layout, stages and access masks of the barriers, and the usage flags of transient images. */
+enum class RGAccess
+{
+    ColorAttachment,
+    DepthAttachment,
+    /* Depth tested but not written, e.g. the equal test of a pass after a depth pre-pass */
+    DepthRead,
+    SampledFragment,
+    SampledCompute,
+    StorageReadCompute,
+    StorageWriteCompute,
+};
+
+/* Queue a pass asks to run on. Compute passes fall back to the graphics queue when no separate compute family is set. */
+enum class RGQueue
+{
+    Graphics,
+    AsyncCompute,
+};
+
+struct RGImageDesc
+{
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent;
+};
+
+/* Synchronisation state of an imported image at the start of the graph, or the state it must be left in at the end */
+struct RGImageState
+{
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    vk::PipelineStageFlags2 stage = vk::PipelineStageFlagBits2::eNone;
+    vk::AccessFlags2 access = vk::AccessFlagBits2::eNone;
+};
+
+class RenderGraph;
+
+/* Handed to a pass' setup callback to declare the images it reads and writes */
+class RGPassBuilder
+{
+public:
+    void write_color(RGResource resource,
+                     vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eClear,
+                     const vk::ClearColorValue& clearValue = {});
+
+    void write_depth(RGResource resource, vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eClear, float clearDepth = 1.0f);
+
+    void read(RGResource resource, RGAccess access);
+    void write(RGResource resource, RGAccess access);
+
+    /* Keeps the pass even when nothing consumes its outputs */
+    void set_side_effects();
+
+    /* The pass records its draws into secondary command buffers and executes them from the callback */
+    void set_secondary_command_buffers();
+
+    /* Wraps the pass in a pipeline statistics query when execute() is given a statistics pool */
+    void set_pipeline_statistics();
+
+    /* Renders into the top left corner of the attachments, sized by the callback each time the pass is recorded */
+    void set_render_extent(std::function<vk::Extent2D()> renderExtent);
+
+private:
+    friend class RenderGraph;
+
+    RGPassBuilder(RenderGraph& graph, uint32_t passIndex);
+
+    RenderGraph& m_graph;
+    uint32_t m_passIndex;
+};
+
+/* Handed to a pass' execute callback */
+class RGPassContext
+{
+public:
+    vk::CommandBuffer cmd;
+
+    /* Attachment formats of a graphics pass, for the inheritance info of its secondary command buffers */
+    std::vector<vk::Format> colorFormats;
+    vk::Format depthFormat = vk::Format::eUndefined;
+
+    /* A pipeline statistics query is active around the pass, which secondaries have to declare they inherit */
+    bool pipelineStatistics = false;
+
+    /* Render area of a graphics pass, which starts at the origin */
+    vk::Extent2D renderExtent;
+
+    auto image(RGResource resource) const -> vk::Image;
+    auto view(RGResource resource) const -> vk::ImageView;
+    auto extent(RGResource resource) const -> vk::Extent2D;
+
+private:
+    friend class RenderGraph;
+
+    const RenderGraph* m_graph = nullptr;
+};
+
+/*
+ * Passes are added in submission order and declare the images they read and write. compile() turns that description into an
+ * execution plan once per configuration:
+ *  - passes that do not contribute to an output (or have side effects) are culled;
+ *  - transient images are created with the usage flags their accesses need, and images with disjoint lifetimes share memory;
+ *  - the minimal set of image barriers is computed and batched per pass.
+ * Graphics passes get dynamic rendering begun and ended around their execute callback from the declared attachments.
+ * Imported images (e.g. the swapchain image) are bound per frame with set_imported_image() before execute().
+ *
+ * With a separate compute queue family, async compute passes are split into their own batches. Consecutive passes on the same
+ * queue form one batch, which is recorded into its own command buffer with execute_batch() and submitted after the batches it
+ * depends on. Images changing queue get a release barrier at the end of one batch and the matching acquire in the next.
+ */
+class RenderGraph
+{
+public:
+    using SetupFn = std::function<void(RGPassBuilder&)>;
+    using ExecuteFn = std::function<void(const RGPassContext&)>;
+
+    RenderGraph(vk::Device device, VmaAllocator allocator);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    auto operator=(const RenderGraph&) -> RenderGraph& = delete;
+
+    auto create_image(const std::string& name, const RGImageDesc& desc) -> RGResource;
+    auto import_image(const std::string& name, const RGImageDesc& desc, const RGImageState& initialState, const RGImageState& finalState)
+        -> RGResource;
+
+    void set_imported_image(RGResource resource, vk::Image image, vk::ImageView view);
+
+    /* Marks an image whose contents are consumed outside the graph. Passes are only kept if they lead to an output. */
+    void mark_output(RGResource resource);
+
+    void add_graphics_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute);
+    void add_compute_pass(const std::string& name, const SetupFn& setup, ExecuteFn execute, RGQueue queue = RGQueue::Graphics);
+
+    /* Must be called before compile(). Async compute passes only get their own queue if the families differ. */
+    void set_queue_families(uint32_t graphicsFamily, uint32_t computeFamily);
+
+    void compile();
+
+    /* Records the whole plan into one command buffer. Only valid when every pass runs on the same queue (batch_count() == 1).
+     * With a timestamp pool, query 2i is written before and query 2i + 1 after the i-th executed pass. With a statistics pool,
+     * query i covers the i-th executed pass if it asked for pipeline statistics. */
+    void execute(vk::CommandBuffer cmd, vk::QueryPool timestampPool = {}, vk::QueryPool statisticsPool = {}) const;
+
+    auto batch_count() const -> uint32_t;
+    auto batch_queue(uint32_t batch) const -> RGQueue;
+
+    /* Index of the batch's first pass in executed_pass_names(). A batch runs its passes back to back. */
+    auto batch_first_pass(uint32_t batch) const -> uint32_t;
+
+    /* Earlier batches whose completion this batch has to wait for, e.g. through a semaphore */
+    auto batch_dependencies(uint32_t batch) const -> const std::vector<uint32_t>&;
+
+    /* Records one batch. Timestamp queries keep the numbering of execute(). */
+    void execute_batch(uint32_t batch, vk::CommandBuffer cmd, vk::QueryPool timestampPool = {}, vk::QueryPool statisticsPool = {}) const;
+
+    auto image(RGResource resource) const -> vk::Image;
+    auto view(RGResource resource) const -> vk::ImageView;
+    auto extent(RGResource resource) const -> vk::Extent2D;
+
+    auto executed_pass_names() const -> std::vector<std::string>;
+    auto barrier_count() const -> uint32_t;
+    auto aliased_image_count() const -> uint32_t;
+
+    /* Destroys transient images and their memory. Only call once the GPU is done with every frame recorded from this graph. */
+    void destroy();
+
+private:
+    friend class RGPassBuilder;
+
+    struct ResourceUse
+    {
+        RGResource resource;
+        RGAccess access;
+        bool write;
+        vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eDontCare;
+        vk::ClearValue clearValue;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        bool graphics = false;
+        RGQueue queue = RGQueue::Graphics;
+        bool sideEffects = false;
+        bool secondaryCommandBuffers = false;
+        bool pipelineStatistics = false;
+        bool culled = false;
+        std::vector<ResourceUse> uses;
+        std::function<vk::Extent2D()> renderExtent;
+        ExecuteFn execute;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        RGImageDesc desc;
+        bool imported = false;
+        bool output = false;
+        RGImageState initialState;
+        RGImageState finalState;
+
+        vk::ImageUsageFlags usage;
+        vk::Image image;
+        vk::ImageView view;
+
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        uint32_t aliasSlot = UINT32_MAX;
+
+        /* Bit per RGQueue the image is used on. Only images confined to the same single queue share memory. */
+        uint32_t queueMask = 0;
+    };
+
+    struct AliasSlot
+    {
+        std::vector<RGResource> occupants;
+        vk::MemoryRequirements requirements;
+        VmaAllocation allocation = nullptr;
+    };
+
+    struct Barrier
+    {
+        RGResource resource;
+        RGImageState src;
+        RGImageState dst;
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+    };
+
+    struct Step
+    {
+        uint32_t passIndex;
+        std::vector<Barrier> barriers;
+    };
+
+    struct Batch
+    {
+        RGQueue queue;
+        uint32_t firstStep;
+        uint32_t stepCount = 0;
+        std::vector<uint32_t> dependencies;
+
+        /* Queue releases and final state transitions, recorded after the last step */
+        std::vector<Barrier> endBarriers;
+    };
+
+    vk::Device m_device;
+    VmaAllocator m_allocator;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<AliasSlot> m_aliasSlots;
+
+    std::vector<Step> m_steps;
+    std::vector<Batch> m_batches;
+    bool m_compiled = false;
+
+    uint32_t m_graphicsFamily = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t m_computeFamily = VK_QUEUE_FAMILY_IGNORED;
+
+    void add_pass(const std::string& name, bool graphics, RGQueue queue, const SetupFn& setup, ExecuteFn execute);
+
+    /* The queue a pass actually runs on */
+    auto resolve_queue(const Pass& pass) const -> RGQueue;
+    auto queue_family(RGQueue queue) const -> uint32_t;
+
+    void cull_passes();
+    void compute_lifetimes();
+    void allocate_transients();
+    void build_barriers();
+
+    void record_step(vk::CommandBuffer cmd, uint32_t stepIndex, vk::QueryPool timestampPool, vk::QueryPool statisticsPool) const;
+    void record_barriers(vk::CommandBuffer cmd, const std::vector<Barrier>& barriers) const;
+};
@@ -0,0 +1,54 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "ResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /* Frames recorded before a change may still be completing after it, up to the deepest frames in flight setting */
+    constexpr uint32_t SETTLE_FRAMES = 8;
+
+    /* Weight of the newest frame in the running average */
+    constexpr double SMOOTHING = 0.2;
+
+    /* Below this fraction of the budget the scale is allowed to grow again */
+    constexpr double HEADROOM = 0.85;
+}
+
+auto ResolutionController::update(double gpuFrameMs) -> bool
+{
+    if (!enabled() || gpuFrameMs <= 0.0)
+    {
+        return false;
+    }
+
+    // Times of frames rendered at the previous scale say nothing about the new one, so the average starts over after them
+    if (m_framesSinceChange < SETTLE_FRAMES)
+    {
+        m_framesSinceChange++;
+        m_averageMs = 0.0;
+        return false;
+    }
+
+    m_averageMs = m_averageMs == 0.0 ? gpuFrameMs : m_averageMs + (gpuFrameMs - m_averageMs) * SMOOTHING;
+    if (m_averageMs <= m_budgetMs && m_averageMs >= m_budgetMs * HEADROOM)
+    {
+        return false;
+    }
+
+    // Rounding down keeps a shrinking scale within budget. Fixed costs do not shrink with it, which the next round corrects.
+    double ideal = m_scale * std::sqrt(m_budgetMs / m_averageMs);
+    float next = std::clamp(static_cast<float>(std::floor(ideal / SCALE_STEP)) * SCALE_STEP, MIN_SCALE, MAX_SCALE);
+    if (next == m_scale)
+    {
+        return false;
+    }
+
+    m_scale = next;
+    m_framesSinceChange = 0;
+    return true;
+}
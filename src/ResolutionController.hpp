@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Picks the fraction of the scene target's width and height to render at from measured GPU frame times. Shading cost follows the
+ * pixel count, so the scale moves by the square root of the budget over the smoothed frame time. It only moves when the budget is
+ * missed or there is clear headroom, and in fixed steps, so it settles instead of invalidating recorded commands every frame.
+ */
+class ResolutionController
+{
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+    static constexpr float SCALE_STEP = 1.0f / 32.0f;
+
+    /* A budget of 0 keeps the full resolution */
+    explicit ResolutionController(double budgetMs = 0.0) : m_budgetMs(budgetMs) {}
+
+    /* Feeds the GPU time of one completed frame. Returns true when the scale changed. */
+    auto update(double gpuFrameMs) -> bool;
+
+    auto enabled() const -> bool
+    {
+        return m_budgetMs > 0.0;
+    }
+
+    auto scale() const -> float
+    {
+        return m_scale;
+    }
+
+private:
+    double m_budgetMs;
+    double m_averageMs = 0.0;
+    float m_scale = MAX_SCALE;
+    uint32_t m_framesSinceChange = 0;
+};
@@ -0,0 +1,114 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "SamplerCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    template <typename T>
+    void hash_combine(size_t& seed, const T& value)
+    {
+        seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+}
+
+void SamplerCache::init(vk::Device device, const vk::PhysicalDeviceLimits& limits)
+{
+    m_device = device;
+    m_maxSamplerCount = limits.maxSamplerAllocationCount;
+    m_maxAnisotropy = limits.maxSamplerAnisotropy;
+}
+
+auto SamplerCache::get(const vk::SamplerCreateInfo& createInfo) -> vk::Sampler
+{
+    if (createInfo.pNext != nullptr)
+    {
+        throw std::runtime_error("Sampler cache does not support pNext chains!");
+    }
+
+    auto it = m_samplers.find(createInfo);
+    if (it != m_samplers.end())
+    {
+        return it->second;
+    }
+
+    if (m_samplers.size() >= m_maxSamplerCount)
+    {
+        throw std::runtime_error("Exceeded maxSamplerAllocationCount!");
+    }
+
+    vk::Sampler sampler = m_device.createSampler(createInfo);
+    m_samplers.emplace(createInfo, sampler);
+
+    return sampler;
+}
+
+void SamplerCache::destroy()
+{
+    for (const auto& [info, sampler] : m_samplers)
+    {
+        m_device.destroy(sampler);
+    }
+    m_samplers.clear();
+}
+
+auto SamplerCache::make_info(vk::Filter filter, vk::SamplerAddressMode addressMode, float maxAnisotropy, float maxLod) const
+    -> vk::SamplerCreateInfo
+{
+    maxAnisotropy = std::min(maxAnisotropy, m_maxAnisotropy);
+
+    vk::SamplerCreateInfo createInfo{};
+    createInfo.setMagFilter(filter);
+    createInfo.setMinFilter(filter);
+    createInfo.setAddressModeU(addressMode);
+    createInfo.setAddressModeV(addressMode);
+    createInfo.setAddressModeW(addressMode);
+    createInfo.setAnisotropyEnable(maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE);
+    createInfo.setMaxAnisotropy(maxAnisotropy > 1.0f ? maxAnisotropy : 1.0f);
+    createInfo.setBorderColor(vk::BorderColor::eIntOpaqueBlack);
+    createInfo.setUnnormalizedCoordinates(VK_FALSE);
+    createInfo.setCompareEnable(VK_FALSE);
+    createInfo.setCompareOp(vk::CompareOp::eAlways);
+    createInfo.setMipmapMode(filter == vk::Filter::eNearest ? vk::SamplerMipmapMode::eNearest : vk::SamplerMipmapMode::eLinear);
+    createInfo.setMipLodBias(0.0f);
+    createInfo.setMinLod(0.0f);
+    createInfo.setMaxLod(maxLod);
+
+    return createInfo;
+}
+
+auto SamplerCache::CreateInfoHash::operator()(const vk::SamplerCreateInfo& info) const -> size_t
+{
+    size_t seed = 0;
+    hash_combine(seed, static_cast<VkSamplerCreateFlags>(info.flags));
+    hash_combine(seed, static_cast<int>(info.magFilter));
+    hash_combine(seed, static_cast<int>(info.minFilter));
+    hash_combine(seed, static_cast<int>(info.mipmapMode));
+    hash_combine(seed, static_cast<int>(info.addressModeU));
+    hash_combine(seed, static_cast<int>(info.addressModeV));
+    hash_combine(seed, static_cast<int>(info.addressModeW));
+    hash_combine(seed, info.mipLodBias);
+    hash_combine(seed, info.anisotropyEnable);
+    hash_combine(seed, info.maxAnisotropy);
+    hash_combine(seed, info.compareEnable);
+    hash_combine(seed, static_cast<int>(info.compareOp));
+    hash_combine(seed, info.minLod);
+    hash_combine(seed, info.maxLod);
+    hash_combine(seed, static_cast<int>(info.borderColor));
+    hash_combine(seed, info.unnormalizedCoordinates);
+    return seed;
+}
+
+auto SamplerCache::CreateInfoEqual::operator()(const vk::SamplerCreateInfo& lhs, const vk::SamplerCreateInfo& rhs) const -> bool
+{
+    return lhs.flags == rhs.flags && lhs.magFilter == rhs.magFilter && lhs.minFilter == rhs.minFilter &&
+           lhs.mipmapMode == rhs.mipmapMode && lhs.addressModeU == rhs.addressModeU && lhs.addressModeV == rhs.addressModeV &&
+           lhs.addressModeW == rhs.addressModeW && lhs.mipLodBias == rhs.mipLodBias && lhs.anisotropyEnable == rhs.anisotropyEnable &&
+           lhs.maxAnisotropy == rhs.maxAnisotropy && lhs.compareEnable == rhs.compareEnable && lhs.compareOp == rhs.compareOp &&
+           lhs.minLod == rhs.minLod && lhs.maxLod == rhs.maxLod && lhs.borderColor == rhs.borderColor &&
+           lhs.unnormalizedCoordinates == rhs.unnormalizedCoordinates;
+}
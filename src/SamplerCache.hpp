@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <unordered_map>
+
+/*
+ * Deduplicates samplers by their create info. Passes and materials describe the sampler state they need and share a single
+ * vk::Sampler for identical state, which keeps us well inside maxSamplerAllocationCount.
+ */
+class SamplerCache
+{
+public:
+    void init(vk::Device device, const vk::PhysicalDeviceLimits& limits);
+
+    /* Returns the cached sampler for this state, creating it on first use. pNext chains are not supported. */
+    auto get(const vk::SamplerCreateInfo& createInfo) -> vk::Sampler;
+
+    void destroy();
+
+    /* Common sampler state. Anisotropy is enabled when maxAnisotropy > 1 and clamped to the device limit. */
+    auto make_info(vk::Filter filter, vk::SamplerAddressMode addressMode, float maxAnisotropy = 1.0f, float maxLod = 0.0f) const
+        -> vk::SamplerCreateInfo;
+
+private:
+    struct CreateInfoHash
+    {
+        auto operator()(const vk::SamplerCreateInfo& info) const -> size_t;
+    };
+
+    struct CreateInfoEqual
+    {
+        auto operator()(const vk::SamplerCreateInfo& lhs, const vk::SamplerCreateInfo& rhs) const -> bool;
+    };
+
+    vk::Device m_device;
+    uint32_t m_maxSamplerCount = 0;
+    float m_maxAnisotropy = 1.0f;
+
+    std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, CreateInfoHash, CreateInfoEqual> m_samplers;
+};
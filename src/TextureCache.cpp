@@ -0,0 +1,345 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "TextureCache.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    constexpr uint32_t CACHE_MAGIC = 0x58455448;  // "HTEX"
+    constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+        uint32_t reserved;
+        uint64_t payloadSize;
+        uint64_t padding;
+    };
+
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    auto fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) -> uint64_t
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    auto compute_key(const std::vector<uint8_t>& source, const TextureProcessParams& params) -> uint64_t
+    {
+        uint64_t hash = fnv1a(source.data(), source.size());
+
+        const std::array<uint32_t, 3> processing = { CACHE_VERSION, params.srgb ? 1u : 0u, params.generateMips ? 1u : 0u };
+        return fnv1a(processing.data(), sizeof(processing), hash);
+    }
+
+    auto read_file(const std::string& filename) -> std::vector<uint8_t>
+    {
+        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open texture file '" + filename + "'!");
+        }
+
+        size_t fileSize = file.tellg();
+        std::vector<uint8_t> buffer(fileSize);
+
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(fileSize));
+
+        return buffer;
+    }
+
+    auto mip_level_count(uint32_t width, uint32_t height) -> uint32_t
+    {
+        uint32_t levels = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            levels++;
+        }
+        return levels;
+    }
+
+    /* Fills in mip offsets for tightly packed RGBA8 levels and returns the total payload size */
+    auto compute_mip_offsets(uint32_t width, uint32_t height, uint32_t mipLevels, std::vector<size_t>& offsets) -> size_t
+    {
+        offsets.resize(mipLevels);
+
+        size_t offset = 0;
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            offsets[level] = offset;
+            offset += static_cast<size_t>(width) * height * 4;
+
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        return offset;
+    }
+
+    auto srgb_to_linear_table() -> const std::array<float, 256>&
+    {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> values{};
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                float c = static_cast<float>(i) / 255.0f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    auto linear_to_srgb(float c) -> uint8_t
+    {
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+    }
+
+    /* 2x2 box filter. sRGB colour channels are averaged in linear space, alpha is always linear. */
+    void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, bool srgb)
+    {
+        const auto& toLinear = srgb_to_linear_table();
+
+        uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+        uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+
+        for (uint32_t y = 0; y < dstHeight; y++)
+        {
+            uint32_t y0 = std::min(y * 2, srcHeight - 1);
+            uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+            for (uint32_t x = 0; x < dstWidth; x++)
+            {
+                uint32_t x0 = std::min(x * 2, srcWidth - 1);
+                uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+                const std::array<const uint8_t*, 4> texels = {
+                    src + (static_cast<size_t>(y0) * srcWidth + x0) * 4,
+                    src + (static_cast<size_t>(y0) * srcWidth + x1) * 4,
+                    src + (static_cast<size_t>(y1) * srcWidth + x0) * 4,
+                    src + (static_cast<size_t>(y1) * srcWidth + x1) * 4,
+                };
+
+                uint8_t* out = dst + (static_cast<size_t>(y) * dstWidth + x) * 4;
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    if (srgb && c < 3)
+                    {
+                        float sum = 0.0f;
+                        for (const auto* texel : texels)
+                        {
+                            sum += toLinear[texel[c]];
+                        }
+                        out[c] = linear_to_srgb(sum * 0.25f);
+                    }
+                    else
+                    {
+                        uint32_t sum = 0;
+                        for (const auto* texel : texels)
+                        {
+                            sum += texel[c];
+                        }
+                        out[c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    auto to_hex(uint64_t value) -> std::string
+    {
+        static const char* digits = "0123456789abcdef";
+
+        std::string hex(16, '0');
+        for (int i = 15; i >= 0; i--)
+        {
+            hex[i] = digits[value & 0xF];
+            value >>= 4;
+        }
+        return hex;
+    }
+
+    /* Turns a source path into something usable as a flat file name prefix */
+    auto sanitize(const std::string& filename) -> std::string
+    {
+        std::string name = filename;
+        for (char& c : name)
+        {
+            if (c == '/' || c == '\\' || c == '.' || c == ':')
+            {
+                c = '_';
+            }
+        }
+        return name;
+    }
+}
+
+TextureCache::TextureCache(std::string directory) : m_directory(std::move(directory)) {}
+
+auto TextureCache::load(const std::string& filename, const TextureProcessParams& params) -> TextureData
+{
+    std::vector<uint8_t> source = read_file(filename);
+    uint64_t key = compute_key(source, params);
+    std::string path = entry_path(filename, key);
+
+    TextureData texture{};
+
+    /* Warm start - map the cached payload directly */
+    MappedFile mapping(path);
+    if (mapping.is_open() && mapping.size() >= sizeof(CacheHeader))
+    {
+        CacheHeader header{};
+        memcpy(&header, mapping.data(), sizeof(header));
+
+        if (header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.key == key && header.mipLevels > 0)
+        {
+            size_t expectedSize = compute_mip_offsets(header.width, header.height, header.mipLevels, texture.mipOffsets);
+
+            if (header.payloadSize == expectedSize && mapping.size() >= sizeof(CacheHeader) + expectedSize)
+            {
+                texture.width = header.width;
+                texture.height = header.height;
+                texture.mipLevels = header.mipLevels;
+                texture.pixels = mapping.data() + sizeof(CacheHeader);
+                texture.size = expectedSize;
+                texture.fromCache = true;
+                texture.mapping = std::move(mapping);
+                return texture;
+            }
+        }
+    }
+    mapping.close();
+
+    /* Cold start - decode, process and write the cache entry */
+    int texWidth{};
+    int texHeight{};
+    int texChannels{};
+    stbi_uc* pixels = stbi_load_from_memory(
+        source.data(), static_cast<int>(source.size()), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+    if (!pixels)
+    {
+        throw std::runtime_error("Failed to load texture image!");
+    }
+
+    texture.width = static_cast<uint32_t>(texWidth);
+    texture.height = static_cast<uint32_t>(texHeight);
+    texture.mipLevels = params.generateMips ? mip_level_count(texture.width, texture.height) : 1;
+    texture.size = compute_mip_offsets(texture.width, texture.height, texture.mipLevels, texture.mipOffsets);
+
+    texture.storage.resize(texture.size);
+    memcpy(texture.storage.data(), pixels, static_cast<size_t>(texture.width) * texture.height * 4);
+    stbi_image_free(pixels);
+
+    uint32_t mipWidth = texture.width;
+    uint32_t mipHeight = texture.height;
+    for (uint32_t level = 1; level < texture.mipLevels; level++)
+    {
+        downsample(texture.storage.data() + texture.mipOffsets[level - 1],
+                   mipWidth,
+                   mipHeight,
+                   texture.storage.data() + texture.mipOffsets[level],
+                   params.srgb);
+
+        mipWidth = std::max(mipWidth / 2, 1u);
+        mipHeight = std::max(mipHeight / 2, 1u);
+    }
+
+    texture.pixels = texture.storage.data();
+
+    try
+    {
+        write_entry(path, key, texture);
+        remove_stale_entries(filename, path);
+    }
+    catch (const std::exception& e)
+    {
+        // A broken cache only costs us the next warm start
+        std::cerr << "Failed to write texture cache entry '" << path << "': " << e.what() << std::endl;
+    }
+
+    return texture;
+}
+
+auto TextureCache::entry_path(const std::string& filename, uint64_t key) const -> std::string
+{
+    return m_directory + "/" + sanitize(filename) + "-" + to_hex(key) + ".tex";
+}
+
+void TextureCache::write_entry(const std::string& path, uint64_t key, const TextureData& texture) const
+{
+    std::filesystem::create_directories(m_directory);
+
+    CacheHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.key = key;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.mipLevels = texture.mipLevels;
+    header.payloadSize = texture.size;
+
+    // Write to a temporary and rename so a crash mid-write never leaves a truncated entry behind
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Failed to open cache file for writing!");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(texture.pixels), static_cast<std::streamsize>(texture.size));
+
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write cache file!");
+        }
+    }
+
+    std::filesystem::rename(tempPath, path);
+}
+
+void TextureCache::remove_stale_entries(const std::string& filename, const std::string& keepPath) const
+{
+    std::string prefix = sanitize(filename) + "-";
+
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind(prefix, 0) == 0 && name.size() == prefix.size() + 20 && entry.path() != std::filesystem::path(keepPath))
+        {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
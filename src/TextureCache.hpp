@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Processing applied to a source image before it is stored. Part of the cache key, so changing any field produces a new entry. */
+struct TextureProcessParams
+{
+    bool srgb = true;
+    bool generateMips = true;
+};
+
+/* Decoded RGBA8 texture payload. Mip levels are tightly packed one after another, largest first. */
+struct TextureData
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipLevels = 1;
+    std::vector<size_t> mipOffsets;
+
+    const uint8_t* pixels = nullptr;
+    size_t size = 0;
+
+    /* True if the payload came straight out of the on-disk cache without decoding */
+    bool fromCache = false;
+
+    /* Backing storage - exactly one of these is populated */
+    MappedFile mapping;
+    std::vector<uint8_t> storage;
+};
+
+/*
+ * On-disk cache of decoded texture payloads keyed by the content hash of the source file plus the processing parameters.
+ * Warm loads memory map the cache entry and skip decoding entirely. Entries are invalidated automatically because a changed
+ * source file hashes to a different key; stale entries for the same source are removed when the new one is written.
+ */
+class TextureCache
+{
+public:
+    explicit TextureCache(std::string directory);
+
+    auto load(const std::string& filename, const TextureProcessParams& params) -> TextureData;
+
+private:
+    std::string m_directory;
+
+    auto entry_path(const std::string& filename, uint64_t key) const -> std::string;
+
+    void write_entry(const std::string& path, uint64_t key, const TextureData& texture) const;
+
+    void remove_stale_entries(const std::string& filename, const std::string& keepPath) const;
+};
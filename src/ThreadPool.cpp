@@ -0,0 +1,112 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(uint32_t taskCount, const TaskFn& fn)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+
+    if (m_workers.empty() || taskCount == 1)
+    {
+        for (uint32_t i = 0; i < taskCount; i++)
+        {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_task = &fn;
+        m_taskCount = taskCount;
+        m_nextTask = 0;
+        m_activeWorkers = static_cast<uint32_t>(m_workers.size());
+        m_exception = nullptr;
+        m_generation++;
+    }
+    m_workAvailable.notify_all();
+
+    run_tasks(0);
+
+    std::unique_lock lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_activeWorkers == 0; });
+    m_task = nullptr;
+
+    if (m_exception)
+    {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+void ThreadPool::worker_loop(uint32_t threadIndex)
+{
+    uint64_t seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_workAvailable.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+
+            if (m_stopping)
+            {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        run_tasks(threadIndex);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_activeWorkers--;
+        }
+        m_workDone.notify_one();
+    }
+}
+
+void ThreadPool::run_tasks(uint32_t threadIndex)
+{
+    for (uint32_t task = m_nextTask++; task < m_taskCount; task = m_nextTask++)
+    {
+        try
+        {
+            (*m_task)(task, threadIndex);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_exception)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+}
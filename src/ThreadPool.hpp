@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads for fork/join work within a frame. The calling thread takes part in every parallel_for() as thread
+ * index 0, so a pool of N threads owns N - 1 workers and a single threaded pool runs everything inline.
+ */
+class ThreadPool
+{
+public:
+    using TaskFn = std::function<void(uint32_t taskIndex, uint32_t threadIndex)>;
+
+    explicit ThreadPool(uint32_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+    auto thread_count() const -> uint32_t
+    {
+        return static_cast<uint32_t>(m_workers.size() + 1);
+    }
+
+    /* Runs fn for every task index in [0, taskCount) and blocks until all have finished. Rethrows the first exception thrown by a
+     * task once the rest have completed. */
+    void parallel_for(uint32_t taskCount, const TaskFn& fn);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_workDone;
+
+    /* Bumped for every parallel_for so sleeping workers can tell a new batch from a spurious wake up */
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+
+    const TaskFn* m_task = nullptr;
+    uint32_t m_taskCount = 0;
+    std::atomic<uint32_t> m_nextTask{ 0 };
+    uint32_t m_activeWorkers = 0;
+    std::exception_ptr m_exception;
+
+    void worker_loop(uint32_t threadIndex);
+
+    /* Pulls task indices until the batch is exhausted */
+    void run_tasks(uint32_t threadIndex);
+};
@@ -0,0 +1,223 @@
+//
+// Created by stuart on 19/10/2026.
+//
+
+#include "VertexFormat.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    auto position_size(PositionFormat format) -> uint32_t
+    {
+        return format == PositionFormat::Float3 ? 12 : 8;
+    }
+
+    auto color_size(ColorFormat format) -> uint32_t
+    {
+        return format == ColorFormat::Float3 ? 12 : 4;
+    }
+
+    auto tex_coord_size(TexCoordFormat format) -> uint32_t
+    {
+        return format == TexCoordFormat::Float2 ? 8 : 4;
+    }
+
+    auto max_component(const glm::vec3& v) -> float
+    {
+        return std::max(v.x, std::max(v.y, v.z));
+    }
+
+    template <typename T>
+    void write(uint8_t* destination, const T& value)
+    {
+        std::memcpy(destination, &value, sizeof(T));
+    }
+
+    /* Encodes at destination and returns what the GPU will decode */
+    auto encode_position(PositionFormat format, const glm::vec3& position, uint8_t* destination) -> glm::vec3
+    {
+        switch (format)
+        {
+            case PositionFormat::Float3:
+                write(destination, position);
+                return position;
+            case PositionFormat::Half4:
+            {
+                glm::uint64 packed = glm::packHalf4x16(glm::vec4(position, 1.0f));
+                write(destination, packed);
+                return glm::vec3(glm::unpackHalf4x16(packed));
+            }
+            case PositionFormat::Snorm16x4:
+            {
+                glm::u16vec4 packed(glm::packSnorm1x16(position.x), glm::packSnorm1x16(position.y), glm::packSnorm1x16(position.z), 0);
+                write(destination, packed);
+                return glm::vec3(glm::unpackSnorm1x16(packed.x), glm::unpackSnorm1x16(packed.y), glm::unpackSnorm1x16(packed.z));
+            }
+        }
+        return position;
+    }
+
+    auto encode_color(ColorFormat format, const glm::vec3& color, uint8_t* destination) -> glm::vec3
+    {
+        if (format == ColorFormat::Float3)
+        {
+            write(destination, color);
+            return color;
+        }
+
+        uint32_t packed = glm::packUnorm4x8(glm::vec4(color, 1.0f));
+        write(destination, packed);
+        return glm::vec3(glm::unpackUnorm4x8(packed));
+    }
+
+    auto encode_tex_coord(TexCoordFormat format, const glm::vec2& texCoord, uint8_t* destination) -> glm::vec2
+    {
+        switch (format)
+        {
+            case TexCoordFormat::Float2:
+                write(destination, texCoord);
+                return texCoord;
+            case TexCoordFormat::Half2:
+            {
+                uint32_t packed = glm::packHalf2x16(texCoord);
+                write(destination, packed);
+                return glm::unpackHalf2x16(packed);
+            }
+            case TexCoordFormat::Unorm16x2:
+            {
+                uint32_t packed = glm::packUnorm2x16(texCoord);
+                write(destination, packed);
+                return glm::unpackUnorm2x16(packed);
+            }
+        }
+        return texCoord;
+    }
+}
+
+auto VertexLayout::stride() const -> uint32_t
+{
+    return position_size(position) + color_size(color) + tex_coord_size(texCoord);
+}
+
+auto VertexLayout::binding_description(uint32_t binding) const -> vk::VertexInputBindingDescription
+{
+    vk::VertexInputBindingDescription bindingDesc{};
+    bindingDesc.binding = binding;
+    bindingDesc.stride = stride();
+    bindingDesc.inputRate = vk::VertexInputRate::eVertex;
+
+    return bindingDesc;
+}
+
+auto VertexLayout::attribute_descriptions(uint32_t binding) const -> std::array<vk::VertexInputAttributeDescription, 3>
+{
+    std::array<vk::VertexInputAttributeDescription, 3> attribDescriptions{};
+
+    attribDescriptions[0].binding = binding;
+    attribDescriptions[0].location = 0;
+    attribDescriptions[0].offset = 0;
+    switch (position)
+    {
+        case PositionFormat::Float3: attribDescriptions[0].format = vk::Format::eR32G32B32Sfloat; break;
+        case PositionFormat::Half4: attribDescriptions[0].format = vk::Format::eR16G16B16A16Sfloat; break;
+        case PositionFormat::Snorm16x4: attribDescriptions[0].format = vk::Format::eR16G16B16A16Snorm; break;
+    }
+
+    attribDescriptions[1].binding = binding;
+    attribDescriptions[1].location = 1;
+    attribDescriptions[1].offset = position_size(position);
+    attribDescriptions[1].format = color == ColorFormat::Float3 ? vk::Format::eR32G32B32Sfloat : vk::Format::eR8G8B8A8Unorm;
+
+    attribDescriptions[2].binding = binding;
+    attribDescriptions[2].location = 2;
+    attribDescriptions[2].offset = position_size(position) + color_size(color);
+    switch (texCoord)
+    {
+        case TexCoordFormat::Float2: attribDescriptions[2].format = vk::Format::eR32G32Sfloat; break;
+        case TexCoordFormat::Half2: attribDescriptions[2].format = vk::Format::eR16G16Sfloat; break;
+        case TexCoordFormat::Unorm16x2: attribDescriptions[2].format = vk::Format::eR16G16Unorm; break;
+    }
+
+    return attribDescriptions;
+}
+
+auto VertexLayout::name() const -> std::string
+{
+    std::string positionName = position == PositionFormat::Float3 ? "float3" : position == PositionFormat::Half4 ? "half4" : "snorm16x4";
+    std::string colorName = color == ColorFormat::Float3 ? "float3" : "unorm8x4";
+    std::string texCoordName = texCoord == TexCoordFormat::Float2 ? "float2" : texCoord == TexCoordFormat::Half2 ? "half2" : "unorm16x2";
+    return positionName + " / " + colorName + " / " + texCoordName;
+}
+
+VertexEncoder::VertexEncoder(const VertexLayout& layout, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+    : m_layout(layout),
+      m_colorOffset(position_size(layout.position)),
+      m_texCoordOffset(position_size(layout.position) + color_size(layout.color))
+{
+    m_report.meshExtent = max_component(glm::max(boundsMax - boundsMin, glm::vec3(0.0f)));
+
+    // Normalised positions map the bounding box onto -1 to 1. Flat axes keep a scale of 1, anything else would divide by zero.
+    if (layout.position == PositionFormat::Snorm16x4)
+    {
+        glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+        m_positionOffset = (boundsMin + boundsMax) * 0.5f;
+        m_positionScale = glm::vec3(halfExtent.x > 0.0f ? halfExtent.x : 1.0f,
+                                    halfExtent.y > 0.0f ? halfExtent.y : 1.0f,
+                                    halfExtent.z > 0.0f ? halfExtent.z : 1.0f);
+    }
+}
+
+void VertexEncoder::encode(const Vertex& vertex, uint8_t* destination)
+{
+    glm::vec3 normalized = (vertex.pos - m_positionOffset) / m_positionScale;
+    glm::vec3 position = encode_position(m_layout.position, normalized, destination) * m_positionScale + m_positionOffset;
+    glm::vec3 color = encode_color(m_layout.color, vertex.color, destination + m_colorOffset);
+    glm::vec2 texCoord = encode_tex_coord(m_layout.texCoord, vertex.texCoord, destination + m_texCoordOffset);
+
+    m_report.vertexCount++;
+    m_report.sourceBytes += sizeof(Vertex);
+    m_report.quantizedBytes += m_layout.stride();
+
+    m_report.maxPositionError = std::max(m_report.maxPositionError, glm::length(position - vertex.pos));
+    m_report.maxColorError = std::max(m_report.maxColorError, max_component(glm::abs(color - vertex.color)));
+    m_report.maxTexCoordError = std::max(m_report.maxTexCoordError, std::max(std::abs(texCoord.x - vertex.texCoord.x),
+                                                                             std::abs(texCoord.y - vertex.texCoord.y)));
+}
+
+auto quantize_vertices(const std::vector<Vertex>& vertices, const VertexLayout& layout) -> QuantizedVertices
+{
+    glm::vec3 minPos(0.0f);
+    glm::vec3 maxPos(0.0f);
+    if (!vertices.empty())
+    {
+        minPos = glm::vec3(std::numeric_limits<float>::max());
+        maxPos = glm::vec3(std::numeric_limits<float>::lowest());
+        for (const Vertex& vertex : vertices)
+        {
+            minPos = glm::min(minPos, vertex.pos);
+            maxPos = glm::max(maxPos, vertex.pos);
+        }
+    }
+
+    VertexEncoder encoder(layout, minPos, maxPos);
+    uint32_t stride = layout.stride();
+
+    QuantizedVertices result;
+    result.layout = layout;
+    result.data.resize(static_cast<size_t>(stride) * vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        encoder.encode(vertices[i], result.data.data() + i * stride);
+    }
+
+    result.positionScale = encoder.position_scale();
+    result.positionOffset = encoder.position_offset();
+    result.report = encoder.report();
+
+    return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Full precision vertex, as the scene geometry is generated */
+struct Vertex
+{
+    glm::vec3 pos;
+    glm::vec3 color;
+    glm::vec2 texCoord;
+};
+
+/* Four component formats stand in for three component ones, which vertex fetch does not have to support */
+enum class PositionFormat
+{
+    Float3,
+    Half4,
+    /* Normalised to the mesh bounds, decoded with the scale and offset of QuantizedVertices */
+    Snorm16x4,
+};
+
+enum class ColorFormat
+{
+    Float3,
+    Unorm8x4,
+};
+
+enum class TexCoordFormat
+{
+    Float2,
+    Half2,
+    /* Coordinates outside 0 to 1 are clamped */
+    Unorm16x2,
+};
+
+/* How the attributes are stored in the vertex buffer, packed in order: position, colour, texture coordinates */
+struct VertexLayout
+{
+    PositionFormat position = PositionFormat::Float3;
+    ColorFormat color = ColorFormat::Float3;
+    TexCoordFormat texCoord = TexCoordFormat::Float2;
+
+    auto stride() const -> uint32_t;
+
+    auto binding_description(uint32_t binding) const -> vk::VertexInputBindingDescription;
+
+    /* Locations 0 to 2, read by the shaders as vec3 position, vec3 colour and vec2 texture coordinates whatever the format */
+    auto attribute_descriptions(uint32_t binding) const -> std::array<vk::VertexInputAttributeDescription, 3>;
+
+    /* e.g. "snorm16x4 / unorm8x4 / unorm16x2" */
+    auto name() const -> std::string;
+};
+
+/* Largest differences between the source vertices and what the GPU decodes from the quantized ones */
+struct QuantizationReport
+{
+    uint32_t vertexCount = 0;
+    size_t sourceBytes = 0;
+    size_t quantizedBytes = 0;
+
+    float maxPositionError = 0.0f;
+    /* Largest side of the mesh bounding box, to put the position error in proportion */
+    float meshExtent = 0.0f;
+    float maxColorError = 0.0f;
+    float maxTexCoordError = 0.0f;
+};
+
+struct QuantizedVertices
+{
+    VertexLayout layout;
+    std::vector<uint8_t> data;
+
+    /* Decoded positions are multiplied by the scale and then offset, which is the identity unless the positions are normalised */
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+
+    QuantizationReport report;
+};
+
+/* Encodes vertices one at a time, for callers that stream them straight into mapped memory. Normalised positions are fitted to
+ * bounds given up front, which every encoded position must lie within. */
+class VertexEncoder
+{
+public:
+    VertexEncoder(const VertexLayout& layout, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    /* Writes layout().stride() bytes at destination and accounts the vertex in the report */
+    void encode(const Vertex& vertex, uint8_t* destination);
+
+    auto layout() const -> const VertexLayout&
+    {
+        return m_layout;
+    }
+
+    auto position_scale() const -> const glm::vec3&
+    {
+        return m_positionScale;
+    }
+
+    auto position_offset() const -> const glm::vec3&
+    {
+        return m_positionOffset;
+    }
+
+    auto report() const -> const QuantizationReport&
+    {
+        return m_report;
+    }
+
+private:
+    VertexLayout m_layout;
+    uint32_t m_colorOffset = 0;
+    uint32_t m_texCoordOffset = 0;
+
+    glm::vec3 m_positionScale = glm::vec3(1.0f);
+    glm::vec3 m_positionOffset = glm::vec3(0.0f);
+
+    QuantizationReport m_report;
+};
+
+auto quantize_vertices(const std::vector<Vertex>& vertices, const VertexLayout& layout) -> QuantizedVertices;